@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "appdatastorage.h"
+#include "loggingcategories.h"
+
+#include <QSettings>
+
+NYMEA_LOGGING_CATEGORY(dcAppData, "AppData")
+
+namespace nymeaserver {
+
+AppDataStorage::AppDataStorage(const QString &storagePath, QObject *parent):
+    QObject(parent),
+    m_storagePath(storagePath)
+{
+    // Clients tend to store many values in a row (e.g. syncing a dashboard layout).
+    // Collect them and write each touched group file only once.
+    m_syncTimer.setSingleShot(true);
+    m_syncTimer.setInterval(1000);
+    connect(&m_syncTimer, &QTimer::timeout, this, &AppDataStorage::sync);
+}
+
+AppDataStorage::~AppDataStorage()
+{
+    sync();
+}
+
+QVariant AppDataStorage::value(const QString &appId, const QString &group, const QString &key)
+{
+    return loadGroup(appId, group).value(key);
+}
+
+QVariantMap AppDataStorage::values(const QString &appId, const QString &group)
+{
+    return loadGroup(appId, group);
+}
+
+void AppDataStorage::setValue(const QString &appId, const QString &group, const QString &key, const QVariant &value)
+{
+    QVariantMap &groupValues = loadGroup(appId, group);
+    groupValues.insert(key, value);
+    m_dirtyKeys[groupFileName(appId, group)].insert(key);
+
+    if (!m_syncTimer.isActive()) {
+        m_syncTimer.start();
+    }
+
+    emit valueChanged(appId, group, key, value);
+}
+
+void AppDataStorage::setValues(const QString &appId, const QString &group, const QVariantMap &values)
+{
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        setValue(appId, group, it.key(), it.value());
+    }
+}
+
+void AppDataStorage::sync()
+{
+    m_syncTimer.stop();
+
+    for (auto it = m_dirtyKeys.constBegin(); it != m_dirtyKeys.constEnd(); ++it) {
+        const QVariantMap &groupValues = m_groups.value(it.key());
+        QSettings settings(it.key(), QSettings::IniFormat);
+        foreach (const QString &key, it.value()) {
+            settings.setValue(key, groupValues.value(key));
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qCWarning(dcAppData()) << "Error writing app data to" << it.key() << settings.status();
+        }
+        qCDebug(dcAppData()) << "Stored" << it.value().count() << "values to" << it.key();
+    }
+    m_dirtyKeys.clear();
+}
+
+QString AppDataStorage::groupFileName(const QString &appId, const QString &group) const
+{
+    // Note: we're using a different file for each group as QSettings tends to get slow with loads of keys.
+    return m_storagePath + "/appdata/" + appId + '/' + group + ".conf";
+}
+
+QVariantMap &AppDataStorage::loadGroup(const QString &appId, const QString &group)
+{
+    QString fileName = groupFileName(appId, group);
+    auto it = m_groups.find(fileName);
+    if (it != m_groups.end()) {
+        return it.value();
+    }
+
+    QVariantMap groupValues;
+    QSettings settings(fileName, QSettings::IniFormat);
+    foreach (const QString &key, settings.allKeys()) {
+        groupValues.insert(key, settings.value(key));
+    }
+    qCDebug(dcAppData()) << "Loaded" << groupValues.count() << "values from" << fileName;
+    return m_groups.insert(fileName, groupValues).value();
+}
+
+}
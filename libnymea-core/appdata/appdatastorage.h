@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef APPDATASTORAGE_H
+#define APPDATASTORAGE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVariantMap>
+
+namespace nymeaserver {
+
+class AppDataStorage : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppDataStorage(const QString &storagePath, QObject *parent = nullptr);
+    ~AppDataStorage() override;
+
+    QVariant value(const QString &appId, const QString &group, const QString &key);
+    QVariantMap values(const QString &appId, const QString &group);
+
+    void setValue(const QString &appId, const QString &group, const QString &key, const QVariant &value);
+    void setValues(const QString &appId, const QString &group, const QVariantMap &values);
+
+    // Writes all pending changes to disk immediately
+    void sync();
+
+signals:
+    void valueChanged(const QString &appId, const QString &group, const QString &key, const QVariant &value);
+
+private:
+    QString groupFileName(const QString &appId, const QString &group) const;
+    QVariantMap &loadGroup(const QString &appId, const QString &group);
+
+private:
+    QString m_storagePath;
+
+    // Cached group contents and pending changes, keyed by the group file name
+    QHash<QString, QVariantMap> m_groups;
+    QHash<QString, QSet<QString>> m_dirtyKeys;
+
+    QTimer m_syncTimer;
+};
+
+}
+
+#endif // APPDATASTORAGE_H
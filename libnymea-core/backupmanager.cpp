@@ -24,6 +24,7 @@
 
 #include "backupmanager.h"
 #include "loggingcategories.h"
+#include "nymeasettings.h"
 #include "version.h"
 
 #include <QDateTime>
@@ -242,6 +243,9 @@ BackupFiles BackupManager::backupFiles(const QString &destinationDir, const QStr
 bool BackupManager::createBackup(const QString &sourceDir, const QString &destinationDir, int maxBackups, const QString &archivePrefix, QString *archivePath)
 {
     qCInfo(dcBackup()) << "Creating a backup from" << sourceDir;
+    // Include changes which haven't been written to the settings files yet
+    NymeaSettings::syncAll();
+
     QFileInfo srcInfo(sourceDir);
     if (!srcInfo.exists() || !srcInfo.isDir()) {
         qCWarning(dcBackup()) << "Source directory doesn't exist or isn't a directory:" << sourceDir;
@@ -23,6 +23,7 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "debugreportgenerator.h"
+#include "tararchivewriter.h"
 #include "loggingcategories.h"
 #include "nymeasettings.h"
 #include "nymeacore.h"
@@ -34,28 +35,39 @@
 #include <QTimer>
 #include <QDateTime>
 #include <QSysInfo>
+#include <QTextStream>
 #include <QStandardPaths>
 #include <QCoreApplication>
-#include <QCryptographicHash>
 #include <QProcessEnvironment>
 #include <QHostInfo>
+#include <QtConcurrent/QtConcurrentRun>
 
 namespace nymeaserver {
 
-DebugReportGenerator::DebugReportGenerator(QObject *parent) : QObject(parent)
+DebugReportGenerator::DebugReportGenerator(QObject *parent) :
+    QObject(parent),
+    m_progress(0)
 {
-
+    connect(&m_archiveWatcher, &QFutureWatcher<bool>::finished, this, &DebugReportGenerator::onArchiveFinished);
 }
 
 DebugReportGenerator::~DebugReportGenerator()
 {
+    // The archive is written in a worker thread which accesses our members
+    m_archiveWatcher.waitForFinished();
+
     // Clean up any leftover files
     cleanupReport();
 }
 
-QByteArray DebugReportGenerator::reportFileData() const
+QString DebugReportGenerator::reportFilePath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/" + m_reportFileName;
+}
+
+qint64 DebugReportGenerator::reportFileSize() const
 {
-    return m_reportFileData;
+    return m_reportFileSize;
 }
 
 QString DebugReportGenerator::reportFileName()
@@ -78,26 +90,16 @@ bool DebugReportGenerator::isValid() const
     return m_isValid;
 }
 
+int DebugReportGenerator::progress() const
+{
+    return m_progress;
+}
+
 void DebugReportGenerator::generateReport()
 {
     qCDebug(dcDebugServer()) << "Start generating debug report";
-    m_reportFileName = QDateTime::currentDateTime().toString("yyyyMMddhhmm") + "-nymea-debug-report";
-
-    m_reportDirectory.setPath(QString("%1/%2").arg(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).arg(m_reportFileName));
-    //m_reportDirectory.setPath(QString("/tmp/%1").arg(m_reportFileName));
-    if (!m_reportDirectory.exists()) {
-        qCDebug(dcDebugServer()) << "Create temporary folder to collect the data" << m_reportDirectory.path();
-        if (!m_reportDirectory.mkpath(m_reportDirectory.path())) {
-            qCWarning(dcDebugServer()) << "Could not create output directory for debug report";
-            emit finished(false);
-            return;
-        }
-        m_reportDirectory.mkpath(m_reportDirectory.path() + "/config");
-        m_reportDirectory.mkpath(m_reportDirectory.path() + "/network");
-        m_reportDirectory.mkpath(m_reportDirectory.path() + "/logs");
-    }
-
-    m_reportFileName += ".tar.gz";
+    m_reportDirectoryName = QDateTime::currentDateTime().toString("yyyyMMddhhmm") + "-nymea-debug-report";
+    m_reportFileName = m_reportDirectoryName + ".tar.gz";
 
     saveConfigs();
     saveLogFiles();
@@ -111,6 +113,9 @@ void DebugReportGenerator::generateReport()
 #else
     connect(pingProcess, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onPingProcessFinished(int,QProcess::ExitStatus)));
 #endif
+    connect(pingProcess, &QProcess::errorOccurred, this, [this, pingProcess](QProcess::ProcessError error){
+        addProcessErrorToReport(pingProcess, error, "ping.txt");
+    });
 
     QProcess *digProcess = new QProcess(this);
     digProcess->setProcessChannelMode(QProcess::MergedChannels);
@@ -119,6 +124,9 @@ void DebugReportGenerator::generateReport()
 #else
     connect(digProcess, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onDigProcessFinished(int,QProcess::ExitStatus)));
 #endif
+    connect(digProcess, &QProcess::errorOccurred, this, [this, digProcess](QProcess::ProcessError error){
+        addProcessErrorToReport(digProcess, error, "dns-lookup.txt");
+    });
 
     QProcess *tracePathProcess = new QProcess(this);
     tracePathProcess->setProcessChannelMode(QProcess::MergedChannels);
@@ -127,6 +135,9 @@ void DebugReportGenerator::generateReport()
 #else
     connect(tracePathProcess, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onTracePathProcessFinished(int,QProcess::ExitStatus)));
 #endif
+    connect(tracePathProcess, &QProcess::errorOccurred, this, [this, tracePathProcess](QProcess::ProcessError error){
+        addProcessErrorToReport(tracePathProcess, error, "tracepath.txt");
+    });
 
     m_runningProcesses.append(pingProcess);
     m_runningProcesses.append(digProcess);
@@ -137,46 +148,97 @@ void DebugReportGenerator::generateReport()
     tracePathProcess->start("tracepath", { "nymea.io" } );
 }
 
-void DebugReportGenerator::copyFileToReportDirectory(const QString &fileName, const QString &subDirectory)
+void DebugReportGenerator::addFileToReport(const QString &fileName, const QString &subDirectory)
 {
     QFileInfo fileInfo(fileName);
     if (fileInfo.exists()) {
-        QString destination = m_reportDirectory.path() + "/" + subDirectory;
-        if (!QFile::copy(fileName, destination + "/" + fileInfo.fileName())) {
-            qCWarning(dcDebugServer()) << "Could not copy file" << fileName << "to" << destination;
-        } else {
-            qCDebug(dcDebugServer()) << "Copy file" << fileName << "-->" << destination;
-        }
+        QString destination = m_reportDirectoryName + "/" + subDirectory + "/" + fileInfo.fileName();
+        qCDebug(dcDebugServer()) << "Add file" << fileName << "-->" << destination;
+        m_reportFiles.append(qMakePair(fileName, destination));
     }
 }
 
+void DebugReportGenerator::addProcessOutputToReport(QProcess *process, const QString &fileName)
+{
+    qCDebug(dcDebugServer()) << "Add process output to" << fileName;
+    m_reportData.append(qMakePair(m_reportDirectoryName + "/network/" + fileName, process->readAll()));
+
+    m_runningProcesses.removeAll(process);
+    process->deleteLater();
+
+    verifyRunningProcessesFinished();
+}
+
+void DebugReportGenerator::addProcessErrorToReport(QProcess *process, QProcess::ProcessError error, const QString &fileName)
+{
+    // All other errors are either followed by finished() or don't terminate the process
+    if (error != QProcess::FailedToStart) {
+        return;
+    }
+
+    qCWarning(dcDebugServer()) << "Could not start" << process->program() << process->errorString();
+    m_reportData.append(qMakePair(m_reportDirectoryName + "/network/" + fileName, process->errorString().toUtf8()));
+
+    m_runningProcesses.removeAll(process);
+    process->deleteLater();
+
+    verifyRunningProcessesFinished();
+}
+
 void DebugReportGenerator::verifyRunningProcessesFinished()
 {
     if (m_runningProcesses.isEmpty()) {
-        qCDebug(dcDebugServer()) << "All async processes are finished. Start compressing the file.";
-        m_compressProcess = new QProcess(this);
-        m_compressProcess->setProcessChannelMode(QProcess::MergedChannels);
-        m_compressProcess->setWorkingDirectory(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
-#if QT_VERSION > QT_VERSION_CHECK(6,0,0)
-        connect(m_compressProcess, &QProcess::finished, this, &DebugReportGenerator::onCompressProcessFinished);
-#else
-        connect(m_compressProcess, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onCompressProcessFinished(int,QProcess::ExitStatus)));
-#endif
-        m_compressProcess->start("tar", { "-zcf", m_reportFileName, "-C", QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/", m_reportDirectory.dirName() } );
-        qCDebug(dcDebugServer()) << "Execut command" << m_compressProcess->program() << m_compressProcess->arguments();
+        qCDebug(dcDebugServer()) << "All async processes are finished. Start writing the archive" << reportFilePath();
+        m_archiveWatcher.setFuture(QtConcurrent::run([this](){
+            return writeArchive();
+        }));
     }
 }
 
-void DebugReportGenerator::saveSystemInformation()
+bool DebugReportGenerator::writeArchive()
 {
-    QFile outputFile(m_reportDirectory.path() + "/sysinfo.txt");
-    if (!outputFile.open(QIODevice::ReadWrite)) {
-        qCWarning(dcDebugServer()) << "Could not open sysinfo file" << outputFile.fileName();
-        return;
+    // Note: Runs in a worker thread. Only touches the collected entries which are not modified any more at this point.
+    TarArchiveWriter archive(reportFilePath());
+    if (!archive.open()) {
+        qCWarning(dcDebugServer()) << "Could not create the debug report archive:" << archive.errorString();
+        return false;
+    }
+
+    int totalEntries = m_reportData.count() + m_reportFiles.count();
+    int writtenEntries = 0;
+
+    for (int i = 0; i < m_reportData.count(); i++) {
+        if (!archive.addData(m_reportData.at(i).first, m_reportData.at(i).second)) {
+            qCWarning(dcDebugServer()) << "Could not add" << m_reportData.at(i).first << "to the debug report:" << archive.errorString();
+            return false;
+        }
+        m_progress = 100 * ++writtenEntries / totalEntries;
+        emit progressChanged(m_progress);
+    }
+
+    for (int i = 0; i < m_reportFiles.count(); i++) {
+        // Files might have vanished in the meantime (e.g. rotated logs), skip those
+        if (!archive.addFile(m_reportFiles.at(i).first, m_reportFiles.at(i).second)) {
+            qCWarning(dcDebugServer()) << "Could not add" << m_reportFiles.at(i).first << "to the debug report:" << archive.errorString();
+        }
+        m_progress = 100 * ++writtenEntries / totalEntries;
+        emit progressChanged(m_progress);
+    }
+
+    if (!archive.close()) {
+        qCWarning(dcDebugServer()) << "Could not finish the debug report archive:" << archive.errorString();
+        return false;
     }
 
-    qCDebug(dcDebugServer()) << "Write system information file" << outputFile.fileName();
-    QTextStream stream(&outputFile);
+    m_reportFileSize = archive.size();
+    m_md5Sum = archive.md5Sum();
+    return true;
+}
+
+void DebugReportGenerator::saveSystemInformation()
+{
+    QByteArray data;
+    QTextStream stream(&data);
     stream << "Server name: " << NymeaCore::instance()->configuration()->serverName() << '\n';
     stream << "Server version: " << NYMEA_VERSION_STRING << '\n';
     stream << "JSON-RPC version: " << JSON_PROTOCOL_VERSION << '\n';
@@ -199,7 +261,10 @@ void DebugReportGenerator::saveSystemInformation()
     stream << "Kernel version: " << QSysInfo::kernelVersion() << '\n';
     stream << "Product type: " << QSysInfo::productType() << '\n';
     stream << "Product version: " << QSysInfo::productVersion() << '\n';
-    outputFile.close();
+    stream.flush();
+
+    qCDebug(dcDebugServer()) << "Add system information to report";
+    m_reportData.append(qMakePair(m_reportDirectoryName + "/sysinfo.txt", data));
 }
 
 void DebugReportGenerator::saveLogFiles()
@@ -207,7 +272,7 @@ void DebugReportGenerator::saveLogFiles()
     QDir logDir("/var/log/");
     QStringList syslogFiles = logDir.entryList(QStringList() << "syslog*" << "nymea.*", QDir::Files);
     foreach (const QString &logFile, syslogFiles) {
-        copyFileToReportDirectory(logDir.path() + "/" + logFile, "logs");
+        addFileToReport(logDir.path() + "/" + logFile, "logs");
     }
 
 }
@@ -221,145 +286,69 @@ void DebugReportGenerator::saveConfigs()
         if (fileName.contains("user-db.sqlite"))
             continue;
 
-        copyFileToReportDirectory(settingsDir.absolutePath() + QDir::separator() + fileName, "config");
+        addFileToReport(settingsDir.absolutePath() + QDir::separator() + fileName, "config");
     }
 }
 
 void DebugReportGenerator::saveEnv()
 {
-    QFile outputFile(m_reportDirectory.path() + "/env.txt");
-    if (!outputFile.open(QIODevice::ReadWrite)) {
-        qCWarning(dcDebugServer()) << "Could not open env file" << outputFile.fileName();
-        return;
-    }
-
+    QByteArray data;
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    QTextStream stream(&outputFile);
+    QTextStream stream(&data);
     foreach(const QString &key, env.keys()) {
         qCDebug(dcDebugServer()) << "Process environment:" << key << "-->" << env.value(key);
         stream << key << "=" << env.value(key) << "\n";
     }
-    outputFile.close();
+    stream.flush();
+    m_reportData.append(qMakePair(m_reportDirectoryName + "/env.txt", data));
 }
 
 void DebugReportGenerator::cleanupReport()
 {
-    QFile reportFile(QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/" + m_reportFileName);
+    if (m_reportFileName.isEmpty()) {
+        return;
+    }
+
+    QFile reportFile(reportFilePath());
     if (reportFile.exists()) {
         qCDebug(dcDebugServer()) << "Delete report file" << reportFile.fileName();
         if (!reportFile.remove()) {
             qCWarning(dcDebugServer()) << "Could not delete report file" << reportFile.fileName();
         }
     }
-
-    if (m_reportDirectory.exists()) {
-        qCDebug(dcDebugServer()) << "Clean up report directory" << m_reportDirectory.path();
-        if (!m_reportDirectory.removeRecursively()) {
-            qCWarning(dcDebugServer()) << "Could not delete report directory" << m_reportDirectory.path();
-        }
-    }
 }
 
 void DebugReportGenerator::onPingProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    QProcess *process = static_cast<QProcess *>(sender());
     qCDebug(dcDebugServer()) << "Ping process finished" << exitCode << exitStatus;
-    QByteArray processOutput = process->readAll();
-
-    QFile outputFile(m_reportDirectory.path() + "/network/ping.txt");
-    if (!outputFile.open(QIODevice::ReadWrite)) {
-        qCWarning(dcDebugServer()) << "Could not open ping file" << outputFile.fileName();
-    } else {
-        qCDebug(dcDebugServer()) << "Write result into file" << outputFile.fileName();
-        outputFile.write(processOutput);
-        outputFile.close();
-    }
-
-    m_runningProcesses.removeAll(process);
-    process->deleteLater();
-    process = nullptr;
-
-    verifyRunningProcessesFinished();
+    addProcessOutputToReport(static_cast<QProcess *>(sender()), "ping.txt");
 }
 
 void DebugReportGenerator::onDigProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    QProcess *process = static_cast<QProcess *>(sender());
     qCDebug(dcDebugServer()) << "Dig process finished" << exitCode << exitStatus;
-    QByteArray processOutput = process->readAll();
-
-    QFile outputFile(m_reportDirectory.path() + "/network/dns-lookup.txt");
-    if (!outputFile.open(QIODevice::ReadWrite)) {
-        qCWarning(dcDebugServer()) << "Could not open dig file" << outputFile.fileName();
-    } else {
-        qCDebug(dcDebugServer()) << "Write result into file" << outputFile.fileName();
-        outputFile.write(processOutput);
-        outputFile.close();
-    }
-
-    m_runningProcesses.removeAll(process);
-    process->deleteLater();
-    process = nullptr;
-
-    verifyRunningProcessesFinished();
+    addProcessOutputToReport(static_cast<QProcess *>(sender()), "dns-lookup.txt");
 }
 
 void DebugReportGenerator::onTracePathProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    QProcess *process = static_cast<QProcess *>(sender());
     qCDebug(dcDebugServer()) << "Tracepath process finished" << exitCode << exitStatus;
-    QByteArray processOutput = process->readAll();
-
-
-    QFile outputFile(m_reportDirectory.path() + "/network/tracepath.txt");
-    if (!outputFile.open(QIODevice::ReadWrite)) {
-        qCWarning(dcDebugServer()) << "Could not open dig file" << outputFile.fileName();
-    } else {
-        qCDebug(dcDebugServer()) << "Write result into file" << outputFile.fileName();
-        outputFile.write(processOutput);
-        outputFile.close();
-    }
-
-    m_runningProcesses.removeAll(process);
-    process->deleteLater();
-    process = nullptr;
-
-    verifyRunningProcessesFinished();
+    addProcessOutputToReport(static_cast<QProcess *>(sender()), "tracepath.txt");
 }
 
-void DebugReportGenerator::onCompressProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+void DebugReportGenerator::onArchiveFinished()
 {
-    QProcess *process = static_cast<QProcess *>(sender());
-    qCDebug(dcDebugServer()) << "Compress process finished" << exitCode << exitStatus;
-
-    qCDebug(dcDebugServer()) << "Clean up report directory" << m_reportDirectory.path();
-    if (!m_reportDirectory.removeRecursively()) {
-        qCWarning(dcDebugServer()) << "Could not delete report directory" << m_reportDirectory.path();
-    }
-
-    // Read the file
-    QFile reportFile(QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/" + m_reportFileName);
-    if (!reportFile.open(QIODevice::ReadOnly)) {
-        qCWarning(dcDebugServer()) << "Could not open report file name for reading" << reportFile.fileName();
-        m_isReady = true;
-        m_isValid = false;
-        emit finished(false);
+    m_isReady = true;
+    m_isValid = m_archiveWatcher.result();
+    if (m_isValid) {
+        qCDebug(dcDebugServer()) << "File generated successfully" << reportFilePath() << m_reportFileSize << "B" << m_md5Sum;
     } else {
-        m_reportFileData = reportFile.readAll();
-        m_md5Sum =  QString::fromUtf8(QCryptographicHash::hash(m_reportFileData, QCryptographicHash::Md5).toHex());
-        qCDebug(dcDebugServer()) << "File generated successfully" << reportFile.fileName() << m_reportFileData.size() << "B" << m_md5Sum;
-        m_isReady = true;
-        m_isValid = true;
-        emit finished(true);
+        qCWarning(dcDebugServer()) << "Generating the debug report failed.";
     }
-
-    reportFile.close();
+    emit finished(m_isValid);
 
     // When this timer expires, the debug report is not valid any more and will be deleted
     QTimer::singleShot(120000, this, &DebugReportGenerator::timeout);
-
-    process->deleteLater();
-    process = nullptr;
 }
 
 }
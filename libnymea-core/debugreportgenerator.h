@@ -28,6 +28,9 @@
 #include <QDir>
 #include <QObject>
 #include <QProcess>
+#include <QFutureWatcher>
+
+#include <atomic>
 
 namespace nymeaserver {
 
@@ -38,29 +41,40 @@ public:
     explicit DebugReportGenerator(QObject *parent = nullptr);
     ~DebugReportGenerator();
 
-    QByteArray reportFileData() const;
+    QString reportFilePath() const;
+    qint64 reportFileSize() const;
     QString reportFileName();
     QString md5Sum() const;
 
     bool isReady() const;
     bool isValid() const;
+    int progress() const;
 
     void generateReport();
 
 private:
-    QDir m_reportDirectory;
+    QString m_reportDirectoryName;
     QString m_reportFileName;
     bool m_isReady = false;
     bool m_isValid = false;
 
-    QProcess *m_compressProcess = nullptr;
     QList<QProcess *> m_runningProcesses;
 
-    QByteArray m_reportFileData;
+    // Archive path -> content for data collected in memory
+    QList<QPair<QString, QByteArray>> m_reportData;
+    // Source file -> archive path for files added to the report as they are
+    QList<QPair<QString, QString>> m_reportFiles;
+
+    QFutureWatcher<bool> m_archiveWatcher;
+    std::atomic<int> m_progress;
+    qint64 m_reportFileSize = 0;
     QString m_md5Sum;
 
-    void copyFileToReportDirectory(const QString &fileName, const QString &subDirectory = QString());
+    void addFileToReport(const QString &fileName, const QString &subDirectory = QString());
+    void addProcessOutputToReport(QProcess *process, const QString &fileName);
+    void addProcessErrorToReport(QProcess *process, QProcess::ProcessError error, const QString &fileName);
     void verifyRunningProcessesFinished();
+    bool writeArchive();
 
     void saveSystemInformation();
     void saveLogFiles();
@@ -71,13 +85,14 @@ private:
 
 signals:
     void finished(bool success);
+    void progressChanged(int progress);
     void timeout();
 
 private slots:
     void onPingProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onDigProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onTracePathProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    void onCompressProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onArchiveFinished();
 
 };
 
@@ -27,6 +27,7 @@
 #include "loggingcategories.h"
 #include "debugserverhandler.h"
 #include "nymeaconfiguration.h"
+#include "integrations/plugincallstatistics.h"
 #include "version.h"
 
 #include <QCoreApplication>
@@ -479,6 +480,22 @@ HttpReply *DebugServerHandler::processDebugRequest(const QString &requestPath, c
         }
     }
 
+    if (requestPath.startsWith("/debug/plugin-statistics")) {
+        qCDebug(dcDebugServer()) << "Request plugin call statistics";
+        PluginCallStatistics *statistics = NymeaCore::instance()->pluginCallStatistics();
+        QVariantMap dataMap;
+        dataMap.insert("slowCallThreshold", statistics->slowCallThreshold());
+        dataMap.insert("pluginStatistics", statistics->statistics());
+        if (requestQuery.hasQueryItem("reset")) {
+            statistics->reset();
+        }
+
+        HttpReply *reply = HttpReply::createSuccessReply();
+        reply->setHeader(HttpReply::ContentTypeHeader, "application/json");
+        reply->setPayload(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
+        return reply;
+    }
+
     if (requestPath.startsWith("/debug/report")) {
 
         // The client can poll this url in order to get information about the current report generating process.
@@ -504,7 +521,7 @@ HttpReply *DebugServerHandler::processDebugRequest(const QString &requestPath, c
 
             // Everything looks good, send the requested debug report
             HttpReply *downloadReportReply = HttpReply::createSuccessReply();
-            downloadReportReply->setPayload(m_debugReportGenerator->reportFileData());
+            downloadReportReply->setPayloadFile(m_debugReportGenerator->reportFilePath());
             downloadReportReply->setHeader(HttpReply::ContentTypeHeader, "application/tar+gzip;");
             return downloadReportReply;
         } else {
@@ -520,15 +537,17 @@ HttpReply *DebugServerHandler::processDebugRequest(const QString &requestPath, c
             } else {
                 // There is a running generator, check if the report is ready
                 if (!m_debugReportGenerator->isReady()) {
-                    qCDebug(dcDebugServer()) << "Report is not ready yet";
+                    qCDebug(dcDebugServer()) << "Report is not ready yet" << m_debugReportGenerator->progress() << "%";
                     // Note: no content tells the client the report is not ready yet
-                    return HttpReply::createErrorReply(HttpReply::NoContent);
+                    HttpReply *reply = HttpReply::createErrorReply(HttpReply::NoContent);
+                    reply->setRawHeader("X-Report-Progress", QByteArray::number(m_debugReportGenerator->progress()));
+                    return reply;
                 } else {
                     if (m_debugReportGenerator->isValid()) {
                         // Success, the debug report is ready and valid
                         QVariantMap reportInformation;
                         reportInformation.insert("fileName", m_debugReportGenerator->reportFileName());
-                        reportInformation.insert("fileSize", m_debugReportGenerator->reportFileData().size());
+                        reportInformation.insert("fileSize", m_debugReportGenerator->reportFileSize());
                         reportInformation.insert("md5sum", m_debugReportGenerator->md5Sum());
 
                         HttpReply * httpReply = HttpReply::createSuccessReply();
@@ -1622,6 +1641,50 @@ QByteArray DebugServerHandler::createDebugXmlDocument()
 
     writer.writeEndElement(); // div download-row
 
+
+    // Download row plugin statistics
+    writer.writeStartElement("div");
+    writer.writeAttribute("class", "download-row");
+
+    writer.writeStartElement("div");
+    writer.writeAttribute("class", "download-name-column");
+    //: The plugin call statistics download description of the debug interface
+    writer.writeTextElement("p", tr("Plugin call statistics"));
+    writer.writeEndElement(); // div download-name-column
+
+    writer.writeStartElement("div");
+    writer.writeAttribute("class", "download-path-column");
+    writer.writeTextElement("p", "/debug/plugin-statistics");
+    writer.writeEndElement(); // div download-path-column
+
+    writer.writeStartElement("div");
+    writer.writeAttribute("class", "download-button-column");
+    writer.writeStartElement("form");
+    writer.writeAttribute("class", "download-button");
+    writer.writeStartElement("button");
+    writer.writeAttribute("class", "button");
+    writer.writeAttribute("type", "button");
+    writer.writeAttribute("onClick", "downloadFile('/debug/plugin-statistics', 'plugin-statistics.json')");
+    writer.writeCharacters(tr("Download"));
+    writer.writeEndElement(); // button
+    writer.writeEndElement(); // form
+    writer.writeEndElement(); // div download-button-column
+
+    writer.writeStartElement("div");
+    writer.writeAttribute("class", "show-button-column");
+    writer.writeStartElement("form");
+    writer.writeAttribute("class", "show-button");
+    writer.writeStartElement("button");
+    writer.writeAttribute("class", "button");
+    writer.writeAttribute("type", "button");
+    writer.writeAttribute("onClick", "showFile('/debug/plugin-statistics')");
+    writer.writeCharacters(tr("Show"));
+    writer.writeEndElement(); // button
+    writer.writeEndElement(); // form
+    writer.writeEndElement(); // div show-button-column
+
+    writer.writeEndElement(); // div download-row
+
     writer.writeEndElement(); // downloads-section
 
 
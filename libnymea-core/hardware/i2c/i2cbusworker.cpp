@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "i2cbusworker.h"
+
+#include "hardware/i2c/i2cdevice.h"
+#include "loggingcategories.h"
+
+#include <QFile>
+
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+namespace nymeaserver {
+
+I2CBusWorker::I2CBusWorker(const QString &portName, QFile *file, QObject *parent) :
+    QThread(parent),
+    m_portName(portName),
+    m_file(file),
+    m_fileDescriptor(file->handle())
+{
+    m_file->setParent(this);
+    m_clock.start();
+}
+
+I2CBusWorker::~I2CBusWorker()
+{
+    stop();
+    m_file->close();
+}
+
+QString I2CBusWorker::portName() const
+{
+    return m_portName;
+}
+
+void I2CBusWorker::startReading(I2CDevice *i2cDevice, int interval)
+{
+    QMutexLocker locker(&m_mutex);
+    waitUntilIdle(i2cDevice);
+    unschedule(i2cDevice);
+
+    ReadingInfo readingInfo;
+    readingInfo.interval = interval;
+    readingInfo.deadline = m_clock.elapsed();
+    m_readers.insert(i2cDevice, readingInfo);
+    m_schedule.insert(readingInfo.deadline, i2cDevice);
+    m_wakeCondition.wakeAll();
+}
+
+void I2CBusWorker::stopReading(I2CDevice *i2cDevice)
+{
+    QMutexLocker locker(&m_mutex);
+    waitUntilIdle(i2cDevice);
+    unschedule(i2cDevice);
+}
+
+void I2CBusWorker::writeData(I2CDevice *i2cDevice, const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    WritingInfo info;
+    info.device = i2cDevice;
+    info.data = data;
+    m_writeQueue.append(info);
+    m_wakeCondition.wakeAll();
+}
+
+void I2CBusWorker::removeDevice(I2CDevice *i2cDevice)
+{
+    QMutexLocker locker(&m_mutex);
+    waitUntilIdle(i2cDevice);
+    unschedule(i2cDevice);
+    for (int i = m_writeQueue.count() - 1; i >= 0; i--) {
+        if (m_writeQueue.at(i).device == i2cDevice) {
+            m_writeQueue.removeAt(i);
+        }
+    }
+    logStatistics(i2cDevice);
+    m_statistics.remove(i2cDevice);
+}
+
+QMutex *I2CBusWorker::busMutex()
+{
+    return &m_busMutex;
+}
+
+void I2CBusWorker::stop()
+{
+    m_mutex.lock();
+    m_stopped = true;
+    m_wakeCondition.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+void I2CBusWorker::run()
+{
+    m_mutex.lock();
+    while (!m_stopped) {
+        // Writes have priority, they are processed as soon as they are queued
+        if (!m_writeQueue.isEmpty()) {
+            WritingInfo info = m_writeQueue.takeFirst();
+            m_currentDevice = info.device;
+            m_mutex.unlock();
+
+            qCDebug(dcI2C()) << "Writing to I2C device" << info.device;
+            m_busMutex.lock();
+            bool success = selectDevice(info.device) && info.device->writeData(m_fileDescriptor, info.data);
+            m_busMutex.unlock();
+            QMetaObject::invokeMethod(info.device, "dataWritten", Qt::QueuedConnection, Q_ARG(bool, success));
+
+            m_mutex.lock();
+            m_statistics[info.device].writes++;
+            m_currentDevice = nullptr;
+            m_idleCondition.wakeAll();
+            continue;
+        }
+
+        if (m_schedule.isEmpty()) {
+            m_wakeCondition.wait(&m_mutex);
+            continue;
+        }
+
+        qint64 now = m_clock.elapsed();
+        QMultiMap<qint64, I2CDevice*>::iterator next = m_schedule.begin();
+        if (next.key() > now) {
+            m_wakeCondition.wait(&m_mutex, static_cast<unsigned long>(next.key() - now));
+            continue;
+        }
+
+        I2CDevice *i2cDevice = next.value();
+        qint64 deadline = next.key();
+        m_schedule.erase(next);
+        m_currentDevice = i2cDevice;
+        m_mutex.unlock();
+
+        qCDebug(dcI2C()) << "Reading I2C device" << i2cDevice;
+        QByteArray data;
+        m_busMutex.lock();
+        qint64 started = m_clock.elapsed();
+        bool selected = selectDevice(i2cDevice);
+        if (selected) {
+            data = i2cDevice->readData(m_fileDescriptor);
+        }
+        qint64 finished = m_clock.elapsed();
+        m_busMutex.unlock();
+        if (selected) {
+            QMetaObject::invokeMethod(i2cDevice, "readingAvailable", Qt::QueuedConnection, Q_ARG(QByteArray, data));
+        }
+
+        m_mutex.lock();
+        m_currentDevice = nullptr;
+        m_idleCondition.wakeAll();
+
+        Statistics &statistics = m_statistics[i2cDevice];
+        statistics.reads++;
+        statistics.totalReadTime += finished - started;
+        statistics.maxReadTime = qMax(statistics.maxReadTime, finished - started);
+        statistics.maxReadDelay = qMax(statistics.maxReadDelay, started - deadline);
+
+        if (m_readers.contains(i2cDevice)) {
+            ReadingInfo &readingInfo = m_readers[i2cDevice];
+            // Keep the cadence, but don't try to catch up on readings missed because the bus was busy
+            readingInfo.deadline = deadline + readingInfo.interval;
+            if (readingInfo.deadline <= finished) {
+                readingInfo.deadline = finished + readingInfo.interval;
+            }
+            m_schedule.insert(readingInfo.deadline, i2cDevice);
+        }
+    }
+    m_mutex.unlock();
+}
+
+bool I2CBusWorker::selectDevice(I2CDevice *i2cDevice)
+{
+    if (m_fileDescriptor == -1) {
+        qCWarning(dcI2C()) << "I2C port" << m_portName << "not opened. Cannot access" << i2cDevice;
+        return false;
+    }
+
+    if (ioctl(m_fileDescriptor, I2C_SLAVE, i2cDevice->address()) < 0) {
+        qCWarning(dcI2C()) << "Cannot select I2C slave address for I2C device" << i2cDevice;
+        return false;
+    }
+    return true;
+}
+
+void I2CBusWorker::unschedule(I2CDevice *i2cDevice)
+{
+    if (!m_readers.contains(i2cDevice)) {
+        return;
+    }
+    m_schedule.remove(m_readers.take(i2cDevice).deadline, i2cDevice);
+}
+
+void I2CBusWorker::waitUntilIdle(I2CDevice *i2cDevice)
+{
+    while (m_currentDevice == i2cDevice) {
+        m_idleCondition.wait(&m_mutex);
+    }
+}
+
+void I2CBusWorker::logStatistics(I2CDevice *i2cDevice)
+{
+    if (!m_statistics.contains(i2cDevice)) {
+        return;
+    }
+    const Statistics &statistics = m_statistics.value(i2cDevice);
+    qCDebug(dcI2C()).nospace() << "Statistics for " << i2cDevice << ": "
+                               << statistics.reads << " reads (average "
+                               << (statistics.reads > 0 ? statistics.totalReadTime / statistics.reads : 0) << " ms, max "
+                               << statistics.maxReadTime << " ms, max delay "
+                               << statistics.maxReadDelay << " ms), "
+                               << statistics.writes << " writes";
+}
+
+}
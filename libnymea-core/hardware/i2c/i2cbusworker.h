@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef I2CBUSWORKER_H
+#define I2CBUSWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QMultiMap>
+#include <QHash>
+#include <QList>
+
+class QFile;
+class I2CDevice;
+
+namespace nymeaserver {
+
+// Serves all I2C devices on one bus from its own thread. Writes are processed as soon as they are
+// queued, readers are polled at their individual interval, ordered by their next deadline.
+class I2CBusWorker : public QThread
+{
+    Q_OBJECT
+public:
+    // Takes ownership of the opened bus \a file
+    explicit I2CBusWorker(const QString &portName, QFile *file, QObject *parent = nullptr);
+    ~I2CBusWorker() override;
+
+    QString portName() const;
+
+    void startReading(I2CDevice *i2cDevice, int interval);
+    void stopReading(I2CDevice *i2cDevice);
+    void writeData(I2CDevice *i2cDevice, const QByteArray &data);
+
+    // Stops reading from and drops pending writes for the device. Blocks while the device is being accessed.
+    void removeDevice(I2CDevice *i2cDevice);
+
+    // Held during every transfer on this bus
+    QMutex *busMutex();
+
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    class ReadingInfo {
+    public:
+        int interval = 0;
+        qint64 deadline = 0;
+    };
+    class WritingInfo {
+    public:
+        QByteArray data;
+        I2CDevice *device = nullptr;
+    };
+    class Statistics {
+    public:
+        int reads = 0;
+        int writes = 0;
+        qint64 totalReadTime = 0;
+        qint64 maxReadTime = 0;
+        qint64 maxReadDelay = 0;
+    };
+
+    bool selectDevice(I2CDevice *i2cDevice);
+    void unschedule(I2CDevice *i2cDevice);
+    void waitUntilIdle(I2CDevice *i2cDevice);
+    void logStatistics(I2CDevice *i2cDevice);
+
+private:
+    QString m_portName;
+    QFile *m_file = nullptr;
+    int m_fileDescriptor = -1;
+
+    QMutex m_busMutex;
+
+    QMutex m_mutex;
+    QWaitCondition m_wakeCondition;
+    QWaitCondition m_idleCondition;
+    bool m_stopped = false;
+
+    QElapsedTimer m_clock;
+    QHash<I2CDevice*, ReadingInfo> m_readers;
+    QMultiMap<qint64, I2CDevice*> m_schedule;
+    QList<WritingInfo> m_writeQueue;
+    I2CDevice *m_currentDevice = nullptr;
+    QHash<I2CDevice*, Statistics> m_statistics;
+};
+
+}
+
+#endif // I2CBUSWORKER_H
@@ -23,12 +23,13 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "i2cmanagerimplementation.h"
+#include "i2cbusworker.h"
 
 #include "hardware/i2c/i2cdevice.h"
 #include "loggingcategories.h"
 
 #include <QDir>
-#include <QtConcurrent/QtConcurrentRun>
+#include <QFile>
 
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -38,14 +39,12 @@ namespace nymeaserver {
 
 I2CManagerImplementation::I2CManagerImplementation(QObject *parent) : I2CManager(parent)
 {
-    m_pollTimer.setInterval(200);
-    m_pollTimer.setSingleShot(true);
-    connect(&m_pollTimer, &QTimer::timeout, this, &I2CManagerImplementation::nextCycle);
 }
 
 I2CManagerImplementation::~I2CManagerImplementation()
 {
-    m_watcher.waitForFinished();
+    qDeleteAll(m_busWorkers);
+    m_busWorkers.clear();
 }
 
 QStringList nymeaserver::I2CManagerImplementation::availablePorts() const
@@ -62,9 +61,10 @@ QList<I2CScanResult> nymeaserver::I2CManagerImplementation::scanRegisters(const
         portsToBeScanned = availablePorts();
     }
 
-    m_mutex.lock();
-
     foreach (const QString &p, portsToBeScanned) {
+        // Don't interfere with the transfers of opened devices on this bus
+        QMutexLocker locker(m_busWorkers.contains(p) ? m_busWorkers.value(p)->busMutex() : nullptr);
+
         QFile f("/dev/" + p);
         if (!f.open(QFile::ReadWrite)) {
             qCWarning(dcI2C()) << "Failed to open I2C port" << p << "for scanning";
@@ -94,181 +94,85 @@ QList<I2CScanResult> nymeaserver::I2CManagerImplementation::scanRegisters(const
             }
         }
     }
-    m_mutex.unlock();
     return ret;
 }
 
 bool I2CManagerImplementation::open(I2CDevice *i2cDevice)
 {
-    if (m_openFiles.contains(i2cDevice)) {
+    if (m_openDevices.contains(i2cDevice)) {
         qCWarning(dcI2C()) << "I2C device" << i2cDevice << "already opened.";
         return false;
     }
 
-    QString fileName = "/dev/" + i2cDevice->portName();
-
-    foreach (I2CDevice *d, m_openFiles.keys()) {
-        if (d->portName() == i2cDevice->portName()) {
-            // Another I2CDevice opened this file already. We'll hook into that.
-            m_mutex.lock();
-            m_openFiles.insert(i2cDevice, m_openFiles.value(d));
-            m_mutex.unlock();
-            return true;
-        }
+    if (m_busWorkers.contains(i2cDevice->portName())) {
+        // Another I2CDevice opened this bus already. We'll hook into that.
+        m_openDevices.insert(i2cDevice, m_busWorkers.value(i2cDevice->portName()));
+        return true;
     }
 
+    QString fileName = "/dev/" + i2cDevice->portName();
     if (!QFile::exists(fileName)) {
         qCWarning(dcI2C()) << "The I2C port does not exist:" << i2cDevice->portName();
         return false;
     }
 
-    QFile *file = new QFile("/dev/" + i2cDevice->portName(), this);
+    QFile *file = new QFile(fileName);
     if (!file->open(QFile::ReadWrite)) {
         qCWarning(dcI2C()) << "Error opening I2C port" << i2cDevice << "Error:" << file->errorString();
         delete file;
         return false;
     }
 
-    m_mutex.lock();
-    m_openFiles.insert(i2cDevice, file);
-    m_mutex.unlock();
+    I2CBusWorker *worker = new I2CBusWorker(i2cDevice->portName(), file, this);
+    worker->start();
+    m_busWorkers.insert(i2cDevice->portName(), worker);
+    m_openDevices.insert(i2cDevice, worker);
     return true;
 }
 
 bool I2CManagerImplementation::startReading(I2CDevice *i2cDevice, int interval)
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_openFiles.contains(i2cDevice)) {
+    if (!m_openDevices.contains(i2cDevice)) {
         qCWarning(dcI2C()) << "I2CDevice not open. Cannot start reading.";
         return false;
     }
     qCDebug(dcI2C()) << "Starting to poll I2C device" << i2cDevice;
-    ReadingInfo readingInfo;
-    readingInfo.interval = interval;
-    m_readers.insert(i2cDevice, readingInfo);
-
-    if (!m_pollTimer.isActive()) {
-        m_pollTimer.start();
-    }
+    m_openDevices.value(i2cDevice)->startReading(i2cDevice, interval);
     return true;
 }
 
 
 void I2CManagerImplementation::stopReading(I2CDevice *i2cDevice)
 {
-    QMutexLocker locker(&m_mutex);
-    m_readers.remove(i2cDevice);
-
-    if (m_readers.count() == 0) {
-        m_pollTimer.stop();
+    if (!m_openDevices.contains(i2cDevice)) {
+        return;
     }
+    m_openDevices.value(i2cDevice)->stopReading(i2cDevice);
 }
 
 bool I2CManagerImplementation::writeData(I2CDevice *i2cDevice, const QByteArray &data)
 {
-    m_writeQueueMutex.lock();
-    WritingInfo info;
-    info.device = i2cDevice;
-    info.data = data;
-    m_writeQueue.append(info);
-    m_writeQueueMutex.unlock();
+    if (!m_openDevices.contains(i2cDevice)) {
+        qCWarning(dcI2C()) << "I2C device" << i2cDevice << "not opened. Cannot write to it.";
+        return false;
+    }
+    m_openDevices.value(i2cDevice)->writeData(i2cDevice, data);
     return true;
 }
 
 void I2CManagerImplementation::close(I2CDevice *i2cDevice)
 {
-    bool isInUse = false;
-    m_mutex.lock();
-    if (m_readers.contains(i2cDevice)) {
-        isInUse = true;
-    }
-    m_mutex.unlock();
-
-    if (isInUse) {
-        stopReading(i2cDevice);
-    }
-
-    int refCount = 0;
-    foreach (I2CDevice* d, m_openFiles.keys()) {
-        if (d->portName() == i2cDevice->portName()) {
-            refCount++;
-        }
+    I2CBusWorker *worker = m_openDevices.take(i2cDevice);
+    if (!worker) {
+        return;
     }
-    if (refCount == 0) {
-
-        m_mutex.lock();
-        QFile *f = m_openFiles.take(i2cDevice);
-        m_mutex.unlock();
+    worker->removeDevice(i2cDevice);
 
-        f->close();
-        f->deleteLater();
+    // Close the bus when the last device on it is closed
+    if (!m_openDevices.values().contains(worker)) {
+        m_busWorkers.remove(worker->portName());
+        delete worker;
     }
 }
 
-void I2CManagerImplementation::nextCycle()
-{
-    QFuture<void> future = QtConcurrent::run([this](){
-        // Copy the write queue to open it up as fast as possible for others to append new entries
-        m_writeQueueMutex.lock();
-        QList<WritingInfo> writeQueue = m_writeQueue;
-        m_writeQueue.clear();
-        m_writeQueueMutex.unlock();
-
-        m_mutex.lock();
-
-        foreach (const WritingInfo &info, writeQueue) {
-            I2CDevice *i2cDevice = info.device;
-
-            int fd = m_openFiles.value(i2cDevice)->handle();
-            if (fd == -1) {
-                qCWarning(dcI2C()) << "I2C device" << i2cDevice << "not opened. Cannot write to it.";
-                continue;
-            }
-
-            if (ioctl(fd, I2C_SLAVE, i2cDevice->address()) < 0) {
-                qCWarning(dcI2C()) << "Cannot select I2C slave address for I2C device" << i2cDevice;
-                continue;
-            }
-
-            qCDebug(dcI2C()) << "Writing to I2C device" << i2cDevice;
-            bool success = i2cDevice->writeData(fd, info.data);
-
-            QMetaObject::invokeMethod(i2cDevice, "dataWritten", Qt::QueuedConnection, Q_ARG(bool, success));
-
-        }
-
-        foreach (I2CDevice *i2cDevice, m_readers.keys()) {
-            ReadingInfo readingInfo = m_readers.value(i2cDevice);
-            if (readingInfo.lastReading.addMSecs(readingInfo.interval) > QDateTime::currentDateTime()) {
-                continue;
-            }
-            int fd = m_openFiles.value(i2cDevice)->handle();
-            if (fd == -1) {
-                qCWarning(dcI2C()) << "I2C device" << i2cDevice << "not opened. Cannot read.";
-                continue;
-            }
-
-            if (ioctl(fd, I2C_SLAVE, i2cDevice->address()) < 0) {
-                qCWarning(dcI2C()) << "Cannot select I2C slave address for I2C device" << i2cDevice;
-                continue;
-            }
-
-            qCDebug(dcI2C()) << "Reading I2C device" << i2cDevice;
-            QByteArray data = i2cDevice->readData(fd);
-
-            m_readers[i2cDevice].lastReading = QDateTime::currentDateTime();
-
-            QMetaObject::invokeMethod(i2cDevice, "readingAvailable", Qt::QueuedConnection, Q_ARG(QByteArray, data));
-        }
-
-        m_mutex.unlock();
-    });
-
-    m_watcher.setFuture(future);
-    connect(&m_watcher, &QFutureWatcher<void>::finished, this, [this](){
-        m_pollTimer.start();
-    });
-}
-
 }
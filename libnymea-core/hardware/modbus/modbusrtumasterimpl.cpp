@@ -26,6 +26,7 @@
 #include "modbusrtureplyimpl.h"
 
 #include <QLoggingCategory>
+#include <QTimer>
 
 #ifdef WITH_QTSERIALBUS
 #include <QtSerialBus/QModbusReply>
@@ -36,6 +37,11 @@ Q_DECLARE_LOGGING_CATEGORY(dcModbusRtu)
 
 namespace nymeaserver {
 
+#ifdef WITH_QTSERIALBUS
+// How long a read response may be handed out to other readers of the same registers
+const int ModbusRtuMasterImpl::s_cacheTimeout = 200;
+#endif
+
 ModbusRtuMasterImpl::ModbusRtuMasterImpl(const QUuid &modbusUuid, const QString &serialPort, qint32 baudrate, QSerialPort::Parity parity, QSerialPort::DataBits dataBits, QSerialPort::StopBits stopBits, int numberOfRetries, int timeout, QObject *parent) :
     ModbusRtuMaster(parent),
     m_modbusUuid(modbusUuid),
@@ -79,6 +85,11 @@ ModbusRtuMasterImpl::ModbusRtuMasterImpl(const QUuid &modbusUuid, const QString
                 emit connectedChanged(m_connected);
             }
         }
+
+        // The request on the wire might never finish once the connection is gone, don't block the queue with it
+        if (state == QModbusDevice::UnconnectedState) {
+            abortCurrentRequest();
+        }
     });
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -92,6 +103,12 @@ ModbusRtuMasterImpl::ModbusRtuMasterImpl(const QUuid &modbusUuid, const QString
         }
     });
 #endif
+
+    m_statisticsTimer.start();
+    QTimer *statisticsTimer = new QTimer(this);
+    statisticsTimer->setInterval(60000);
+    connect(statisticsTimer, &QTimer::timeout, this, &ModbusRtuMasterImpl::logStatistics);
+    statisticsTimer->start();
 }
 
 QUuid ModbusRtuMasterImpl::modbusUuid() const
@@ -243,38 +260,7 @@ void ModbusRtuMasterImpl::setTimeout(int timeout)
 ModbusRtuReply *ModbusRtuMasterImpl::readCoil(int slaveAddress, int registerAddress, quint16 size)
 {
 #ifdef WITH_QTSERIALBUS
-    // Create the reply for the plugin
-    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
-    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
-
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::Coils, registerAddress, size);
-    QModbusReply *modbusReply = m_modbus->sendReadRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Read coil request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
-        }
-
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
-        emit reply->finished();
-    });
-
-    return qobject_cast<ModbusRtuReply *>(reply);
+    return enqueueRead(QModbusDataUnit::Coils, slaveAddress, registerAddress, size);
 #else
     Q_UNUSED(slaveAddress)
     Q_UNUSED(registerAddress)
@@ -288,38 +274,7 @@ ModbusRtuReply *ModbusRtuMasterImpl::readCoil(int slaveAddress, int registerAddr
 ModbusRtuReply *ModbusRtuMasterImpl::readDiscreteInput(int slaveAddress, int registerAddress, quint16 size)
 {
 #ifdef WITH_QTSERIALBUS
-    // Create the reply for the plugin
-    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
-    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
-
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::DiscreteInputs, registerAddress, size);
-    QModbusReply *modbusReply = m_modbus->sendReadRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Read descrete inputs request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
-        }
-
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
-        emit reply->finished();
-    });
-
-    return qobject_cast<ModbusRtuReply *>(reply);
+    return enqueueRead(QModbusDataUnit::DiscreteInputs, slaveAddress, registerAddress, size);
 #else
     Q_UNUSED(slaveAddress)
     Q_UNUSED(registerAddress)
@@ -333,38 +288,7 @@ ModbusRtuReply *ModbusRtuMasterImpl::readDiscreteInput(int slaveAddress, int reg
 ModbusRtuReply *ModbusRtuMasterImpl::readInputRegister(int slaveAddress, int registerAddress, quint16 size)
 {
 #ifdef WITH_QTSERIALBUS
-    // Create the reply for the plugin
-    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
-    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
-
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::InputRegisters, registerAddress, size);
-    QModbusReply *modbusReply = m_modbus->sendReadRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Read input registers request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
-        }
-
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
-        emit reply->finished();
-    });
-
-    return qobject_cast<ModbusRtuReply *>(reply);
+    return enqueueRead(QModbusDataUnit::InputRegisters, slaveAddress, registerAddress, size);
 #else
     Q_UNUSED(slaveAddress)
     Q_UNUSED(registerAddress)
@@ -378,38 +302,7 @@ ModbusRtuReply *ModbusRtuMasterImpl::readInputRegister(int slaveAddress, int reg
 ModbusRtuReply *ModbusRtuMasterImpl::readHoldingRegister(int slaveAddress, int registerAddress, quint16 size)
 {
 #ifdef WITH_QTSERIALBUS
-    // Create the reply for the plugin
-    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
-    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
-
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::HoldingRegisters, registerAddress, size);
-    QModbusReply *modbusReply = m_modbus->sendReadRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Read holding registers request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
-        }
-
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
-        emit reply->finished();
-    });
-
-    return qobject_cast<ModbusRtuReply *>(reply);
+    return enqueueRead(QModbusDataUnit::HoldingRegisters, slaveAddress, registerAddress, size);
 #else
     Q_UNUSED(slaveAddress)
     Q_UNUSED(registerAddress)
@@ -423,39 +316,22 @@ ModbusRtuReply *ModbusRtuMasterImpl::readHoldingRegister(int slaveAddress, int r
 ModbusRtuReply *ModbusRtuMasterImpl::writeCoils(int slaveAddress, int registerAddress, const QVector<quint16> &values)
 {
 #ifdef WITH_QTSERIALBUS
-    // Create the reply for the plugin
-    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
-    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
+    return enqueueWrite(QModbusDataUnit::Coils, slaveAddress, registerAddress, values);
+#else
+    Q_UNUSED(slaveAddress)
+    Q_UNUSED(registerAddress)
+    Q_UNUSED(values)
+    qCWarning(dcModbusRtu()) << "Modbus is not available on this platform.";
 
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::Coils, registerAddress, values.length());
-    request.setValues(values);
-    QModbusReply *modbusReply = m_modbus->sendWriteRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Write coil request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
-        }
+    return nullptr;
+#endif
+}
 
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
-        emit reply->finished();
-    });
 
-    return qobject_cast<ModbusRtuReply *>(reply);
+ModbusRtuReply *ModbusRtuMasterImpl::writeHoldingRegisters(int slaveAddress, int registerAddress, const QVector<quint16> &values)
+{
+#ifdef WITH_QTSERIALBUS
+    return enqueueWrite(QModbusDataUnit::HoldingRegisters, slaveAddress, registerAddress, values);
 #else
     Q_UNUSED(slaveAddress)
     Q_UNUSED(registerAddress)
@@ -466,51 +342,316 @@ ModbusRtuReply *ModbusRtuMasterImpl::writeCoils(int slaveAddress, int registerAd
 #endif
 }
 
+#ifdef WITH_QTSERIALBUS
+ModbusRtuReplyImpl *ModbusRtuMasterImpl::enqueueRead(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size)
+{
+    // Create the reply for the plugin
+    ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
+    connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
 
-ModbusRtuReply *ModbusRtuMasterImpl::writeHoldingRegisters(int slaveAddress, int registerAddress, const QVector<quint16> &values)
+    Subscriber subscriber;
+    subscriber.reply = reply;
+    subscriber.registerAddress = registerAddress;
+    subscriber.size = size;
+    subscriber.timer.start();
+
+    // Served from a recent response of another read covering the same registers, unless a write to them is pending
+    QVector<quint16> cachedValues;
+    if (!hasPendingWrite(registerType, slaveAddress, registerAddress, size) && readCache(registerType, slaveAddress, registerAddress, size, &cachedValues)) {
+        m_cacheHits++;
+        // The caller needs a chance to connect to the reply first
+        QTimer::singleShot(0, reply, [=](){
+            finishSubscriber(subscriber, QModbusDevice::NoError, QString(), cachedValues);
+        });
+        return reply;
+    }
+
+    // Already on the wire. A read issued after a pending write to these registers has to wait for the write though.
+    if (m_currentReply && !m_currentRequest.write && !hasPendingWrite(registerType, slaveAddress, registerAddress, size) && m_currentRequest.registerType == registerType && m_currentRequest.slaveAddress == slaveAddress
+            && registerAddress >= m_currentRequest.registerAddress && registerAddress + size <= m_currentRequest.registerAddress + m_currentRequest.size) {
+        m_currentRequest.subscribers.append(subscriber);
+        m_coalescedRequests++;
+        return reply;
+    }
+
+    // Merge with a queued read of the same slave if the ranges overlap or are adjacent
+    for (int i = 0; i < m_readQueue.count(); i++) {
+        Request &queued = m_readQueue[i];
+        if (!queued.coalesce || queued.registerType != registerType || queued.slaveAddress != slaveAddress)
+            continue;
+
+        int start = qMin(queued.registerAddress, registerAddress);
+        int end = qMax(queued.registerAddress + queued.size, registerAddress + size);
+        if (registerAddress > queued.registerAddress + queued.size || queued.registerAddress > registerAddress + size || end - start > maxReadSize(registerType))
+            continue;
+
+        queued.registerAddress = start;
+        queued.size = end - start;
+        queued.subscribers.append(subscriber);
+        m_coalescedRequests++;
+        return reply;
+    }
+
+    Request request;
+    request.registerType = registerType;
+    request.slaveAddress = slaveAddress;
+    request.registerAddress = registerAddress;
+    request.size = size;
+    request.subscribers.append(subscriber);
+    m_readQueue.append(request);
+
+    sendNextRequest();
+    return reply;
+}
+
+ModbusRtuReplyImpl *ModbusRtuMasterImpl::enqueueWrite(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, const QVector<quint16> &values)
 {
-#ifdef WITH_QTSERIALBUS
     // Create the reply for the plugin
     ModbusRtuReplyImpl *reply = new ModbusRtuReplyImpl(slaveAddress, registerAddress, this);
     connect(reply, &ModbusRtuReplyImpl::finished, reply, &ModbusRtuReplyImpl::deleteLater);
 
-    // Create the actual modbus lib reply
-    QModbusDataUnit request = QModbusDataUnit(QModbusDataUnit::RegisterType::HoldingRegisters, registerAddress, values.length());
-    request.setValues(values);
-    QModbusReply *modbusReply = m_modbus->sendWriteRequest(request, slaveAddress);
-
-    // Cleaning up modbusReply when our reply finishes, regardless if that happened because modbusReply finished or reply timeouted
-    connect(reply, &ModbusRtuReply::finished, modbusReply, &QModbusReply::deleteLater);
-
-    connect(modbusReply, &QModbusReply::finished, reply, [=](){
-        // Fill common reply data
-        reply->setFinished(true);
-        reply->setError(static_cast<ModbusRtuReply::Error>(modbusReply->error()));
-        reply->setErrorString(modbusReply->errorString());
-
-        // Check if the reply finished with an error
-        if (modbusReply->error() != QModbusDevice::NoError) {
-            qCWarning(dcModbusRtu()) << "Write holding register request finished with error" << modbusReply->error() << modbusReply->errorString();
-            emit reply->errorOccurred(reply->error());
-            emit reply->finished();
-            return;
+    Subscriber subscriber;
+    subscriber.reply = reply;
+    subscriber.registerAddress = registerAddress;
+    subscriber.size = values.count();
+    subscriber.timer.start();
+
+    Request request;
+    request.registerType = registerType;
+    request.slaveAddress = slaveAddress;
+    request.registerAddress = registerAddress;
+    request.size = values.count();
+    request.values = values;
+    request.write = true;
+    request.coalesce = false;
+    request.subscribers.append(subscriber);
+
+    // Cached values of these registers are outdated from now on
+    invalidateCache(registerType, slaveAddress, registerAddress, values.count());
+
+    // Writes are usually setpoints someone is waiting for, don't let them wait behind the polling
+    m_writeQueue.append(request);
+
+    sendNextRequest();
+    return reply;
+}
+
+void ModbusRtuMasterImpl::sendNextRequest()
+{
+    while (!m_currentReply && (!m_writeQueue.isEmpty() || !m_readQueue.isEmpty())) {
+        Request request = !m_writeQueue.isEmpty() ? m_writeQueue.takeFirst() : m_readQueue.takeFirst();
+
+        QModbusDataUnit unit(request.registerType, request.registerAddress, request.size);
+        if (request.write) {
+            unit.setValues(request.values);
+        }
+        QModbusReply *modbusReply = sendModbusRequest(unit, request.slaveAddress, request.write);
+
+        if (!modbusReply) {
+            QString errorString = m_modbus->errorString();
+            qCWarning(dcModbusRtu()) << "Failed to send request to" << m_serialPort << errorString;
+            foreach (const Subscriber &subscriber, request.subscribers) {
+                // This might be called from within enqueueRead() or enqueueWrite(), the caller needs a chance to connect to the reply first
+                QTimer::singleShot(0, this, [=](){
+                    finishSubscriber(subscriber, QModbusDevice::ConnectionError, errorString, QVector<quint16>());
+                });
+            }
+            continue;
         }
 
-        // Parse the data unit and set reply result
-        const QModbusDataUnit unit = modbusReply->result();
-        reply->setResult(unit.values());
+        m_currentRequest = request;
+        m_currentReply = modbusReply;
+        m_busyTimer.start();
+
+        if (modbusReply->isFinished()) {
+            // Broadcasts are finished right away
+            QTimer::singleShot(0, modbusReply, [this, modbusReply](){
+                onRequestFinished(modbusReply);
+            });
+        } else {
+            connect(modbusReply, &QModbusReply::finished, this, [this, modbusReply](){
+                onRequestFinished(modbusReply);
+            });
+        }
+    }
+}
+
+void ModbusRtuMasterImpl::onRequestFinished(QModbusReply *modbusReply)
+{
+    if (modbusReply != m_currentReply) {
+        return;
+    }
+
+    Request request = m_currentRequest;
+    m_currentReply = nullptr;
+    m_currentRequest = Request();
+    modbusReply->deleteLater();
+
+    m_busyTime += m_busyTimer.elapsed();
+    m_sentRequests++;
+
+    if (modbusReply->error() != QModbusDevice::NoError) {
+        if (request.subscribers.count() > 1) {
+            // One of the merged ranges might not exist on the slave, don't let it fail the others
+            qCDebug(dcModbusRtu()) << "Coalesced read request failed with" << modbusReply->errorString() << "Retrying the" << request.subscribers.count() << "original requests separately.";
+            for (int i = request.subscribers.count() - 1; i >= 0; i--) {
+                const Subscriber &subscriber = request.subscribers.at(i);
+                Request single = request;
+                single.registerAddress = subscriber.registerAddress;
+                single.size = subscriber.size;
+                single.coalesce = false;
+                single.subscribers = {subscriber};
+                m_readQueue.prepend(single);
+            }
+        } else {
+            qCWarning(dcModbusRtu()) << (request.write ? "Write" : "Read") << request.registerType << "request finished with error" << modbusReply->error() << modbusReply->errorString();
+            foreach (const Subscriber &subscriber, request.subscribers) {
+                finishSubscriber(subscriber, modbusReply->error(), modbusReply->errorString(), QVector<quint16>());
+            }
+        }
+        sendNextRequest();
+        return;
+    }
+
+    const QVector<quint16> values = modbusReply->result().values();
+    if (request.write) {
+        invalidateCache(request.registerType, request.slaveAddress, request.registerAddress, request.size);
+        finishSubscriber(request.subscribers.first(), QModbusDevice::NoError, QString(), values);
+    } else {
+        // If a write to these registers has been queued while reading, the response is outdated already
+        if (!hasPendingWrite(request.registerType, request.slaveAddress, request.registerAddress, request.size)) {
+            CacheEntry entry;
+            entry.registerType = request.registerType;
+            entry.slaveAddress = request.slaveAddress;
+            entry.registerAddress = request.registerAddress;
+            entry.values = values;
+            entry.timer.start();
+            m_cache.append(entry);
+        }
+
+        foreach (const Subscriber &subscriber, request.subscribers) {
+            finishSubscriber(subscriber, QModbusDevice::NoError, QString(), values.mid(subscriber.registerAddress - request.registerAddress, subscriber.size));
+        }
+    }
+
+    sendNextRequest();
+}
+
+void ModbusRtuMasterImpl::abortCurrentRequest()
+{
+    if (!m_currentReply) {
+        return;
+    }
+
+    Request request = m_currentRequest;
+    m_currentReply->deleteLater();
+    m_currentReply = nullptr;
+    m_currentRequest = Request();
+
+    foreach (const Subscriber &subscriber, request.subscribers) {
+        finishSubscriber(subscriber, QModbusDevice::ConnectionError, QStringLiteral("Connection lost"), QVector<quint16>());
+    }
+    sendNextRequest();
+}
+
+void ModbusRtuMasterImpl::finishSubscriber(const Subscriber &subscriber, QModbusDevice::Error error, const QString &errorString, const QVector<quint16> &values)
+{
+    if (subscriber.reply.isNull()) {
+        return;
+    }
+
+    qint64 latency = subscriber.timer.elapsed();
+    m_latencySum += latency;
+    m_latencyMax = qMax(m_latencyMax, latency);
+    m_finishedRequests++;
+
+    ModbusRtuReplyImpl *reply = subscriber.reply;
+    reply->setFinished(true);
+    reply->setError(static_cast<ModbusRtuReply::Error>(error));
+    reply->setErrorString(errorString);
+    if (error != QModbusDevice::NoError) {
+        emit reply->errorOccurred(reply->error());
         emit reply->finished();
-    });
+        return;
+    }
 
-    return qobject_cast<ModbusRtuReply *>(reply);
-#else
-    Q_UNUSED(slaveAddress)
-    Q_UNUSED(registerAddress)
-    Q_UNUSED(values)
-    qCWarning(dcModbusRtu()) << "Modbus is not available on this platform.";
+    reply->setResult(values);
+    emit reply->finished();
+}
 
-    return nullptr;
-#endif
+QModbusReply *ModbusRtuMasterImpl::sendModbusRequest(const QModbusDataUnit &unit, int slaveAddress, bool write)
+{
+    if (write) {
+        return m_modbus->sendWriteRequest(unit, slaveAddress);
+    }
+    return m_modbus->sendReadRequest(unit, slaveAddress);
+}
+
+bool ModbusRtuMasterImpl::hasPendingWrite(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size) const
+{
+    foreach (const Request &request, m_writeQueue) {
+        if (request.registerType == registerType && request.slaveAddress == slaveAddress
+                && registerAddress < request.registerAddress + request.size && request.registerAddress < registerAddress + size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ModbusRtuMasterImpl::readCache(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size, QVector<quint16> *values)
+{
+    for (int i = m_cache.count() - 1; i >= 0; i--) {
+        const CacheEntry &entry = m_cache.at(i);
+        if (entry.timer.hasExpired(s_cacheTimeout)) {
+            m_cache.removeAt(i);
+            continue;
+        }
+        if (entry.registerType == registerType && entry.slaveAddress == slaveAddress
+                && registerAddress >= entry.registerAddress && registerAddress + size <= entry.registerAddress + entry.values.count()) {
+            *values = entry.values.mid(registerAddress - entry.registerAddress, size);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ModbusRtuMasterImpl::invalidateCache(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size)
+{
+    for (int i = m_cache.count() - 1; i >= 0; i--) {
+        const CacheEntry &entry = m_cache.at(i);
+        if (entry.registerType == registerType && entry.slaveAddress == slaveAddress
+                && registerAddress < entry.registerAddress + entry.values.count() && entry.registerAddress < registerAddress + size) {
+            m_cache.removeAt(i);
+        }
+    }
+}
+
+int ModbusRtuMasterImpl::maxReadSize(QModbusDataUnit::RegisterType registerType)
+{
+    // Limits of a single modbus RTU read frame
+    if (registerType == QModbusDataUnit::Coils || registerType == QModbusDataUnit::DiscreteInputs) {
+        return 2000;
+    }
+    return 125;
+}
+#endif // WITH_QTSERIALBUS
+
+void ModbusRtuMasterImpl::logStatistics()
+{
+    qint64 period = m_statisticsTimer.restart();
+    if (m_finishedRequests > 0) {
+        qCDebug(dcModbusRtu()).nospace() << "Bus statistics for " << m_serialPort << ": utilization " << (period > 0 ? m_busyTime * 100 / period : 0) << "%"
+                                         << ", frames sent " << m_sentRequests << ", coalesced requests " << m_coalescedRequests << ", cache hits " << m_cacheHits
+                                         << ", latency avg " << m_latencySum / m_finishedRequests << "ms, max " << m_latencyMax << "ms";
+    }
+
+    m_busyTime = 0;
+    m_sentRequests = 0;
+    m_coalescedRequests = 0;
+    m_cacheHits = 0;
+    m_finishedRequests = 0;
+    m_latencySum = 0;
+    m_latencyMax = 0;
 }
 
 }
@@ -26,7 +26,9 @@
 #define MODBUSRTUMASTERIMPL_H
 
 #include <QObject>
+#include <QPointer>
 #include <QSerialPort>
+#include <QElapsedTimer>
 
 #ifdef WITH_QTSERIALBUS
 #include <QtSerialBus/QtSerialBus>
@@ -36,6 +38,8 @@
 
 namespace nymeaserver {
 
+class ModbusRtuReplyImpl;
+
 class ModbusRtuMasterImpl : public ModbusRtuMaster
 {
     Q_OBJECT
@@ -82,11 +86,68 @@ public:
     ModbusRtuReply *writeCoils(int slaveAddress, int registerAddress, const QVector<quint16> &values) override;
     ModbusRtuReply *writeHoldingRegisters(int slaveAddress, int registerAddress, const QVector<quint16> &values) override;
 
+#ifdef WITH_QTSERIALBUS
+protected:
+    // Hands a request to the modbus client. Only one request is on the wire at a time.
+    virtual QModbusReply *sendModbusRequest(const QModbusDataUnit &unit, int slaveAddress, bool write);
+#endif
+
+private slots:
+    void logStatistics();
+
 private:
     QUuid m_modbusUuid;
     bool m_connected = false;
 
 #ifdef WITH_QTSERIALBUS
+    // Requests are not handed to the modbus client directly but scheduled here, one at a time.
+    // Writes go before reads, reads of adjacent or overlapping registers on the same slave are merged
+    // into one frame and read responses are shared with further readers for a short time.
+    struct Subscriber {
+        QPointer<ModbusRtuReplyImpl> reply;
+        int registerAddress = 0;
+        quint16 size = 0;
+        QElapsedTimer timer;
+    };
+
+    struct Request {
+        QModbusDataUnit::RegisterType registerType = QModbusDataUnit::Invalid;
+        int slaveAddress = 0;
+        int registerAddress = 0;
+        quint16 size = 0;
+        QVector<quint16> values;
+        bool write = false;
+        bool coalesce = true;
+        QList<Subscriber> subscribers;
+    };
+
+    struct CacheEntry {
+        QModbusDataUnit::RegisterType registerType = QModbusDataUnit::Invalid;
+        int slaveAddress = 0;
+        int registerAddress = 0;
+        QVector<quint16> values;
+        QElapsedTimer timer;
+    };
+
+    ModbusRtuReplyImpl *enqueueRead(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size);
+    ModbusRtuReplyImpl *enqueueWrite(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, const QVector<quint16> &values);
+    void sendNextRequest();
+    void onRequestFinished(QModbusReply *modbusReply);
+    void abortCurrentRequest();
+    void finishSubscriber(const Subscriber &subscriber, QModbusDevice::Error error, const QString &errorString, const QVector<quint16> &values);
+    bool hasPendingWrite(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size) const;
+
+    bool readCache(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size, QVector<quint16> *values);
+    void invalidateCache(QModbusDataUnit::RegisterType registerType, int slaveAddress, int registerAddress, quint16 size);
+    static int maxReadSize(QModbusDataUnit::RegisterType registerType);
+
+    static const int s_cacheTimeout;
+
+    QList<Request> m_writeQueue;
+    QList<Request> m_readQueue;
+    Request m_currentRequest;
+    QModbusReply *m_currentReply = nullptr;
+    QList<CacheEntry> m_cache;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     QModbusRtuSerialClient *m_modbus = nullptr;
@@ -103,6 +164,17 @@ private:
     QSerialPort::StopBits m_stopBits;
     int m_numberOfRetries = 3;
     int m_timeout = 100;
+
+    // Bus statistics, logged and reset periodically
+    QElapsedTimer m_statisticsTimer;
+    QElapsedTimer m_busyTimer;
+    qint64 m_busyTime = 0;
+    int m_sentRequests = 0;
+    int m_coalescedRequests = 0;
+    int m_cacheHits = 0;
+    int m_finishedRequests = 0;
+    qint64 m_latencySum = 0;
+    qint64 m_latencyMax = 0;
 };
 
 }
@@ -81,12 +81,17 @@ NetworkDeviceDiscoveryImpl::NetworkDeviceDiscoveryImpl(QObject *parent) :
         }
     });
 
-    // Timer for updating the monitors
+    // Timer for the next due monitor, restarted each time the monitor schedule changes
     m_monitorTimer = new QTimer(this);
-    m_monitorTimer->setInterval(10000);
-    m_monitorTimer->setSingleShot(false);
+    m_monitorTimer->setSingleShot(true);
     connect(m_monitorTimer, &QTimer::timeout, this, &NetworkDeviceDiscoveryImpl::evaluateMonitors);
 
+    // Timer for writing modified cache entries to disk in one go
+    m_cacheSaveTimer = new QTimer(this);
+    m_cacheSaveTimer->setInterval(10000);
+    m_cacheSaveTimer->setSingleShot(true);
+    connect(m_cacheSaveTimer, &QTimer::timeout, this, &NetworkDeviceDiscoveryImpl::writeNetworkDeviceCache);
+
     if (!arpAvailable && !m_ping->available()) {
         qCWarning(dcNetworkDeviceDiscovery()) << "Network device discovery is not available on this system.";
     } else {
@@ -95,16 +100,11 @@ NetworkDeviceDiscoveryImpl::NetworkDeviceDiscoveryImpl(QObject *parent) :
 
     m_cacheSettings = new QSettings(NymeaSettings::cachePath() + "/network-device-discovery.cache", QSettings::IniFormat);
     loadNetworkDeviceCache();
-
-    // Start the timer only if the resource is available
-    if (available()) {
-        // Start the monitor timer in any case, we do also the cache cleanup there...
-        m_monitorTimer->start();
-    }
 }
 
 NetworkDeviceDiscoveryImpl::~NetworkDeviceDiscoveryImpl()
 {
+    writeNetworkDeviceCache();
     delete m_cacheSettings;
 }
 
@@ -240,15 +240,10 @@ NetworkDeviceMonitor *NetworkDeviceDiscoveryImpl::registerMonitor(Thing *thing)
         }
     } // else we use the MAC address mode
 
-    // Check if we already have a monitor for these settings...
-    NetworkDeviceMonitorImpl *internalMonitor = nullptr;
-    for (QHash<NetworkDeviceMonitorImpl *, QVector<NetworkDeviceMonitorImpl *>>::const_iterator iterator = m_monitors.cbegin(),
-         end = m_monitors.cend(); iterator != end; ++iterator) {
-        if (iterator.key()->address() == address && iterator.key()->macAddress() == macAddress && iterator.key()->hostName() == hostName) {
-            internalMonitor = iterator.key();
-            break;
-        }
-    }
+    // Check if we already have a monitor for this target. All plugins monitoring the same
+    // network device share one internal monitor, so the device gets probed only once.
+    QString target = monitorTarget(mode, macAddress, hostName, address);
+    NetworkDeviceMonitorImpl *internalMonitor = m_monitorTargets.value(target);
 
     bool newMonitor = true;
     if (internalMonitor) {
@@ -258,6 +253,16 @@ NetworkDeviceMonitor *NetworkDeviceDiscoveryImpl::registerMonitor(Thing *thing)
         // Create a new monitor for the internal use
         internalMonitor = new NetworkDeviceMonitorImpl(macAddress, hostName, address, this);
         m_monitors.insert(internalMonitor, QVector<NetworkDeviceMonitorImpl *>());
+        m_monitorTargets.insert(target, internalMonitor);
+
+        // Whenever the device has been seen or its state changed, the next evaluation moves accordingly
+        auto reschedule = [this, internalMonitor](){
+            if (m_monitors.contains(internalMonitor)) {
+                scheduleMonitor(internalMonitor, nextMonitorEvaluation(internalMonitor));
+            }
+        };
+        connect(internalMonitor, &NetworkDeviceMonitorImpl::lastSeenChanged, this, reschedule);
+        connect(internalMonitor, &NetworkDeviceMonitorImpl::reachableChanged, this, reschedule);
     }
 
     internalMonitor->setMonitorMode(mode);
@@ -319,8 +324,10 @@ NetworkDeviceMonitor *NetworkDeviceDiscoveryImpl::registerMonitor(Thing *thing)
     qCDebug(dcNetworkDeviceDiscovery()) << "Registered successfully" << pluginMonitor;
 
     // In case this is a new monitor, let's evaluate it right the way so know asap if the device is reachable or not
-    if (newMonitor)
+    if (newMonitor) {
         evaluateMonitor(internalMonitor);
+        scheduleMonitor(internalMonitor, nextMonitorEvaluation(internalMonitor));
+    }
 
     return pluginMonitor;
 }
@@ -561,6 +568,7 @@ void NetworkDeviceDiscoveryImpl::loadNetworkDeviceCache()
     qCInfo(dcNetworkDeviceDiscovery()) << "Loading cached network device information from" << m_cacheSettings->fileName();
 
     m_networkInfoCache.clear();
+    m_cacheMacIndex.clear();
     QDateTime currentDateTime = QDateTime::currentDateTime();
 
     uint cacheVersion = m_cacheSettings->value("version", 0).toUInt();
@@ -604,6 +612,7 @@ void NetworkDeviceDiscoveryImpl::loadNetworkDeviceCache()
             m_cacheSettings->endGroup(); // address
             qCDebug(dcNetworkDeviceDiscovery()) << "Loaded cached" << info << "last seen" << lastSeen.toString();
             m_networkInfoCache.append(info);
+            indexCacheEntry(info);
             m_lastSeen[info.address()] = lastSeen;
         }
         m_cacheSettings->endGroup(); // NetworkDeviceInfos
@@ -633,14 +642,22 @@ void NetworkDeviceDiscoveryImpl::removeFromNetworkDeviceCache(const QHostAddress
     if (address.isNull())
         return;
 
+    int index = m_networkInfoCache.indexFromHostAddress(address);
+    if (index >= 0)
+        unindexCacheEntry(m_networkInfoCache.at(index));
+
     m_networkInfoCache.removeHostAddress(address);
     m_lastSeen.remove(address);
+    m_dirtyCacheEntries.remove(address);
     m_cacheSettings->beginGroup("NetworkDeviceInfos");
     m_cacheSettings->beginGroup(address.toString());
     m_cacheSettings->remove("");
     m_cacheSettings->endGroup(); // address
     m_cacheSettings->endGroup(); // NetworkDeviceInfos
-    m_cacheSettings->sync();
+
+    // The removal gets synced together with the next batch of modified entries
+    if (!m_cacheSaveTimer->isActive())
+        m_cacheSaveTimer->start();
 }
 
 void NetworkDeviceDiscoveryImpl::saveNetworkDeviceCache(const NetworkDeviceInfo &deviceInfo)
@@ -648,27 +665,70 @@ void NetworkDeviceDiscoveryImpl::saveNetworkDeviceCache(const NetworkDeviceInfo
     if (!deviceInfo.isValid() || !deviceInfo.isComplete() || deviceInfo.address() == QHostAddress::LocalHost)
         return;
 
-    m_cacheSettings->beginGroup("NetworkDeviceInfos");
-    m_cacheSettings->beginGroup(deviceInfo.address().toString());
-    m_cacheSettings->setValue("hostName", deviceInfo.hostName());
-    m_cacheSettings->setValue("interface", deviceInfo.networkInterface().name());
-    m_cacheSettings->setValue("lastSeen", convertMinuteBased(m_lastSeen.value(deviceInfo.address())).toMSecsSinceEpoch());
-
-    if (!deviceInfo.macAddressInfos().isEmpty()){
-        m_cacheSettings->beginWriteArray("mac");
-        for (int i = 0; i < deviceInfo.macAddressInfos().size(); i++) {
-            m_cacheSettings->setArrayIndex(i);
-            m_cacheSettings->setValue("mac", deviceInfo.macAddressInfos().at(i).macAddress().toString());
-            m_cacheSettings->setValue("vendor", deviceInfo.macAddressInfos().at(i).vendorName());
+    // Only mark the entry as modified, the content will be written by writeNetworkDeviceCache()
+    m_dirtyCacheEntries.insert(deviceInfo.address());
+    if (!m_cacheSaveTimer->isActive())
+        m_cacheSaveTimer->start();
+}
+
+void NetworkDeviceDiscoveryImpl::writeNetworkDeviceCache()
+{
+    m_cacheSaveTimer->stop();
+
+    foreach (const QHostAddress &address, m_dirtyCacheEntries) {
+        int index = m_networkInfoCache.indexFromHostAddress(address);
+        if (index < 0)
+            continue;
+
+        const NetworkDeviceInfo deviceInfo = m_networkInfoCache.at(index);
+        if (!deviceInfo.isValid() || !deviceInfo.isComplete())
+            continue;
+
+        m_cacheSettings->beginGroup("NetworkDeviceInfos");
+        m_cacheSettings->beginGroup(deviceInfo.address().toString());
+        m_cacheSettings->setValue("hostName", deviceInfo.hostName());
+        m_cacheSettings->setValue("interface", deviceInfo.networkInterface().name());
+        m_cacheSettings->setValue("lastSeen", convertMinuteBased(m_lastSeen.value(deviceInfo.address())).toMSecsSinceEpoch());
+
+        if (!deviceInfo.macAddressInfos().isEmpty()){
+            m_cacheSettings->beginWriteArray("mac");
+            for (int i = 0; i < deviceInfo.macAddressInfos().size(); i++) {
+                m_cacheSettings->setArrayIndex(i);
+                m_cacheSettings->setValue("mac", deviceInfo.macAddressInfos().at(i).macAddress().toString());
+                m_cacheSettings->setValue("vendor", deviceInfo.macAddressInfos().at(i).vendorName());
+            }
+            m_cacheSettings->endArray(); // mac
         }
-        m_cacheSettings->endArray(); // mac
+
+        m_cacheSettings->endGroup(); // address
+        m_cacheSettings->endGroup(); // NetworkDeviceInfos
     }
 
-    m_cacheSettings->endGroup(); // address
-    m_cacheSettings->endGroup(); // NetworkDeviceInfos
+    if (!m_dirtyCacheEntries.isEmpty())
+        qCDebug(dcNetworkDeviceDiscovery()) << "Writing" << m_dirtyCacheEntries.count() << "modified network device cache entries";
+
+    m_dirtyCacheEntries.clear();
     m_cacheSettings->sync();
 }
 
+void NetworkDeviceDiscoveryImpl::indexCacheEntry(const NetworkDeviceInfo &deviceInfo)
+{
+    foreach (const MacAddressInfo &macAddressInfo, deviceInfo.macAddressInfos()) {
+        if (!macAddressInfo.macAddress().isNull()) {
+            m_cacheMacIndex.insert(macAddressInfo.macAddress(), deviceInfo.address());
+        }
+    }
+}
+
+void NetworkDeviceDiscoveryImpl::unindexCacheEntry(const NetworkDeviceInfo &deviceInfo)
+{
+    foreach (const MacAddressInfo &macAddressInfo, deviceInfo.macAddressInfos()) {
+        if (m_cacheMacIndex.value(macAddressInfo.macAddress()) == deviceInfo.address()) {
+            m_cacheMacIndex.remove(macAddressInfo.macAddress());
+        }
+    }
+}
+
 void NetworkDeviceDiscoveryImpl::updateCache(const NetworkDeviceInfo &deviceInfo)
 {
     // Update monitors
@@ -688,8 +748,10 @@ void NetworkDeviceDiscoveryImpl::updateCache(const NetworkDeviceInfo &deviceInfo
     if (index < 0) {
         m_networkInfoCache.append(deviceInfo);
     } else {
+        unindexCacheEntry(m_networkInfoCache.at(index));
         m_networkInfoCache[index] = deviceInfo;
     }
+    indexCacheEntry(deviceInfo);
 
     saveNetworkDeviceCache(deviceInfo);
 }
@@ -785,48 +847,113 @@ void NetworkDeviceDiscoveryImpl::evaluateMonitor(NetworkDeviceMonitorImpl *monit
     });
 }
 
+QString NetworkDeviceDiscoveryImpl::monitorTarget(NetworkDeviceInfo::MonitorMode mode, const MacAddress &macAddress, const QString &hostName, const QHostAddress &address)
+{
+    switch (mode) {
+    case NetworkDeviceInfo::MonitorModeMac:
+        return "mac:" + macAddress.toString();
+    case NetworkDeviceInfo::MonitorModeHostName:
+        return "host:" + hostName;
+    case NetworkDeviceInfo::MonitorModeIp:
+        return "ip:" + address.toString();
+    }
+
+    return QString();
+}
+
+QString NetworkDeviceDiscoveryImpl::monitorTarget(NetworkDeviceMonitorImpl *monitor)
+{
+    return monitorTarget(monitor->monitorMode(), monitor->macAddress(), monitor->hostName(), monitor->address());
+}
+
+QDateTime NetworkDeviceDiscoveryImpl::nextMonitorEvaluation(NetworkDeviceMonitorImpl *monitor) const
+{
+    // A reachable device does not need any attention until it has been silent for the monitor interval,
+    // all other monitors get retried periodically
+    QDateTime retry = QDateTime::currentDateTime().addSecs(m_monitorRetryInterval);
+    if (!monitor->reachable() || monitor->lastSeen().isNull())
+        return retry;
+
+    return qMax(retry, monitor->lastSeen().addSecs(m_monitorInterval));
+}
+
+void NetworkDeviceDiscoveryImpl::scheduleMonitor(NetworkDeviceMonitorImpl *monitor, const QDateTime &deadline)
+{
+    unscheduleMonitor(monitor);
+
+    qint64 timestamp = deadline.toMSecsSinceEpoch();
+    m_monitorDeadlines.insert(monitor, timestamp);
+    m_monitorSchedule.insert(timestamp, monitor);
+    restartMonitorTimer();
+}
+
+void NetworkDeviceDiscoveryImpl::unscheduleMonitor(NetworkDeviceMonitorImpl *monitor)
+{
+    if (!m_monitorDeadlines.contains(monitor))
+        return;
+
+    m_monitorSchedule.remove(m_monitorDeadlines.take(monitor), monitor);
+}
+
+void NetworkDeviceDiscoveryImpl::restartMonitorTimer()
+{
+    // Start the timer only if the resource is available
+    if (m_monitorSchedule.isEmpty() || !available()) {
+        m_monitorTimer->stop();
+        return;
+    }
+
+    qint64 timeout = m_monitorSchedule.firstKey() - QDateTime::currentMSecsSinceEpoch();
+    m_monitorTimer->start(static_cast<int>(qMax<qint64>(0, timeout)));
+}
+
+void NetworkDeviceDiscoveryImpl::markSeen(NetworkDeviceMonitorImpl *monitor, const QDateTime &dateTime)
+{
+    // Busy hosts send a lot of ARP traffic, no need to update the monitor for each packet
+    if (monitor->reachable() && monitor->lastSeen().isValid() && monitor->lastSeen().msecsTo(dateTime) < 1000)
+        return;
+
+    monitor->setLastSeen(dateTime);
+    monitor->setReachable(true);
+}
+
 void NetworkDeviceDiscoveryImpl::processArpTraffic(const QNetworkInterface &interface, const QHostAddress &address, const MacAddress &macAddress)
 {
     QDateTime currentDateTime = QDateTime::currentDateTime();
     m_lastSeen[address] = currentDateTime;
 
-    // Update monitors and cache
-    for (int i = 0; i < m_networkInfoCache.count(); i++) {
-        switch (m_networkInfoCache.at(i).monitorMode()) {
-        case NetworkDeviceInfo::MonitorModeMac:
-            if (m_networkInfoCache.at(i).macAddressInfos().hasMacAddress(macAddress) &&
-                m_networkInfoCache.at(i).address() != address) {
-
-                QHostAddress oldAddress = m_networkInfoCache.at(i).address();
-                qCDebug(dcNetworkDeviceDiscovery()) << "Host" << macAddress.toString() << "changed the IP address from"
-                                                    << oldAddress.toString()
-                                                    << "-->"
-                                                    << address.toString();
-
-                NetworkDeviceInfo info = m_networkInfoCache.at(i);
-                removeFromNetworkDeviceCache(oldAddress);
-                info.setAddress(address);
+    // Update the cache entry of this host
+    QHostAddress oldAddress = m_cacheMacIndex.value(macAddress);
+    int index = m_networkInfoCache.indexFromHostAddress(oldAddress.isNull() ? address : oldAddress);
+    if (index >= 0 && !oldAddress.isNull() && oldAddress != address) {
+        qCDebug(dcNetworkDeviceDiscovery()) << "Host" << macAddress.toString() << "changed the IP address from"
+                                            << oldAddress.toString()
+                                            << "-->"
+                                            << address.toString();
+
+        NetworkDeviceInfo info = m_networkInfoCache.at(index);
+        removeFromNetworkDeviceCache(oldAddress);
+        info.setAddress(address);
+
+        updateCache(info);
+    } else if (index >= 0) {
+        saveNetworkDeviceCache(m_networkInfoCache.at(index));
+    }
 
-                updateCache(info);
+    // Passively update the monitors of this host, which postpones their next ping
+    NetworkDeviceMonitorImpl *monitor = m_monitorTargets.value(monitorTarget(NetworkDeviceInfo::MonitorModeMac, macAddress, QString(), QHostAddress()));
+    if (monitor) {
+        index = m_networkInfoCache.indexFromHostAddress(address);
+        if (index >= 0)
+            monitor->setNetworkDeviceInfo(m_networkInfoCache.at(index));
 
-                foreach (NetworkDeviceMonitorImpl *monitor, m_monitors.keys()) {
-                    if (monitor->macAddress() == macAddress) {
-                        monitor->setNetworkDeviceInfo(info);
-                        monitor->setLastSeen(currentDateTime);
-                        monitor->setReachable(true);
-                        break;
-                    }
-                }
-                break;
-            }
-            break;
-        case NetworkDeviceInfo::MonitorModeHostName:
-        case NetworkDeviceInfo::MonitorModeIp:
-            saveNetworkDeviceCache(m_networkInfoCache.at(i));
-            break;
-        }
+        markSeen(monitor, currentDateTime);
     }
 
+    monitor = m_monitorTargets.value(monitorTarget(NetworkDeviceInfo::MonitorModeIp, MacAddress(), QString(), address));
+    if (monitor)
+        markSeen(monitor, currentDateTime);
+
     // Check if we have currently  reply running
     if (!m_currentDiscoveryReply)
         return;
@@ -946,6 +1073,9 @@ void NetworkDeviceDiscoveryImpl::cleanupPluginMonitor(NetworkDeviceMonitorImpl *
                 qCDebug(dcNetworkDeviceDiscovery()) << "No monitor registered for this network device any more. Unregister internal monitor" << internalMonitor;
                 // Last refference for this monitor, nobody need this any more. Clean up...
                 m_monitors.remove(internalMonitor);
+                m_monitorTargets.remove(monitorTarget(internalMonitor));
+                unscheduleMonitor(internalMonitor);
+                restartMonitorTimer();
                 internalMonitor->deleteLater();
             }
         }
@@ -978,9 +1108,15 @@ void NetworkDeviceDiscoveryImpl::onArpRequstReceived(const QNetworkInterface &in
 
 void NetworkDeviceDiscoveryImpl::evaluateMonitors()
 {
+    qint64 currentTimestamp = QDateTime::currentMSecsSinceEpoch();
     bool monitorRequiresRediscovery = false;
-    foreach (NetworkDeviceMonitorImpl *monitor, m_monitors.keys()) {
+
+    // Only the monitors which are due get evaluated, the deadline of all others has been
+    // postponed because the device has been seen in the meantime
+    while (!m_monitorSchedule.isEmpty() && m_monitorSchedule.firstKey() <= currentTimestamp) {
+        NetworkDeviceMonitorImpl *monitor = m_monitorSchedule.first();
         evaluateMonitor(monitor);
+        scheduleMonitor(monitor, nextMonitorEvaluation(monitor));
 
         // Check if there is any monitor which has not be seen since
         if (!monitor->reachable() && monitor->lastConnectionAttempt().isValid() && longerAgoThan(monitor->lastSeen(), m_monitorInterval)) {
@@ -994,6 +1130,8 @@ void NetworkDeviceDiscoveryImpl::evaluateMonitors()
         connect(reply, &NetworkDeviceDiscoveryReply::finished, reply, &NetworkDeviceDiscoveryReply::deleteLater);
     }
 
+    restartMonitorTimer();
+
     // FIXME
     // // Do some cache housekeeping if required
     // if (m_lastCacheHousekeeping.addDays(1) < QDateTime::currentDateTime()) {
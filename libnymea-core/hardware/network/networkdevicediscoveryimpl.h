@@ -26,6 +26,8 @@
 #define NETWORKDEVICEDISCOVERYIMPL_H
 
 #include <QHash>
+#include <QSet>
+#include <QMap>
 #include <QObject>
 #include <QSettings>
 #include <QDateTime>
@@ -94,12 +96,14 @@ private:
 
     QTimer *m_discoveryTimer = nullptr;
     QTimer *m_monitorTimer = nullptr;
+    QTimer *m_cacheSaveTimer = nullptr;
 
     QDateTime m_lastDiscovery;
     QDateTime m_lastCacheHousekeeping;
 
     uint m_rediscoveryInterval = 300; // 5 min
     uint m_monitorInterval = 60; // 1 min
+    uint m_monitorRetryInterval = 10; // s
     uint m_cacheCleanupPeriod = 30; // days
 
     NetworkDeviceDiscoveryReplyImpl *m_currentDiscoveryReply = nullptr;
@@ -108,6 +112,12 @@ private:
     QList<PingReply *> m_runningPingReplies;
 
     QHash<NetworkDeviceMonitorImpl *, QVector<NetworkDeviceMonitorImpl *>> m_monitors;
+    QHash<QString, NetworkDeviceMonitorImpl *> m_monitorTargets;
+
+    // Internal monitors ordered by the time they have to be evaluated next (msecs since epoch)
+    QMultiMap<qint64, NetworkDeviceMonitorImpl *> m_monitorSchedule;
+    QHash<NetworkDeviceMonitorImpl *, qint64> m_monitorDeadlines;
+
     QHash<QHostAddress, QDateTime> m_lastSeen;
 
     QHash<MacAddress, QString> m_macVendorCache;
@@ -116,6 +126,8 @@ private:
 
     QSettings *m_cacheSettings;
     NetworkDeviceInfos m_networkInfoCache;
+    QHash<MacAddress, QHostAddress> m_cacheMacIndex;
+    QSet<QHostAddress> m_dirtyCacheEntries;
 
     void pingAllNetworkDevices();
 
@@ -127,10 +139,21 @@ private:
     void removeFromNetworkDeviceCache(const MacAddress &macAddress);
     void removeFromNetworkDeviceCache(const QHostAddress &address);
     void saveNetworkDeviceCache(const NetworkDeviceInfo &deviceInfo);
+    void indexCacheEntry(const NetworkDeviceInfo &deviceInfo);
+    void unindexCacheEntry(const NetworkDeviceInfo &deviceInfo);
 
     void updateCache(const NetworkDeviceInfo &deviceInfo);
     void evaluateMonitor(NetworkDeviceMonitorImpl *monitor);
 
+    // Monitor scheduling
+    static QString monitorTarget(NetworkDeviceInfo::MonitorMode mode, const MacAddress &macAddress, const QString &hostName, const QHostAddress &address);
+    static QString monitorTarget(NetworkDeviceMonitorImpl *monitor);
+    QDateTime nextMonitorEvaluation(NetworkDeviceMonitorImpl *monitor) const;
+    void scheduleMonitor(NetworkDeviceMonitorImpl *monitor, const QDateTime &deadline);
+    void unscheduleMonitor(NetworkDeviceMonitorImpl *monitor);
+    void restartMonitorTimer();
+    void markSeen(NetworkDeviceMonitorImpl *monitor, const QDateTime &dateTime);
+
     void processArpTraffic(const QNetworkInterface &interface, const QHostAddress &address, const MacAddress &macAddress);
 
     // Time helpers
@@ -144,6 +167,7 @@ private slots:
     void onArpResponseReceived(const QNetworkInterface &interface, const QHostAddress &address, const MacAddress &macAddress);
     void onArpRequstReceived(const QNetworkInterface &interface, const QHostAddress &address, const MacAddress &macAddress);
     void evaluateMonitors();
+    void writeNetworkDeviceCache();
     void finishDiscovery();
 
     void onPluginMonitorDeleted(QObject *);
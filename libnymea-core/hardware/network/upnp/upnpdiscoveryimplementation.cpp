@@ -94,6 +94,30 @@ QByteArray buildNotifyMessage(const QByteArray &location, const QByteArray &uuid
                        "\r\n");
 }
 
+QHash<QByteArray, QString> parseHeaders(const QByteArray &data)
+{
+    QHash<QByteArray, QString> headers;
+    foreach (const QByteArray &line, data.split('\n')) {
+        int separatorIndex = line.indexOf(':');
+        if (separatorIndex <= 0) {
+            continue;
+        }
+        headers.insert(line.left(separatorIndex).trimmed().toUpper(), QString::fromUtf8(line.mid(separatorIndex + 1).trimmed()));
+    }
+    return headers;
+}
+
+int parseMaxAge(const QString &cacheControl)
+{
+    foreach (const QString &directive, cacheControl.split(',')) {
+        QStringList parts = directive.trimmed().split('=');
+        if (parts.count() == 2 && parts.first().trimmed().toLower() == "max-age") {
+            return qMax(0, parts.last().trimmed().toInt());
+        }
+    }
+    return 0;
+}
+
 }
 
 /*! Construct the hardware resource UpnpDiscoveryImplementation with the given \a parent. */
@@ -159,12 +183,58 @@ UpnpDiscoveryReply *UpnpDiscoveryImplementation::discoverDevices(const QString &
     return reply.data();
 }
 
-void UpnpDiscoveryImplementation::requestDeviceInformation(const QNetworkRequest &networkRequest, const UpnpDeviceDescriptor &upnpDeviceDescriptor)
+void UpnpDiscoveryImplementation::requestDeviceInformation(const QNetworkRequest &networkRequest, const UpnpDeviceDescriptor &upnpDeviceDescriptor, const QString &usn, int maxAge)
 {
+    // Devices announce several USNs with the same description, only fetch it once per distinct request
+    QNetworkReply *pendingReply = m_pendingRequests.value(pendingRequestKey(networkRequest));
+    if (pendingReply) {
+        InformationRequest &informationRequest = m_informationRequestList[pendingReply];
+        if (!usn.isEmpty() && !informationRequest.usns.contains(usn)) {
+            informationRequest.usns.append(usn);
+        }
+        informationRequest.maxAge = informationRequest.maxAge == 0 ? maxAge : qMin(informationRequest.maxAge, maxAge);
+        return;
+    }
+
     qCDebug(dcUpnp()) << "Requesting device information for" << networkRequest.url();
     QNetworkReply *replay = m_networkAccessManager->get(networkRequest);
     connect(replay, &QNetworkReply::finished, this, &UpnpDiscoveryImplementation::replyFinished);
-    m_informationRequestList.insert(replay, upnpDeviceDescriptor);
+
+    InformationRequest informationRequest;
+    informationRequest.descriptor = upnpDeviceDescriptor;
+    if (!usn.isEmpty()) {
+        informationRequest.usns.append(usn);
+    }
+    informationRequest.maxAge = maxAge;
+    m_informationRequestList.insert(replay, informationRequest);
+    m_pendingRequests.insert(pendingRequestKey(networkRequest), replay);
+}
+
+UpnpDiscoveryImplementation::PendingRequestKey UpnpDiscoveryImplementation::pendingRequestKey(const QNetworkRequest &networkRequest)
+{
+    // The location and the user agent set by the discovering plugin make up the effective request
+    return qMakePair(networkRequest.url(), networkRequest.header(QNetworkRequest::UserAgentHeader).toString());
+}
+
+void UpnpDiscoveryImplementation::cleanupDescriptorCache()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    foreach (const QString &usn, m_descriptorCache.keys()) {
+        if (m_descriptorCache.value(usn).expiry <= now) {
+            m_descriptorCache.remove(usn);
+        }
+    }
+}
+
+bool UpnpDiscoveryImplementation::isLocalAddress(const QHostAddress &address)
+{
+    // Querying the addresses is expensive and there is no notification for changes,
+    // refresh them periodically instead of for each datagram
+    if (!m_localAddressesTimer.isValid() || m_localAddressesTimer.hasExpired(30000)) {
+        m_localAddresses = QNetworkInterface::allAddresses();
+        m_localAddressesTimer.start();
+    }
+    return m_localAddresses.contains(address);
 }
 
 QByteArray UpnpDiscoveryImplementation::serverUuid() const
@@ -284,51 +354,77 @@ void UpnpDiscoveryImplementation::error(QAbstractSocket::SocketError error)
 
 void UpnpDiscoveryImplementation::readData()
 {
-    QByteArray data;
-    quint16 port;
-    QHostAddress hostAddress;
-    QUrl location;
-
-    // read the answere from the multicast
-    while (m_socket->hasPendingDatagrams()) {
+    // read all datagrams from the multicast, a discovery causes a burst of responses
+    while (m_socket && m_socket->hasPendingDatagrams()) {
+        QByteArray data;
+        quint16 port = 0;
+        QHostAddress hostAddress;
         data.resize(m_socket->pendingDatagramSize());
         m_socket->readDatagram(data.data(), data.size(), &hostAddress, &port);
+        processDatagram(data, hostAddress, port);
     }
+}
 
-    if (data.contains("M-SEARCH") && !QNetworkInterface::allAddresses().contains(hostAddress)) {
+void UpnpDiscoveryImplementation::processDatagram(const QByteArray &data, const QHostAddress &hostAddress, quint16 port)
+{
+    if (data.contains("M-SEARCH") && !isLocalAddress(hostAddress)) {
         qCDebug(dcUpnp()) << "UPnP discovery request received. Responding...";
         respondToSearchRequest(hostAddress, port);
         return;
     }
 
-    if (data.contains("NOTIFY") && !QNetworkInterface::allAddresses().contains(hostAddress)) {
+    if (data.contains("NOTIFY") && !isLocalAddress(hostAddress)) {
+        processNotification(data);
         emit upnpNotify(data);
         return;
     }
 
     // if the data contains the HTTP OK header...
     if (data.contains("HTTP/1.1 200 OK")) {
-        const QStringList lines = QString(data).split("\r\n");
-        foreach (const QString& line, lines) {
-            int separatorIndex = line.indexOf(':');
-            QString key = line.left(separatorIndex).toUpper();
-            QString value = line.mid(separatorIndex+1).trimmed();
-
-            // get location
-            if (key.contains("LOCATION") || key.contains("location") || key.contains("Location")) {
-                location = QUrl(value);
+        processSearchResponse(data, hostAddress);
+    }
+}
+
+void UpnpDiscoveryImplementation::processSearchResponse(const QByteArray &data, const QHostAddress &hostAddress)
+{
+    if (m_discoverRequests.isEmpty()) {
+        return;
+    }
+
+    const QHash<QByteArray, QString> headers = parseHeaders(data);
+    QUrl location = QUrl(headers.value("LOCATION"));
+    QString usn = headers.value("USN");
+
+    // Known device with a description which hasn't expired yet
+    if (m_descriptorCache.contains(usn)) {
+        const CachedDescriptor &cached = m_descriptorCache.value(usn);
+        if (cached.expiry > QDateTime::currentDateTimeUtc() && cached.descriptor.location() == location) {
+            foreach (UpnpDiscoveryRequest *upnpDiscoveryRequest, m_discoverRequests) {
+                upnpDiscoveryRequest->addDeviceDescriptor(cached.descriptor);
             }
+            return;
         }
+        m_descriptorCache.remove(usn);
+    }
 
-        UpnpDeviceDescriptor upnpDeviceDescriptor;
-        upnpDeviceDescriptor.setLocation(location);
-        upnpDeviceDescriptor.setHostAddress(hostAddress);
-        upnpDeviceDescriptor.setPort(location.port());
+    UpnpDeviceDescriptor upnpDeviceDescriptor;
+    upnpDeviceDescriptor.setLocation(location);
+    upnpDeviceDescriptor.setHostAddress(hostAddress);
+    upnpDeviceDescriptor.setPort(location.port());
 
-        foreach (UpnpDiscoveryRequest *upnpDiscoveryRequest, m_discoverRequests) {
-            QNetworkRequest networkRequest = upnpDiscoveryRequest->createNetworkRequest(upnpDeviceDescriptor);
-            requestDeviceInformation(networkRequest, upnpDeviceDescriptor);
-        }
+    // All running discoveries receive the result, discoveries creating the same request share one fetch
+    const int maxAge = parseMaxAge(headers.value("CACHE-CONTROL"));
+    foreach (UpnpDiscoveryRequest *upnpDiscoveryRequest, m_discoverRequests) {
+        QNetworkRequest networkRequest = upnpDiscoveryRequest->createNetworkRequest(upnpDeviceDescriptor);
+        requestDeviceInformation(networkRequest, upnpDeviceDescriptor, usn, maxAge);
+    }
+}
+
+void UpnpDiscoveryImplementation::processNotification(const QByteArray &data)
+{
+    const QHash<QByteArray, QString> headers = parseHeaders(data);
+    if (headers.value("NTS") == "ssdp:byebye") {
+        m_descriptorCache.remove(headers.value("USN"));
     }
 }
 
@@ -340,7 +436,9 @@ void UpnpDiscoveryImplementation::replyFinished()
     switch (status) {
     case(200):{
         QByteArray data = reply->readAll();
-        UpnpDeviceDescriptor upnpDeviceDescriptor = m_informationRequestList.take(reply);
+        InformationRequest informationRequest = m_informationRequestList.take(reply);
+        m_pendingRequests.remove(pendingRequestKey(reply->request()));
+        UpnpDeviceDescriptor upnpDeviceDescriptor = informationRequest.descriptor;
 
         // parse XML data
         QXmlStreamReader xml(data);
@@ -434,6 +532,15 @@ void UpnpDiscoveryImplementation::replyFinished()
             }
         }
 
+        if (informationRequest.maxAge > 0) {
+            CachedDescriptor cached;
+            cached.descriptor = upnpDeviceDescriptor;
+            cached.expiry = QDateTime::currentDateTimeUtc().addSecs(informationRequest.maxAge);
+            foreach (const QString &usn, informationRequest.usns) {
+                m_descriptorCache.insert(usn, cached);
+            }
+        }
+
         qCDebug(dcUpnp()) << "Discovery result:" << upnpDeviceDescriptor.hostAddress().toString();
         qCDebug(dcUpnp()) << "Have" << m_discoverRequests.count() << "running discoveries";
         foreach (UpnpDiscoveryRequest *upnpDiscoveryRequest, m_discoverRequests) {
@@ -444,6 +551,7 @@ void UpnpDiscoveryImplementation::replyFinished()
     default:
         qCWarning(dcUpnp()) << name() << "HTTP request error" << reply->request().url().toString() << status;
         m_informationRequestList.remove(reply);
+        m_pendingRequests.remove(pendingRequestKey(reply->request()));
     }
 
     reply->deleteLater();
@@ -452,6 +560,7 @@ void UpnpDiscoveryImplementation::replyFinished()
 void UpnpDiscoveryImplementation::notificationTimeout()
 {
     sendAliveMessage();
+    cleanupDescriptorCache();
 }
 
 void UpnpDiscoveryImplementation::sendByeByeMessage()
@@ -567,6 +676,9 @@ bool UpnpDiscoveryImplementation::enable()
     m_available = true;
     emit availableChanged(true);
 
+    // Interfaces may have changed while we were disabled
+    m_localAddressesTimer.invalidate();
+
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
     connect(m_socket, &QUdpSocket::errorOccurred, this, &UpnpDiscoveryImplementation::error);
 #else
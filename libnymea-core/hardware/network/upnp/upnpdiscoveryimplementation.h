@@ -27,6 +27,8 @@
 
 #include <QUrl>
 #include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QUdpSocket>
 #include <QHostAddress>
 #include <QNetworkReply>
@@ -71,13 +73,36 @@ private:
     QNetworkAccessManager *m_networkAccessManager = nullptr;
     NymeaConfiguration *m_configuration = nullptr;
 
+    struct InformationRequest {
+        UpnpDeviceDescriptor descriptor;
+        QStringList usns;
+        int maxAge = 0;
+    };
+
+    struct CachedDescriptor {
+        UpnpDeviceDescriptor descriptor;
+        QDateTime expiry;
+    };
+
     QList<UpnpDiscoveryRequest *> m_discoverRequests;
-    QHash<QNetworkReply*, UpnpDeviceDescriptor> m_informationRequestList;
+    QHash<QNetworkReply*, InformationRequest> m_informationRequestList;
+    typedef QPair<QUrl, QString> PendingRequestKey;
+    QHash<PendingRequestKey, QNetworkReply*> m_pendingRequests;
+    QHash<QString, CachedDescriptor> m_descriptorCache;
+
+    QList<QHostAddress> m_localAddresses;
+    QElapsedTimer m_localAddressesTimer;
 
     bool m_available = false;
     bool m_enabled = false;
 
-    void requestDeviceInformation(const QNetworkRequest &networkRequest, const UpnpDeviceDescriptor &upnpDeviceDescriptor);
+    void processDatagram(const QByteArray &data, const QHostAddress &hostAddress, quint16 port);
+    void processSearchResponse(const QByteArray &data, const QHostAddress &hostAddress);
+    void processNotification(const QByteArray &data);
+    void requestDeviceInformation(const QNetworkRequest &networkRequest, const UpnpDeviceDescriptor &upnpDeviceDescriptor, const QString &usn, int maxAge);
+    static PendingRequestKey pendingRequestKey(const QNetworkRequest &networkRequest);
+    void cleanupDescriptorCache();
+    bool isLocalAddress(const QHostAddress &address);
     void respondToSearchRequest(QHostAddress host, int port);
     QByteArray serverUuid() const;
     bool preferredWebServerConfiguration(WebServerConfiguration &config) const;
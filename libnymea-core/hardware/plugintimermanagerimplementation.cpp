@@ -25,6 +25,7 @@
 #include "plugintimermanagerimplementation.h"
 #include "loggingcategories.h"
 #include "nymeacore.h"
+#include "integrations/plugincallstatistics.h"
 
 namespace nymeaserver {
 
@@ -32,6 +33,9 @@ PluginTimerImplementation::PluginTimerImplementation(int interval, QObject *pare
     PluginTimer(parent),
     m_interval(interval)
 {
+    // Timers are registered by plugins from within their calls, account the timeouts to that plugin
+    m_pluginId = NymeaCore::instance()->pluginCallStatistics()->currentPlugin();
+
     connect(NymeaCore::instance()->timeManager(), &TimeManager::tick, this, &PluginTimerImplementation::tick);
 }
 
@@ -85,7 +89,10 @@ void PluginTimerImplementation::tick()
     setCurrentTick(m_currentTick += 1);
 
     if (m_currentTick >= m_interval) {
-        emit timeout();
+        {
+            PluginCallStatistics::Measurement measurement(NymeaCore::instance()->pluginCallStatistics(), m_pluginId, "timer");
+            emit timeout();
+        }
         reset();
     }
 }
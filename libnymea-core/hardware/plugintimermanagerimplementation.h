@@ -30,6 +30,7 @@
 #include <QPointer>
 
 #include "plugintimer.h"
+#include "typeutils.h"
 
 namespace nymeaserver {
 
@@ -49,6 +50,7 @@ public:
 private:
     int m_interval;
     int m_currentTick = 0;
+    PluginId m_pluginId;
 
     bool m_paused = false;
     bool m_running = true;
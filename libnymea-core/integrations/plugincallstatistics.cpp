@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "plugincallstatistics.h"
+#include "loggingcategories.h"
+
+PluginCallStatistics::Measurement::Measurement(PluginCallStatistics *statistics, const PluginId &pluginId, const QString &entryPoint):
+    m_statistics(pluginId.isNull() ? nullptr : statistics),
+    m_pluginId(pluginId),
+    m_entryPoint(entryPoint)
+{
+    if (!m_statistics) {
+        return;
+    }
+    m_statistics->m_callStack.append(m_pluginId);
+    m_timer.start();
+}
+
+PluginCallStatistics::Measurement::~Measurement()
+{
+    if (!m_statistics) {
+        return;
+    }
+    qint64 elapsed = m_timer.nsecsElapsed();
+    m_statistics->m_callStack.removeLast();
+    m_statistics->record(m_pluginId, m_entryPoint, elapsed);
+}
+
+PluginCallStatistics::PluginCallStatistics(QObject *parent):
+    QObject(parent)
+{
+}
+
+void PluginCallStatistics::registerPlugin(const PluginId &pluginId, const QString &pluginName)
+{
+    m_pluginNames.insert(pluginId, pluginName);
+}
+
+PluginId PluginCallStatistics::currentPlugin() const
+{
+    return m_callStack.isEmpty() ? PluginId() : m_callStack.last();
+}
+
+int PluginCallStatistics::slowCallThreshold() const
+{
+    return m_slowCallThreshold;
+}
+
+void PluginCallStatistics::setSlowCallThreshold(int milliseconds)
+{
+    m_slowCallThreshold = qMax(0, milliseconds);
+}
+
+QVariantList PluginCallStatistics::statistics() const
+{
+    QVariantList ret;
+    for (auto pluginIt = m_statistics.constBegin(); pluginIt != m_statistics.constEnd(); ++pluginIt) {
+        QVariantList entryPoints;
+        for (auto it = pluginIt.value().constBegin(); it != pluginIt.value().constEnd(); ++it) {
+            QVariantMap entryPoint;
+            entryPoint.insert("name", it.key());
+            entryPoint.insert("calls", it.value().calls);
+            entryPoint.insert("slowCalls", it.value().slowCalls);
+            entryPoint.insert("totalTime", it.value().totalTime / 1000000.0);
+            entryPoint.insert("maxTime", it.value().maxTime / 1000000.0);
+            entryPoints.append(entryPoint);
+        }
+        QVariantMap plugin;
+        plugin.insert("pluginId", pluginIt.key());
+        plugin.insert("pluginName", m_pluginNames.value(pluginIt.key()));
+        plugin.insert("entryPoints", entryPoints);
+        ret.append(plugin);
+    }
+    return ret;
+}
+
+void PluginCallStatistics::reset()
+{
+    m_statistics.clear();
+}
+
+void PluginCallStatistics::record(const PluginId &pluginId, const QString &entryPoint, qint64 elapsed)
+{
+    EntryPointStatistics &statistics = m_statistics[pluginId][entryPoint];
+    statistics.calls++;
+    statistics.totalTime += elapsed;
+    statistics.maxTime = qMax(statistics.maxTime, elapsed);
+
+    if (m_slowCallThreshold > 0 && elapsed >= m_slowCallThreshold * 1000000ll) {
+        statistics.slowCalls++;
+        qCWarning(dcThingManager()).nospace() << "Plugin " << m_pluginNames.value(pluginId) << " blocked the event loop for " << elapsed / 1000000 << " ms in " << entryPoint;
+    }
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef PLUGINCALLSTATISTICS_H
+#define PLUGINCALLSTATISTICS_H
+
+#include "typeutils.h"
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QVariantList>
+
+// Accounts the wall time spent in calls into integration plugins, per plugin and per entry point.
+// All plugins run on the main thread, so a slow call stalls the whole event loop.
+class PluginCallStatistics : public QObject
+{
+    Q_OBJECT
+public:
+    // Measures the lifetime of this object as one call of the given entry point
+    class Measurement
+    {
+    public:
+        Measurement(PluginCallStatistics *statistics, const PluginId &pluginId, const QString &entryPoint);
+        ~Measurement();
+
+    private:
+        Q_DISABLE_COPY(Measurement)
+        PluginCallStatistics *m_statistics;
+        PluginId m_pluginId;
+        QString m_entryPoint;
+        QElapsedTimer m_timer;
+    };
+
+    explicit PluginCallStatistics(QObject *parent = nullptr);
+
+    void registerPlugin(const PluginId &pluginId, const QString &pluginName);
+
+    // The plugin whose code is currently being executed, null if none
+    PluginId currentPlugin() const;
+
+    // Calls taking longer than this (in ms) are logged, 0 disables logging
+    int slowCallThreshold() const;
+    void setSlowCallThreshold(int milliseconds);
+
+    QVariantList statistics() const;
+    void reset();
+
+private:
+    struct EntryPointStatistics {
+        quint64 calls = 0;
+        quint64 slowCalls = 0;
+        qint64 totalTime = 0; // ns
+        qint64 maxTime = 0; // ns
+    };
+
+    void record(const PluginId &pluginId, const QString &entryPoint, qint64 elapsed);
+
+    QHash<PluginId, QString> m_pluginNames;
+    QHash<PluginId, QHash<QString, EntryPointStatistics>> m_statistics;
+    QList<PluginId> m_callStack;
+    int m_slowCallThreshold = 100;
+};
+
+#endif // PLUGINCALLSTATISTICS_H
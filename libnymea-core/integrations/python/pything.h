@@ -336,6 +336,41 @@ static PyObject * PyThing_setStateValue(PyThing* self, PyObject* args)
     Py_RETURN_NONE;
 }
 
+// Sets multiple states with a single hop into the main thread. Takes a dict of stateTypeId: value.
+static PyObject * PyThing_setStateValues(PyThing* self, PyObject* args)
+{
+    PyObject *valuesObj = nullptr;
+
+    if (!PyArg_ParseTuple(args, "O!", &PyDict_Type, &valuesObj)) {
+        PyErr_SetString(PyExc_TypeError, "Error parsing arguments. Signature is 'dict'");
+        return nullptr;
+    }
+
+    QList<QPair<StateTypeId, QVariant>> values;
+    PyObject *key = nullptr;
+    PyObject *valueObj = nullptr;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(valuesObj, &pos, &key, &valueObj)) {
+        const char *stateTypeIdStr = PyUnicode_AsUTF8(key);
+        if (!stateTypeIdStr) {
+            PyErr_SetString(PyExc_TypeError, "State type ids must be strings");
+            return nullptr;
+        }
+        values.append(qMakePair(StateTypeId(stateTypeIdStr), PyObjectToQVariant(valueObj)));
+    }
+
+    if (self->thing != nullptr && !values.isEmpty()) {
+        Thing *thing = self->thing;
+        QMetaObject::invokeMethod(thing, [thing, values](){
+            for (int i = 0; i < values.count(); i++) {
+                thing->setStateValue(values.at(i).first, values.at(i).second);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+    Py_RETURN_NONE;
+}
+
 static PyObject * PyThing_emitEvent(PyThing* self, PyObject* args)
 {
     char *eventTypeIdStr = nullptr;
@@ -380,6 +415,7 @@ static PyMethodDef PyThing_methods[] = {
     { "setting", (PyCFunction)PyThing_setting, METH_VARARGS, "Get a things setting value by paramTypeId" },
     { "stateValue", (PyCFunction)PyThing_stateValue, METH_VARARGS, "Get a things state value by stateTypeId" },
     { "setStateValue", (PyCFunction)PyThing_setStateValue, METH_VARARGS, "Set a certain things state value by stateTypeIp" },
+    { "setStateValues", (PyCFunction)PyThing_setStateValues, METH_VARARGS, "Set multiple state values at once from a dict of stateTypeId: value" },
     { "emitEvent", (PyCFunction)PyThing_emitEvent, METH_VARARGS, "Emits an event" },
     {nullptr, nullptr, 0, nullptr} // sentinel
 };
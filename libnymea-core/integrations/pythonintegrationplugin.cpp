@@ -40,6 +40,7 @@
 #include <QMutex>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QThread>
 
 NYMEA_LOGGING_CATEGORY(dcPythonIntegrations, "PythonIntegrations")
 
@@ -263,6 +264,18 @@ PythonIntegrationPlugin::~PythonIntegrationPlugin()
         }
     }
 
+    // All tasks are finished, the interpreter can only be ended once it has no other thread states
+    if (m_threadPool) {
+        Py_BEGIN_ALLOW_THREADS
+        m_threadPool->waitForDone();
+        Py_END_ALLOW_THREADS
+    }
+    foreach (PyThreadState *threadState, m_poolThreadStates) {
+        PyThreadState_Clear(threadState);
+        PyThreadState_Delete(threadState);
+    }
+    m_poolThreadStates.clear();
+
     s_plugins.take(this);
     Py_XDECREF(m_pluginModule);
     Py_DECREF(m_nymeaModule);
@@ -432,14 +445,17 @@ bool PythonIntegrationPlugin::loadScript(const QString &scriptFile)
     // forcing every plugin developer to deal with threading in the plugin.
     // In oder to not create and destroy a thread for each plugin api call, we'll be using a
     // thread pool.
-    // The maximum number of threads in a plugin will be amount of things it manages + 2.
-    // This would allow for e.g. running an event loop using init(), performing something on a thing
-    // and still allow the user to perform a discovery at the same time. On the other hand, this is
-    // strict enough to not encourage the plugin developer to block forever in ever api call but use
-    // proper task processing means (timers, event loops etc) instead.
+    // The pool has a fixed size, independent of the amount of things the plugin manages. Calls
+    // exceeding it are queued. This allows for e.g. running an event loop using init(), performing
+    // something on a thing and still allow the user to perform a discovery at the same time. On the
+    // other hand, this is strict enough to not encourage the plugin developer to block forever in
+    // ever api call but use proper task processing means (timers, event loops etc) instead.
     // Plugins can still spawn more threads on their own if the need to but have to manage them on their own.
+    // Pool threads never expire, each of them keeps its python thread state until the plugin is unloaded.
+    int maxThreadCount = qEnvironmentVariableIntValue("NYMEA_PYTHON_PLUGIN_THREADS");
     m_threadPool = new QThreadPool(this);
-    m_threadPool->setMaxThreadCount(2);
+    m_threadPool->setMaxThreadCount(maxThreadCount > 0 ? maxThreadCount : 4);
+    m_threadPool->setExpiryTimeout(-1);
     qCDebug(dcPythonIntegrations()) << "Created a thread pool with a maximum of" << m_threadPool->maxThreadCount() << "threads for python plugin" << metadata.pluginName();
 
     PyEval_ReleaseThread(m_threadState);
@@ -578,9 +594,6 @@ void PythonIntegrationPlugin::setupThing(ThingSetupInfo *info)
 
     pyInfo->info = info;
 
-    m_threadPool->setMaxThreadCount(m_threadPool->maxThreadCount() + 1);
-    qCDebug(dcPythonIntegrations()) << "Expanded thread pool for plugin" << metadata().pluginName() << "to" << m_threadPool->maxThreadCount();
-
     PyEval_ReleaseThread(m_threadState);
 
     connect(info->thing(), &Thing::destroyed, this, [=](){
@@ -588,8 +601,6 @@ void PythonIntegrationPlugin::setupThing(ThingSetupInfo *info)
         m_things.remove(thing); // In case thingRemoved is never called (e.g. failed setup) it needs to be removed too
         pyThing->thing = nullptr;
         Py_DECREF(pyThing);
-        m_threadPool->setMaxThreadCount(m_threadPool->maxThreadCount() - 1);
-        qCDebug(dcPythonIntegrations()) << "Shrunk thread pool for plugin" << metadata().pluginName() << "to" << m_threadPool->maxThreadCount();
         PyEval_ReleaseThread(m_threadState);
     });
     connect(info, &ThingSetupInfo::destroyed, this, [=](){
@@ -828,10 +839,9 @@ bool PythonIntegrationPlugin::callPluginFunction(const QString &function, PyObje
     QFuture<void> future = QtConcurrent::run(m_threadPool, [=](){
         qCDebug(dcPythonIntegrations()) << "+++ Thread for" << function << "in plugin" << metadata().pluginName();
 
-        // Register this new thread in the interpreter
-        PyThreadState *threadState = PyThreadState_New(m_threadState->interp);
+        PyThreadState *threadState = poolThreadState();
 
-        // Acquire GIL and make the new thread state the current one
+        // Acquire GIL and make the pool thread's state the current one
         PyEval_RestoreThread(threadState);
 
         PyObject *pluginFunctionResult = PyObject_CallFunctionObjArgs(pluginFunction, param1, param2, param3, nullptr);
@@ -849,10 +859,8 @@ bool PythonIntegrationPlugin::callPluginFunction(const QString &function, PyObje
 
         m_runningTasks.remove(watcher);
 
-        // Destroy the thread and release the GIL
-        PyThreadState_Clear(threadState);
+        // Release the GIL, the thread state is kept for the next task on this pool thread
         PyEval_ReleaseThread(threadState);
-        PyThreadState_Delete(threadState);
         qCDebug(dcPythonIntegrations()) << "--- Thread for" << function << "in plugin" << metadata().pluginName();
     });
     watcher->setFuture(future);
@@ -862,3 +870,16 @@ bool PythonIntegrationPlugin::callPluginFunction(const QString &function, PyObje
     return true;
 }
 
+PyThreadState *PythonIntegrationPlugin::poolThreadState()
+{
+    QMutexLocker locker(&m_threadStatesMutex);
+    PyThreadState *threadState = m_poolThreadStates.value(QThread::currentThread());
+    if (!threadState) {
+        // Register this pool thread in the interpreter
+        threadState = PyThreadState_New(m_threadState->interp);
+        m_poolThreadStates.insert(QThread::currentThread(), threadState);
+        qCDebug(dcPythonIntegrations()) << "Created python thread state for pool thread" << m_poolThreadStates.count() << "of plugin" << metadata().pluginName();
+    }
+    return threadState;
+}
+
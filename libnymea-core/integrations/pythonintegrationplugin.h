@@ -87,6 +87,7 @@ private:
 
 
     bool callPluginFunction(const QString &function, PyObject *param1 = nullptr, PyObject *param2 = nullptr, PyObject *param3 = nullptr);
+    PyThreadState *poolThreadState();
 
 private:
     // The main thread state in which we create an interpreter per plugin
@@ -98,6 +99,10 @@ private:
     // A per plugin thread pool
     QThreadPool *m_threadPool = nullptr;
 
+    // The python thread states of the pool threads, created on first use
+    QHash<QThread*, PyThreadState*> m_poolThreadStates;
+    QMutex m_threadStatesMutex;
+
     // Running concurrent tasks in this plugins thread pool
     QHash<QFutureWatcher<void>*, QString> m_runningTasks;
 
@@ -36,6 +36,7 @@
 #include "nymeasettings.h"
 #include "version.h"
 #include "plugininfocache.h"
+#include "plugincallstatistics.h"
 
 #include "integrations/thingdiscoveryinfo.h"
 #include "integrations/thingpairinginfo.h"
@@ -64,13 +65,15 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QMetaEnum>
 #include <QRegularExpression>
 
-ThingManagerImplementation::ThingManagerImplementation(HardwareManager *hardwareManager, LogEngine *logEngine, const QLocale &locale, QObject *parent) :
+ThingManagerImplementation::ThingManagerImplementation(HardwareManager *hardwareManager, LogEngine *logEngine, PluginCallStatistics *pluginCallStatistics, const QLocale &locale, QObject *parent) :
     ThingManager(parent),
     m_hardwareManager(hardwareManager),
     m_logEngine(logEngine),
+    m_pluginCallStatistics(pluginCallStatistics),
     m_locale(locale),
     m_translator(new Translator(this))
 {
@@ -244,7 +247,11 @@ Thing::ThingError ThingManagerImplementation::setPluginConfig(const PluginId &pl
     }
     ParamList params = buildParams(plugin->configurationDescription(), pluginConfig);
 
-    Thing::ThingError result = plugin->setConfiguration(params);
+    Thing::ThingError result;
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "setConfiguration");
+        result = plugin->setConfiguration(params);
+    }
     if (result != Thing::ThingErrorNoError)
         return result;
 
@@ -336,7 +343,10 @@ ThingDiscoveryInfo* ThingManagerImplementation::discoverThings(const ThingClassI
     });
 
     qCDebug(dcThingManager()) << "Thing discovery for" << thingClass << "started...";
-    plugin->discoverThings(discoveryInfo);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "discoverThings");
+        plugin->discoverThings(discoveryInfo);
+    }
     return discoveryInfo;
 }
 
@@ -470,7 +480,10 @@ ThingSetupInfo *ThingManagerImplementation::reconfigureThingInternal(Thing *thin
 
     // try to setup the thing with the new params
     ThingSetupInfo *info = new ThingSetupInfo(thing, this, true, true, 30000);
-    plugin->setupThing(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "setupThing");
+        plugin->setupThing(info);
+    }
     connect(info, &ThingSetupInfo::destroyed, thing, [=](){
         m_pendingSetups.remove(thing->id());
     });
@@ -746,7 +759,10 @@ ThingPairingInfo *ThingManagerImplementation::confirmPairing(const PairingTransa
     // both, the internal pairing and the setup have completed.
     ThingPairingInfo *internalInfo = new ThingPairingInfo(pairingTransactionId, thingClassId, thingId, context.thingName, context.params, context.parentId, this, false);
     ThingPairingInfo *externalInfo = new ThingPairingInfo(pairingTransactionId, thingClassId, thingId, context.thingName, context.params, context.parentId, this, false);
-    plugin->confirmPairing(internalInfo, username, secret);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "confirmPairing");
+        plugin->confirmPairing(internalInfo, username, secret);
+    }
 
     connect(internalInfo, &ThingPairingInfo::finished, this, [this, internalInfo, externalInfo, plugin, addNewThing](){
 
@@ -942,6 +958,7 @@ void ThingManagerImplementation::removeConfiguredThingInternal(Thing *thing)
             ThingSetupInfo *setupInfo = m_pendingSetups.value(t->id());
             emit setupInfo->aborted();
         } else if (thing->setupStatus() == Thing::ThingSetupStatusComplete) {
+            PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "thingRemoved");
             plugin->thingRemoved(t);
         }
 
@@ -1005,7 +1022,10 @@ BrowseResult *ThingManagerImplementation::browseThing(const ThingId &thingId, co
         return result;
     }
 
-    plugin->browseThing(result);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "browseThing");
+        plugin->browseThing(result);
+    }
     connect(result, &BrowseResult::finished, this, [result](){
         if (result->status() != Thing::ThingErrorNoError) {
             qCWarning(dcThingManager()) << "Browsing" << result->thing() << "failed:" << result->status();
@@ -1043,7 +1063,10 @@ BrowserItemResult *ThingManagerImplementation::browserItemDetails(const ThingId
         return result;
     }
 
-    plugin->browserItem(result);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "browserItem");
+        plugin->browserItem(result);
+    }
     connect(result, &BrowserItemResult::finished, this, [result](){
         if (result->status() != Thing::ThingErrorNoError) {
             qCWarning(dcThingManager()) << "Browsing" << result->thing() << "failed:" << result->status();
@@ -1080,7 +1103,10 @@ BrowserActionInfo* ThingManagerImplementation::executeBrowserItem(const BrowserA
         info->finish(Thing::ThingErrorUnsupportedFeature);
         return info;
     }
-    plugin->executeBrowserItem(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "executeBrowserItem");
+        plugin->executeBrowserItem(info);
+    }
     return info;
 }
 
@@ -1114,7 +1140,10 @@ BrowserItemActionInfo* ThingManagerImplementation::executeBrowserItemAction(cons
     }
     // TODO: check browserItemAction.params with ThingClass
 
-    plugin->executeBrowserItemAction(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "executeBrowserItemAction");
+        plugin->executeBrowserItemAction(info);
+    }
     return info;
 }
 
@@ -1445,24 +1474,27 @@ ThingActionInfo *ThingManagerImplementation::executeAction(const Action &action)
     ThingActionInfo *info = new ThingActionInfo(thing, finalAction, this, 15000);
     connect(info, &ThingActionInfo::finished, this, [=](){
 
-        if (thing->loggedActionTypeIds().contains(actionType.id())) {
-            QVariantMap params;
+        Logger *logger = m_actionLoggers.value(thing->id()).value(actionType.id());
+        if (logger) {
+            QJsonObject params;
             foreach (const ParamType &paramType, actionType.paramTypes()) {
-                params.insert(paramType.name(), action.paramValue(paramType.id()));
+                params.insert(paramType.name(), QJsonValue::fromVariant(action.paramValue(paramType.id())));
             }
 
-            m_actionLoggers.value(thing->id().toString() + "-" + actionType.name())->log({},
-                                                        {
-                                                            {"status", QMetaEnum::fromType<Thing::ThingError>().valueToKey(info->status())},
-                                                            {"triggeredBy", QMetaEnum::fromType<Action::TriggeredBy>().valueToKey(action.triggeredBy())},
-                                                            {"params", QJsonDocument::fromVariant(params).toJson(QJsonDocument::Compact)}
-                                                        });
+            logger->log({}, {
+                            {"status", QMetaEnum::fromType<Thing::ThingError>().valueToKey(info->status())},
+                            {"triggeredBy", QMetaEnum::fromType<Action::TriggeredBy>().valueToKey(action.triggeredBy())},
+                            {"params", QJsonDocument(params).toJson(QJsonDocument::Compact)}
+                        });
         }
 
         emit actionExecuted(action, info->status());
     });
 
-    plugin->executeAction(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "executeAction");
+        plugin->executeAction(info);
+    }
 
     return info;
 }
@@ -1562,7 +1594,11 @@ void ThingManagerImplementation::loadPlugin(IntegrationPlugin *pluginIface)
         qCWarning(dcThingManager()).nospace() << "Unable to load API keys for plugin " << pluginIface->metadata().pluginName() << ": " << requestedKeys;
     }
     pluginIface->setParent(this);
-    pluginIface->initPlugin(this, m_hardwareManager, apiKeyStorage);
+    m_pluginCallStatistics->registerPlugin(pluginIface->pluginId(), pluginIface->pluginName());
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, pluginIface->pluginId(), "initPlugin");
+        pluginIface->initPlugin(this, m_hardwareManager, apiKeyStorage);
+    }
 
     qCDebug(dcThingManager()) << "**** Loaded plugin" << pluginIface->pluginName();
     foreach (const Vendor &vendor, pluginIface->supportedVendors()) {
@@ -1607,6 +1643,7 @@ void ThingManagerImplementation::loadPlugin(IntegrationPlugin *pluginIface)
     settings.endGroup(); // PluginConfig
 
     if (params.count() > 0) {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, pluginIface->pluginId(), "setConfiguration");
         Thing::ThingError status = pluginIface->setConfiguration(params);
         if (status != Thing::ThingErrorNoError) {
             qCWarning(dcThingManager()) << "Error setting params to plugin" << pluginIface->pluginId().toString() << pluginIface->pluginDisplayName() << ". Broken configuration?";
@@ -1614,7 +1651,10 @@ void ThingManagerImplementation::loadPlugin(IntegrationPlugin *pluginIface)
     }
 
     // Call the init method of the plugin
-    pluginIface->init();
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, pluginIface->pluginId(), "init");
+        pluginIface->init();
+    }
 
     m_integrationPlugins.insert(pluginIface->pluginId(), pluginIface);
 
@@ -1857,6 +1897,7 @@ void ThingManagerImplementation::storeConfiguredThings()
 void ThingManagerImplementation::startMonitoringAutoThings()
 {
     foreach (IntegrationPlugin *plugin, m_integrationPlugins) {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "startMonitoringAutoThings");
         plugin->startMonitoringAutoThings();
     }
 }
@@ -1987,12 +2028,13 @@ void ThingManagerImplementation::onEventTriggered(Event event)
         return;
     }
 
-    if (thing->loggedEventTypeIds().contains(event.eventTypeId())) {
-        QVariantMap params;
+    Logger *logger = m_eventLoggers.value(thing->id()).value(event.eventTypeId());
+    if (logger) {
+        QJsonObject params;
         foreach (const ParamType &paramType, eventType.paramTypes()) {
-            params.insert(paramType.name(), event.paramValue(paramType.id()));
+            params.insert(paramType.name(), QJsonValue::fromVariant(event.paramValue(paramType.id())));
         }
-        m_eventLoggers.value(thing->id().toString() + "-" + eventType.name())->log({}, {{"params", QJsonDocument::fromVariant(params).toJson(QJsonDocument::Compact)}});
+        logger->log({}, {{"params", QJsonDocument(params).toJson(QJsonDocument::Compact)}});
     }
 
     // Forward the event
@@ -2011,8 +2053,11 @@ void ThingManagerImplementation::slotThingStateValueChanged(const StateTypeId &s
         storeThingState(thing, stateTypeId);
     }
 
-    if (thing->loggedStateTypeIds().contains(stateTypeId)) {
-        m_stateLoggers.value(thing->id().toString() + "-" + stateType.name())->log({}, {{stateType.name(), value}});
+    Logger *logger = m_stateLoggers.value(thing->id()).value(stateTypeId);
+    if (logger) {
+        QVariantMap values;
+        values.insert(stateType.name(), value);
+        logger->log({}, values);
     }
 
     emit thingStateChanged(thing, stateTypeId, value, minValue, maxValue, possibleValues);
@@ -2210,7 +2255,10 @@ void ThingManagerImplementation::pairThingInternal(ThingPairingInfo *info)
         return;
     }
 
-    plugin->startPairing(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "startPairing");
+        plugin->startPairing(info);
+    }
 
     connect(info, &ThingPairingInfo::finished, this, [this, info, thingClass](){
         if (info->status() != Thing::ThingErrorNoError) {
@@ -2244,7 +2292,10 @@ ThingSetupInfo* ThingManagerImplementation::setupThing(Thing *thing, bool initia
         return info;
     }
 
-    plugin->setupThing(info);
+    {
+        PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "setupThing");
+        plugin->setupThing(info);
+    }
 
     m_pendingSetups.insert(thing->id(), info);
     connect(info, &ThingSetupInfo::destroyed, thing, [=](){
@@ -2295,6 +2346,7 @@ void ThingManagerImplementation::postSetupThing(Thing *thing)
     ThingClass thingClass = findThingClass(thing->thingClassId());
     IntegrationPlugin *plugin = m_integrationPlugins.value(thingClass.pluginId());
 
+    PluginCallStatistics::Measurement measurement(m_pluginCallStatistics, plugin->pluginId(), "postSetupThing");
     plugin->postSetupThing(thing);
 }
 
@@ -2429,7 +2481,7 @@ void ThingManagerImplementation::registerStateLogger(Thing *thing, const StateTy
     };
     Types::LoggingType loggingType = sampledTypes.contains(stateType.type()) ? Types::LoggingTypeSampled : Types::LoggingTypeDiscrete;
     Logger *logger = m_logEngine->registerLogSource("state-" + name, {}, loggingType, stateType.name());
-    m_stateLoggers.insert(name, logger);
+    m_stateLoggers[thing->id()].insert(stateTypeId, logger);
 }
 
 void ThingManagerImplementation::unregisterStateLogger(Thing *thing, const StateTypeId &stateTypeId)
@@ -2437,7 +2489,10 @@ void ThingManagerImplementation::unregisterStateLogger(Thing *thing, const State
     StateType stateType = thing->thingClass().getStateType(stateTypeId);
     QString name = thing->id().toString() + "-" + stateType.name();
     m_logEngine->unregisterLogSource("state-" + name);
-    m_stateLoggers.remove(name);
+    m_stateLoggers[thing->id()].remove(stateTypeId);
+    if (m_stateLoggers.value(thing->id()).isEmpty()) {
+        m_stateLoggers.remove(thing->id());
+    }
 }
 
 void ThingManagerImplementation::registerEventLogger(Thing *thing, const EventTypeId &eventTypeId)
@@ -2445,7 +2500,7 @@ void ThingManagerImplementation::registerEventLogger(Thing *thing, const EventTy
     EventType eventType = thing->thingClass().eventTypes().findById(eventTypeId);
     QString name = thing->id().toString() + "-" + eventType.name();
     Logger *logger = m_logEngine->registerLogSource("event-" + name, {});
-    m_eventLoggers.insert(name, logger);
+    m_eventLoggers[thing->id()].insert(eventTypeId, logger);
 }
 
 void ThingManagerImplementation::unregisterEventLogger(Thing *thing, const EventTypeId &eventTypeId)
@@ -2453,7 +2508,10 @@ void ThingManagerImplementation::unregisterEventLogger(Thing *thing, const Event
     EventType eventType = thing->thingClass().eventTypes().findById(eventTypeId);
     QString name = thing->id().toString() + "-" + eventType.name();
     m_logEngine->unregisterLogSource("event-" + name);
-    m_eventLoggers.remove(name);
+    m_eventLoggers[thing->id()].remove(eventTypeId);
+    if (m_eventLoggers.value(thing->id()).isEmpty()) {
+        m_eventLoggers.remove(thing->id());
+    }
 }
 
 void ThingManagerImplementation::registerActionLogger(Thing *thing, const ActionTypeId &actionTypeId)
@@ -2461,7 +2519,7 @@ void ThingManagerImplementation::registerActionLogger(Thing *thing, const Action
     ActionType actionType = thing->thingClass().actionTypes().findById(actionTypeId);
     QString name = thing->id().toString() + "-" + actionType.name();
     Logger *logger = m_logEngine->registerLogSource("action-" + name, {});
-    m_actionLoggers.insert(name, logger);
+    m_actionLoggers[thing->id()].insert(actionTypeId, logger);
 }
 
 void ThingManagerImplementation::unregisterActionLogger(Thing *thing, const ActionTypeId &actionTypeId)
@@ -2469,7 +2527,10 @@ void ThingManagerImplementation::unregisterActionLogger(Thing *thing, const Acti
     ActionType actionType = thing->thingClass().actionTypes().findById(actionTypeId);
     QString name = thing->id().toString() + "-" + actionType.name();
     m_logEngine->unregisterLogSource("action-" + name);
-    m_actionLoggers.remove(name);
+    m_actionLoggers[thing->id()].remove(actionTypeId);
+    if (m_actionLoggers.value(thing->id()).isEmpty()) {
+        m_actionLoggers.remove(thing->id());
+    }
 }
 
 void ThingManagerImplementation::trySetupThing(Thing *thing)
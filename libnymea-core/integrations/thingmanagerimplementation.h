@@ -54,6 +54,7 @@ class ThingPairingInfo;
 class HardwareManager;
 class Translator;
 class ApiKeysProvidersLoader;
+class PluginCallStatistics;
 class LogEngine;
 class Logger;
 
@@ -64,7 +65,7 @@ class ThingManagerImplementation: public ThingManager
     friend class IntegrationPlugin;
 
 public:
-    explicit ThingManagerImplementation(HardwareManager *hardwareManager, LogEngine *logEngine, const QLocale &locale, QObject *parent = nullptr);
+    explicit ThingManagerImplementation(HardwareManager *hardwareManager, LogEngine *logEngine, PluginCallStatistics *pluginCallStatistics, const QLocale &locale, QObject *parent = nullptr);
     ~ThingManagerImplementation() override;
 
     static QStringList pluginSearchDirs();
@@ -179,6 +180,7 @@ private:
 private:
     HardwareManager *m_hardwareManager;
     LogEngine *m_logEngine;
+    PluginCallStatistics *m_pluginCallStatistics;
 
     QLocale m_locale;
     Translator *m_translator = nullptr;
@@ -188,9 +190,10 @@ private:
     QHash<ThingClassId, ThingClass> m_supportedThings;
     QHash<ThingId, Thing*> m_configuredThings;
     QHash<ThingDescriptorId, ThingDescriptor> m_discoveredThings;
-    QHash<QString, Logger*> m_stateLoggers;
-    QHash<QString, Logger*> m_actionLoggers;
-    QHash<QString, Logger*> m_eventLoggers;
+    // Resolved once at register time so the hot paths don't need to build and hash logger names
+    QHash<ThingId, QHash<StateTypeId, Logger*>> m_stateLoggers;
+    QHash<ThingId, QHash<ActionTypeId, Logger*>> m_actionLoggers;
+    QHash<ThingId, QHash<EventTypeId, Logger*>> m_eventLoggers;
 
     QHash<PluginId, IntegrationPlugin*> m_integrationPlugins;
 
@@ -42,8 +42,8 @@ Translator::Translator(ThingManagerImplementation *thingManager):
 Translator::~Translator()
 {
     foreach (const TranslatorContext &ctx, m_translatorContexts) {
-        foreach (QTranslator *t, ctx.translators) {
-            t->deleteLater();
+        foreach (const TranslationTable &table, ctx.tables) {
+            delete table.translator;
         }
     }
     m_translatorContexts.clear();
@@ -51,37 +51,108 @@ Translator::~Translator()
 
 QString Translator::translate(const PluginId &pluginId, const QString &string, const QLocale &locale)
 {
+    QHash<PluginId, TranslatorContext>::const_iterator ctx = m_translatorContexts.constFind(pluginId);
+    if (ctx != m_translatorContexts.constEnd()) {
+        QHash<QLocale, TranslationTable>::const_iterator table = ctx->tables.constFind(locale);
+        if (table != ctx->tables.constEnd()) {
+            if (!table->translator) {
+                return string;
+            }
+            QHash<QString, QString>::const_iterator translation = table->strings.constFind(string);
+            if (translation != table->strings.constEnd()) {
+                return translation.value();
+            }
+            // Not part of the metadata, e.g. a setup message
+            return translateString(ctx.value(), table.value(), string);
+        }
+    }
+
     IntegrationPlugin *plugin = m_thingManager->plugins().findById(pluginId);
     if (!plugin) {
         qCDebug(dcThingManager()) << "Unable to translate" << string << "Plugin not found";
         return string;
     }
 
-    if (!m_translatorContexts.contains(plugin->pluginId()) || !m_translatorContexts.value(plugin->pluginId()).translators.contains(locale.name())) {
-        loadTranslator(plugin, locale);
-    }
+    loadTranslator(plugin, locale);
+    return translate(pluginId, string, locale);
+}
 
-    QTranslator* translator = m_translatorContexts.value(plugin->pluginId()).translators.value(locale.name());
-    QString translatedString = translator->translate(plugin->pluginName().toUtf8(), string.toUtf8());
+QString Translator::translateString(const TranslatorContext &ctx, const TranslationTable &table, const QString &string) const
+{
+    QByteArray sourceText = string.toUtf8();
+    QString translatedString = table.translator->translate(ctx.pluginName, sourceText);
     if (translatedString.isEmpty()) {
-        translatedString = translator->translate(plugin->metaObject()->className(), string.toUtf8());
+        translatedString = table.translator->translate(ctx.className, sourceText);
     }
     return translatedString.isEmpty() ? string : translatedString;
 }
 
+QStringList Translator::metaDataStrings(IntegrationPlugin *plugin)
+{
+    QStringList strings = {plugin->pluginDisplayName()};
+    foreach (const ParamType &paramType, plugin->configurationDescription()) {
+        strings.append(paramType.displayName());
+    }
+    foreach (const Vendor &vendor, plugin->supportedVendors()) {
+        strings.append(vendor.displayName());
+    }
+    foreach (const ThingClass &thingClass, plugin->supportedThings()) {
+        strings.append(thingClass.displayName());
+        foreach (const ParamType &paramType, thingClass.paramTypes() + thingClass.settingsTypes() + thingClass.discoveryParamTypes()) {
+            strings.append(paramType.displayName());
+        }
+        foreach (const StateType &stateType, thingClass.stateTypes()) {
+            strings.append(stateType.displayName());
+            strings.append(stateType.possibleValuesDisplayNames());
+        }
+        foreach (const EventType &eventType, thingClass.eventTypes()) {
+            strings.append(eventType.displayName());
+            foreach (const ParamType &paramType, eventType.paramTypes()) {
+                strings.append(paramType.displayName());
+            }
+        }
+        foreach (const ActionType &actionType, thingClass.actionTypes() + thingClass.browserItemActionTypes()) {
+            strings.append(actionType.displayName());
+            foreach (const ParamType &paramType, actionType.paramTypes()) {
+                strings.append(paramType.displayName());
+            }
+        }
+    }
+    return strings;
+}
+
 void Translator::loadTranslator(IntegrationPlugin *plugin, const QLocale &locale)
 {
     if (!m_translatorContexts.contains(plugin->pluginId())) {
-        // Create default translator for this plugin
-        TranslatorContext defaultCtx;
-        defaultCtx.pluginId = plugin->pluginId();
-        defaultCtx.translators.insert("en_US", new QTranslator());
-        m_translatorContexts.insert(plugin->pluginId(), defaultCtx);
-        if (locale == QLocale("en_US")) {
-            return;
+        TranslatorContext ctx;
+        ctx.pluginId = plugin->pluginId();
+        ctx.pluginName = plugin->pluginName().toUtf8();
+        ctx.className = plugin->metaObject()->className();
+        // The metadata is written in en_US, there is nothing to translate
+        ctx.tables.insert(QLocale("en_US"), TranslationTable());
+        m_translatorContexts.insert(plugin->pluginId(), ctx);
+    }
+
+    TranslatorContext &ctx = m_translatorContexts[plugin->pluginId()];
+    if (ctx.tables.contains(locale)) {
+        return;
+    }
+
+    TranslationTable table;
+    table.translator = loadTranslationFile(plugin, locale);
+    if (table.translator) {
+        foreach (const QString &string, metaDataStrings(plugin)) {
+            if (!string.isEmpty() && !table.strings.contains(string)) {
+                table.strings.insert(string, translateString(ctx, table, string));
+            }
         }
+        qCDebug(dcTranslations()) << "Prepared" << table.strings.count() << "translations" << locale.name() << "for plugin" << plugin->pluginName();
     }
+    ctx.tables.insert(locale, table);
+}
 
+QTranslator *Translator::loadTranslationFile(IntegrationPlugin *plugin, const QLocale &locale)
+{
     bool loaded = false;
     // check if there are local translations
     QTranslator* translator = new QTranslator();
@@ -129,14 +200,9 @@ void Translator::loadTranslator(IntegrationPlugin *plugin, const QLocale &locale
 
 
     if (!loaded) {
-        translator = m_translatorContexts.value(plugin->pluginId()).translators.value("en_US");
-    }
-
-    if (!m_translatorContexts.contains(plugin->pluginId())) {
-        TranslatorContext ctx;
-        ctx.pluginId = plugin->pluginId();
-        m_translatorContexts.insert(plugin->pluginId(), ctx);
+        delete translator;
+        return nullptr;
     }
-    m_translatorContexts[plugin->pluginId()].translators.insert(locale.name(), translator);
 
+    return translator;
 }
@@ -28,6 +28,8 @@
 #include "typeutils.h"
 #include "types/thingclass.h"
 
+#include <QHash>
+#include <QLocale>
 #include <QTranslator>
 
 class IntegrationPlugin;
@@ -42,15 +44,28 @@ public:
     QString translate(const PluginId &pluginId, const QString &string, const QLocale &locale);
 
 private:
+    struct TranslationTable {
+        // nullptr if there is no translation for this locale
+        QTranslator *translator = nullptr;
+        // Translations of all strings in the plugin metadata, built once when loading the locale
+        QHash<QString, QString> strings;
+    };
+
+    struct TranslatorContext {
+        PluginId pluginId;
+        QByteArray pluginName;
+        QByteArray className;
+        QHash<QLocale, TranslationTable> tables;
+    };
+
     void loadTranslator(IntegrationPlugin *plugin, const QLocale &locale);
+    QTranslator *loadTranslationFile(IntegrationPlugin *plugin, const QLocale &locale);
+    QString translateString(const TranslatorContext &ctx, const TranslationTable &table, const QString &string) const;
+    static QStringList metaDataStrings(IntegrationPlugin *plugin);
 
 private:
     ThingManagerImplementation *m_thingManager = nullptr;
 
-    struct TranslatorContext {
-        PluginId pluginId;
-        QHash<QString, QTranslator*> translators;
-    };
     QHash<PluginId, TranslatorContext> m_translatorContexts;
 };
 
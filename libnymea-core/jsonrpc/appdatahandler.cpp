@@ -25,13 +25,25 @@
 #include "appdatahandler.h"
 #include "jsonrpc/jsonrpcserver.h"
 
+#include "appdata/appdatastorage.h"
 #include "nymeasettings.h"
 
-#include <QSettings>
-#include <QDir>
+using namespace nymeaserver;
 
 AppDataHandler::AppDataHandler(QObject *parent) : JsonHandler(parent)
 {
+    m_storage = new AppDataStorage(NymeaSettings::storagePath(), this);
+    connect(m_storage, &AppDataStorage::valueChanged, this, [this](const QString &appId, const QString &group, const QString &key, const QVariant &value){
+        QVariantMap notification;
+        notification.insert("appId", appId);
+        if (!group.isEmpty()) {
+            notification.insert("group", group);
+        }
+        notification.insert("key", key);
+        notification.insert("value", value);
+        emit Changed(notification);
+    });
+
     // Methods
     QString description; QVariantMap params; QVariantMap returns;
     description = "Store an app data entry to the server. App data can be used by the client application "
@@ -61,6 +73,23 @@ AppDataHandler::AppDataHandler(QObject *parent) : JsonHandler(parent)
     returns.insert("value", enumValueName(String));
     registerMethod("Load", description, params, returns, Types::PermissionScopeControlThings);
 
+    description.clear(); params.clear(); returns.clear();
+    description = "Store multiple app data entries at once. The values map contains key-value pairs which will "
+                  "be stored in the given appId and group in the same way as Store() does for a single entry. "
+                  "A Changed notification will be emitted for each of the given entries.";
+    params.insert("appId", enumValueName(String));
+    params.insert("o:group", enumValueName(String));
+    params.insert("values", enumValueName(Object));
+    registerMethod("StoreMany", description, params, returns, Types::PermissionScopeConfigureThings);
+
+    description.clear(); params.clear(); returns.clear();
+    description = "Retrieve all app data storage values for the given appId and group at once. The values map "
+                  "contains all the keys previously set with Store() or StoreMany() and their values.";
+    params.insert("appId", enumValueName(String));
+    params.insert("o:group", enumValueName(String));
+    returns.insert("values", enumValueName(Object));
+    registerMethod("LoadAll", description, params, returns, Types::PermissionScopeControlThings);
+
     // Notifications
     description.clear(); params.clear();
     description = "Emitted whenever the app data is changed on the server.";
@@ -83,20 +112,7 @@ JsonReply* AppDataHandler::Store(const QVariantMap &params)
     QString key = params.value("key").toString();
     QVariant value = params.value("value");
 
-    // Note: we're using a different file for each group as QSettings tends to get slow with loads of keys.
-    // Might be replaced with a DB at some point if needed. However, current estimate is this won't be
-    // used for excessive amounts of data as it is mostly meant as a config file syncing mechanism.
-    QSettings settings(NymeaSettings::storagePath() + "/appdata/" + appId + '/' + group + ".conf", QSettings::IniFormat);
-    settings.setValue(key, value);
-
-    QVariantMap notification;
-    notification.insert("appId", appId);
-    if (!group.isEmpty()) {
-        notification.insert("group", group);
-    }
-    notification.insert("key", key);
-    notification.insert("value", value);
-    emit Changed(notification);
+    m_storage->setValue(appId, group, key, value);
 
     return createReply(QVariantMap());
 }
@@ -107,10 +123,34 @@ JsonReply* AppDataHandler::Load(const QVariantMap &params)
     QString group = params.value("group").toString();
     QString key = params.value("key").toString();
 
-    QSettings settings(NymeaSettings::storagePath() + "/appdata/" + appId + '/' + group + ".conf", QSettings::IniFormat);
-
     QVariantMap returns;
+    returns.insert("value", m_storage->value(appId, group, key).toString());
+    return createReply(returns);
+}
 
-    returns.insert("value", settings.value(key).toString());
+JsonReply *AppDataHandler::StoreMany(const QVariantMap &params)
+{
+    QString appId = params.value("appId").toString();
+    QString group = params.value("group").toString();
+    QVariantMap values = params.value("values").toMap();
+
+    m_storage->setValues(appId, group, values);
+
+    return createReply(QVariantMap());
+}
+
+JsonReply *AppDataHandler::LoadAll(const QVariantMap &params)
+{
+    QString appId = params.value("appId").toString();
+    QString group = params.value("group").toString();
+
+    QVariantMap values;
+    QVariantMap storedValues = m_storage->values(appId, group);
+    for (auto it = storedValues.constBegin(); it != storedValues.constEnd(); ++it) {
+        values.insert(it.key(), it.value().toString());
+    }
+
+    QVariantMap returns;
+    returns.insert("values", values);
     return createReply(returns);
 }
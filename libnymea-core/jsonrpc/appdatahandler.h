@@ -28,6 +28,10 @@
 #include <QObject>
 #include "jsonrpc/jsonhandler.h"
 
+namespace nymeaserver {
+class AppDataStorage;
+}
+
 class AppDataHandler : public JsonHandler
 {
     Q_OBJECT
@@ -38,10 +42,14 @@ public:
 
     Q_INVOKABLE JsonReply *Store(const QVariantMap &params);
     Q_INVOKABLE JsonReply *Load(const QVariantMap &params);
+    Q_INVOKABLE JsonReply *StoreMany(const QVariantMap &params);
+    Q_INVOKABLE JsonReply *LoadAll(const QVariantMap &params);
 
 signals:
     void Changed(const QVariantMap &params);
 
+private:
+    nymeaserver::AppDataStorage *m_storage = nullptr;
 };
 
 #endif // APPDATAHANDLER_H
@@ -841,15 +841,15 @@ JsonReply *ConfigurationHandler::CreateAndDownloadBackup(const QVariantMap &para
         return createReply(statusToReply(NymeaConfiguration::ConfigurationErrorBackupFailed));
     }
 
-    QFile archiveFile(archivePath);
-    if (!archiveFile.open(QIODevice::ReadOnly)) {
-        qCWarning(dcJsonRpc()) << "Failed to open created backup archive for download:" << archivePath << archiveFile.errorString();
+    if (!QFileInfo(archivePath).isReadable()) {
+        qCWarning(dcJsonRpc()) << "Failed to open created backup archive for download:" << archivePath;
         return createReply(statusToReply(NymeaConfiguration::ConfigurationErrorBackupFailed));
     }
 
-    const auto downloadInfo = NymeaCore::instance()->serverManager()->transferManager()->createDownload(QFileInfo(archiveFile).fileName(),
-                                                                                                         archiveFile.readAll(),
-                                                                                                         context);
+    // The archive is streamed from disk by the transfer connection
+    const auto downloadInfo = NymeaCore::instance()->serverManager()->transferManager()->createFileDownload(QFileInfo(archivePath).fileName(),
+                                                                                                             archivePath,
+                                                                                                             context);
 
     QVariantMap returns = statusToReply(NymeaConfiguration::ConfigurationErrorNoError);
     returns.insert("downloadId", downloadInfo.downloadId);
@@ -868,15 +868,14 @@ JsonReply *ConfigurationHandler::DownloadBackupFile(const QVariantMap &params, c
         return createReply(statusToReply(error));
     }
 
-    QFile archiveFile(archivePath);
-    if (!archiveFile.open(QIODevice::ReadOnly)) {
-        qCWarning(dcJsonRpc()) << "Failed to open backup archive for download:" << archivePath << archiveFile.errorString();
+    if (!QFileInfo(archivePath).isReadable()) {
+        qCWarning(dcJsonRpc()) << "Failed to open backup archive for download:" << archivePath;
         return createReply(statusToReply(NymeaConfiguration::ConfigurationErrorBackupFailed));
     }
 
-    const auto downloadInfo = NymeaCore::instance()->serverManager()->transferManager()->createDownload(QFileInfo(archiveFile).fileName(),
-                                                                                                         archiveFile.readAll(),
-                                                                                                         context);
+    const auto downloadInfo = NymeaCore::instance()->serverManager()->transferManager()->createFileDownload(QFileInfo(archivePath).fileName(),
+                                                                                                             archivePath,
+                                                                                                             context);
 
     QVariantMap returns = statusToReply(NymeaConfiguration::ConfigurationErrorNoError);
     returns.insert("downloadId", downloadInfo.downloadId);
@@ -27,6 +27,7 @@
 #include "nymeacore.h"
 #include "nymeasettings.h"
 #include "loggingcategories.h"
+#include "integrations/plugincallstatistics.h"
 
 namespace nymeaserver {
 
@@ -44,6 +45,20 @@ DebugHandler::DebugHandler(QObject *parent)
     loggingCategory.insert("type", enumRef<DebugHandler::LoggingCategoryType>());
     registerObject("LoggingCategory", loggingCategory);
 
+    QVariantMap pluginEntryPointStatistics;
+    pluginEntryPointStatistics.insert("name", enumValueName(String));
+    pluginEntryPointStatistics.insert("calls", enumValueName(Uint));
+    pluginEntryPointStatistics.insert("slowCalls", enumValueName(Uint));
+    pluginEntryPointStatistics.insert("totalTime", enumValueName(Double));
+    pluginEntryPointStatistics.insert("maxTime", enumValueName(Double));
+    registerObject("PluginEntryPointStatistics", pluginEntryPointStatistics);
+
+    QVariantMap pluginStatistics;
+    pluginStatistics.insert("pluginId", enumValueName(Uuid));
+    pluginStatistics.insert("pluginName", enumValueName(String));
+    pluginStatistics.insert("entryPoints", QVariantList() << objectRef("PluginEntryPointStatistics"));
+    registerObject("PluginStatistics", pluginStatistics);
+
     QVariantMap params, returns;
     QString description;
 
@@ -60,6 +75,23 @@ DebugHandler::DebugHandler(QObject *parent)
     returns.insert("debugError", enumRef<DebugHandler::DebugError>());
     registerMethod("SetLoggingCategoryLevel", description, params, returns);
 
+    params.clear(); returns.clear();
+    description = "Get the wall time spent in calls into integration plugins, accounted per plugin and per entry "
+                  "point (e.g. setupThing, executeAction, timer). Times are given in milliseconds. Calls which took "
+                  "longer than slowCallThreshold milliseconds are counted in slowCalls and logged as warning. If "
+                  "reset is true, the statistics are cleared after being returned.";
+    params.insert("o:reset", enumValueName(Bool));
+    returns.insert("slowCallThreshold", enumValueName(Int));
+    returns.insert("pluginStatistics", QVariantList() << objectRef("PluginStatistics"));
+    registerMethod("GetPluginStatistics", description, params, returns);
+
+    params.clear(); returns.clear();
+    description = "Set the threshold in milliseconds above which a call into an integration plugin is counted "
+                  "and logged as slow call. 0 disables logging of slow calls. This setting is not persistent.";
+    params.insert("slowCallThreshold", enumValueName(Int));
+    returns.insert("debugError", enumRef<DebugHandler::DebugError>());
+    registerMethod("SetPluginSlowCallThreshold", description, params, returns);
+
     // Notifications
     params.clear(); returns.clear();
     description = "Emitted whenever a logging category has changed the logging level.";
@@ -212,4 +244,27 @@ JsonReply *DebugHandler::SetLoggingCategoryLevel(const QVariantMap &params)
     return createReply(returns);
  }
 
+JsonReply *DebugHandler::GetPluginStatistics(const QVariantMap &params)
+{
+    PluginCallStatistics *statistics = NymeaCore::instance()->pluginCallStatistics();
+
+    QVariantMap returns;
+    returns.insert("slowCallThreshold", statistics->slowCallThreshold());
+    returns.insert("pluginStatistics", statistics->statistics());
+
+    if (params.value("reset").toBool()) {
+        statistics->reset();
+    }
+    return createReply(returns);
+}
+
+JsonReply *DebugHandler::SetPluginSlowCallThreshold(const QVariantMap &params)
+{
+    NymeaCore::instance()->pluginCallStatistics()->setSlowCallThreshold(params.value("slowCallThreshold").toInt());
+
+    QVariantMap returns;
+    returns.insert("debugError", enumValueName(DebugErrorNoError));
+    return createReply(returns);
+}
+
 }
@@ -62,6 +62,8 @@ public:
 public slots:
     JsonReply* GetLoggingCategories(const QVariantMap &params);
     JsonReply* SetLoggingCategoryLevel(const QVariantMap &params);
+    JsonReply* GetPluginStatistics(const QVariantMap &params);
+    JsonReply* SetPluginSlowCallThreshold(const QVariantMap &params);
 
 signals:
     void LoggingCategoryLevelChanged(const QVariantMap &params);
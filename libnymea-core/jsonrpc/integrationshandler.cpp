@@ -411,6 +411,20 @@ IntegrationsHandler::IntegrationsHandler(ThingManager *thingManager, QObject *pa
     params.insert("possibleValues", QVariantList{enumValueName(Variant)});
     registerNotification("StateChanged", description, params);
 
+    params.clear(); returns.clear();
+    description = "Emitted instead of StateChanged for connections which requested notification batching by passing "
+                  "notificationBatchInterval in JSONRPC.Hello. State changes are collected for the given interval and "
+                  "sent as one notification per thing. Only the latest value of each state within an interval is contained.";
+    QVariantMap stateChange;
+    stateChange.insert("stateTypeId", enumValueName(Uuid));
+    stateChange.insert("value", enumValueName(Variant));
+    stateChange.insert("minValue", enumValueName(Variant));
+    stateChange.insert("maxValue", enumValueName(Variant));
+    stateChange.insert("possibleValues", QVariantList{enumValueName(Variant)});
+    params.insert("thingId", enumValueName(Uuid));
+    params.insert("states", QVariantList{stateChange});
+    registerNotification("StatesChanged", description, params);
+
     params.clear(); returns.clear();
     description = "Emitted whenever a thing was removed.";
     params.insert("thingId", enumValueName(Uuid));
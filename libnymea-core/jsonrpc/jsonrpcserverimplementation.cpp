@@ -61,6 +61,7 @@
 #include "modbusrtuhandler.h"
 
 #include <QJsonDocument>
+#include <QCborValue>
 #include <QStringList>
 #include <QSslConfiguration>
 #include <QRegularExpression>
@@ -77,6 +78,7 @@ JsonRPCServerImplementation::JsonRPCServerImplementation(const QSslConfiguration
 
     // Enums
     registerEnum<BasicType>();
+    registerEnum<MessageEncoding>();
     registerEnum<UserManager::UserError>();
     registerFlag<Types::PermissionScope, Types::PermissionScopes>();
 
@@ -93,6 +95,13 @@ JsonRPCServerImplementation::JsonRPCServerImplementation(const QSslConfiguration
     cacheHash.insert("hash", enumValueName(String));
     registerObject("CacheHash", cacheHash);
 
+    QVariantMap notificationFilter;
+    notificationFilter.insert("notifications", enumValueName(StringList));
+    notificationFilter.insert("o:thingIds", QVariantList() << enumValueName(Uuid));
+    notificationFilter.insert("o:stateTypeIds", QVariantList() << enumValueName(Uuid));
+    notificationFilter.insert("o:interfaces", enumValueName(StringList));
+    registerObject("NotificationFilter", notificationFilter);
+
     // Methods
     QString description; QVariantMap returns; QVariantMap params;
     description = "Initiates a connection. Use this method to perform an initial handshake of the "
@@ -108,8 +117,20 @@ JsonRPCServerImplementation::JsonRPCServerImplementation(const QSslConfiguration
                   "a method does not change, a client may use a previously cached copy of the call instead of "
                   "fetching the content again. While the Hello call doesn't necessarily require a token, this "
                   "can be called with a token. If a token is provided, it will be verified and the reply contains "
-                  "information about the tokens validity and the user and permissions for the given token.";
+                  "information about the tokens validity and the user and permissions for the given token.\n"
+                  "If notificationBatchInterval is given with a value larger than 0 (in milliseconds, max 10000), "
+                  "Integrations.StateChanged notifications for this connection will be collected for the given "
+                  "interval and delivered as Integrations.StatesChanged notifications, one per thing, containing "
+                  "only the latest value of each state. Passing 0 disables batching again. The reply contains the "
+                  "batch interval in use for this connection.\n"
+                  "If encoding is given, all messages after the reply to this call will use the given encoding in "
+                  "both directions. With MessageEncodingCbor, messages are CBOR encoded. On stream based transports "
+                  "(TCP, Bluetooth, remote tunnel) each message is prefixed with its length as 32 bit big endian "
+                  "integer, on WebSockets each message is sent as a single binary frame. The reply contains the "
+                  "encoding in use for this connection after the reply.";
     params.insert("o:locale", enumValueName(String));
+    params.insert("o:notificationBatchInterval", enumValueName(Int));
+    params.insert("o:encoding", enumRef<MessageEncoding>());
     returns.insert("server", enumValueName(String));
     returns.insert("name", enumValueName(String));
     returns.insert("version", enumValueName(String));
@@ -125,6 +146,8 @@ JsonRPCServerImplementation::JsonRPCServerImplementation(const QSslConfiguration
     returns.insert("o:authenticated", enumValueName(Bool));
     returns.insert("o:permissionScopes", flagRef<Types::PermissionScopes>());
     returns.insert("o:username", enumValueName(String));
+    returns.insert("notificationBatchInterval", enumValueName(Int));
+    returns.insert("encoding", enumRef<MessageEncoding>());
     registerMethod("Hello", description, params, returns, Types::PermissionScopeNone);
 
     params.clear(); returns.clear();
@@ -150,10 +173,21 @@ JsonRPCServerImplementation::JsonRPCServerImplementation(const QSslConfiguration
                   "will be enabled, the others will be disabled. The return value of \"success\" will "
                   "indicate success of the operation. The \"enabled\" property in the return value is "
                   "deprecated and used for legacy compatibilty only. It will be set to true if at least "
-                  "one namespace has been enabled.";
+                  "one namespace has been enabled.\n"
+                  "In addition to whole namespaces, single notifications can be subscribed to by passing "
+                  "\"filters\". A filter subscribes to the given notifications, which may be given as full "
+                  "notification names (e.g. \"Integrations.StateChanged\") or as namespaces, which selects "
+                  "all notifications in that namespace. If thingIds, stateTypeIds or interfaces are given, "
+                  "only notifications for matching things and states will be sent. Notifications which "
+                  "don't refer to a thing or state never match a filter restricting them. A notification "
+                  "is sent if its namespace is enabled or if any of the filters matches. Each call replaces "
+                  "the filters of the previous one. The returned filters contain the full notification "
+                  "names they have been resolved to.";
     params.insert("o:namespaces", enumValueName(StringList));
     params.insert("d:o:enabled", enumValueName(Bool));
+    params.insert("o:filters", QVariantList() << objectRef("NotificationFilter"));
     returns.insert("namespaces", enumValueName(StringList));
+    returns.insert("filters", QVariantList() << objectRef("NotificationFilter"));
     returns.insert("d:enabled", enumValueName(Bool));
     registerMethod("SetNotificationStatus", description, params, returns, Types::PermissionScopeNone);
 
@@ -239,6 +273,14 @@ JsonReply *JsonRPCServerImplementation::Hello(const QVariantMap &params, const J
     if (params.contains("locale")) {
         m_clientLocales.insert(clientId, QLocale(params.value("locale").toString()));
     }
+    if (params.contains("notificationBatchInterval")) {
+        setNotificationBatchInterval(clientId, params.value("notificationBatchInterval").toInt());
+    }
+    MessageEncoding encoding = m_clientEncodings.value(clientId, MessageEncodingJson);
+    if (params.contains("encoding")) {
+        encoding = enumNameToValue<MessageEncoding>(params.value("encoding").toString());
+        m_requestedEncodings.insert(clientId, encoding);
+    }
 
     qCDebug(dcJsonRpc()) << "Client" << clientId << "initiated handshake." << m_clientLocales.value(clientId);
 
@@ -260,6 +302,8 @@ JsonReply *JsonRPCServerImplementation::Hello(const QVariantMap &params, const J
     handshake.insert("initialSetupRequired", (interface->configuration().authenticationEnabled ? NymeaCore::instance()->userManager()->initRequired() : false));
     handshake.insert("authenticationRequired", interface->configuration().authenticationEnabled);
     handshake.insert("pushButtonAuthAvailable", NymeaCore::instance()->userManager()->pushButtonAuthAvailable());
+    handshake.insert("notificationBatchInterval", m_clientBatchTimers.contains(clientId) ? m_clientBatchTimers.value(clientId)->interval() : 0);
+    handshake.insert("encoding", enumValueName(encoding));
     if (!m_experiences.isEmpty()) {
         QVariantList experiences;
         foreach (JsonHandler* handler, m_experiences.keys()) {
@@ -350,10 +394,46 @@ JsonReply* JsonRPCServerImplementation::SetNotificationStatus(const QVariantMap
     qCDebug(dcJsonRpc()) << "Notification settings for client" << clientId << ":" << enabledNamespaces;
     m_clientNotifications[clientId] = enabledNamespaces;
 
+    removeNotificationFilters(clientId);
+    QVariantList filters;
+    foreach (const QVariant &filterVariant, params.value("filters").toList()) {
+        QVariantMap filterMap = filterVariant.toMap();
+
+        NotificationFilter filter;
+        foreach (const QVariant &thingId, filterMap.value("thingIds").toList()) {
+            filter.thingIds.insert(thingId.toUuid());
+        }
+        foreach (const QVariant &stateTypeId, filterMap.value("stateTypeIds").toList()) {
+            filter.stateTypeIds.insert(stateTypeId.toUuid());
+        }
+        filter.interfaces = filterMap.value("interfaces").toStringList();
+
+        QStringList notificationNames;
+        foreach (const QString &name, filterMap.value("notifications").toStringList()) {
+            if (m_handlers.contains(name)) {
+                foreach (const QString &notificationName, m_handlers.value(name)->jsonNotifications().keys()) {
+                    notificationNames.append(name + '.' + notificationName);
+                }
+            } else if (m_api.value("notifications").toMap().contains(name)) {
+                notificationNames.append(name);
+            }
+        }
+        notificationNames.removeDuplicates();
+
+        foreach (const QString &notificationName, notificationNames) {
+            m_notificationFilters[notificationName][clientId].append(filter);
+        }
+
+        filterMap.insert("notifications", notificationNames);
+        filters.append(filterMap);
+    }
+    qCDebug(dcJsonRpc()) << "Notification filters for client" << clientId << ":" << filters;
+
     QVariantMap returns;
     returns.insert("namespaces", m_clientNotifications[clientId]);
+    returns.insert("filters", filters);
     // legacy, deprecated
-    returns.insert("enabled", m_clientNotifications[clientId].count() > 0);
+    returns.insert("enabled", m_clientNotifications[clientId].count() > 0 || !filters.isEmpty());
     return createReply(returns);
 }
 
@@ -481,9 +561,7 @@ void JsonRPCServerImplementation::sendResponse(TransportInterface *interface, co
         response.insert("deprecationWarning", deprecationWarning);
     }
 
-    QByteArray data = QJsonDocument::fromVariant(response).toJson(QJsonDocument::Compact);
-    qCDebug(dcJsonRpcTraffic()) << "Sending data:" << data;
-    interface->sendData(clientId, data);
+    sendMessage(interface, clientId, response);
 }
 
 /*! Send a JSON error response to the client with the given \a clientId,
@@ -496,9 +574,7 @@ void JsonRPCServerImplementation::sendErrorResponse(TransportInterface *interfac
     errorResponse.insert("status", "error");
     errorResponse.insert("error", error);
 
-    QByteArray data = QJsonDocument::fromVariant(errorResponse).toJson(QJsonDocument::Compact);
-    qCDebug(dcJsonRpcTraffic()) << "Sending data:" << data;
-    interface->sendData(clientId, data);
+    sendMessage(interface, clientId, errorResponse);
 }
 
 void JsonRPCServerImplementation::sendUnauthorizedResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QString &error)
@@ -508,7 +584,19 @@ void JsonRPCServerImplementation::sendUnauthorizedResponse(TransportInterface *i
     errorResponse.insert("status", "unauthorized");
     errorResponse.insert("error", error);
 
-    QByteArray data = QJsonDocument::fromVariant(errorResponse).toJson(QJsonDocument::Compact);
+    sendMessage(interface, clientId, errorResponse);
+}
+
+void JsonRPCServerImplementation::sendMessage(TransportInterface *interface, const QUuid &clientId, const QVariantMap &message)
+{
+    if (m_clientEncodings.value(clientId, MessageEncodingJson) == MessageEncodingCbor) {
+        QByteArray data = QCborValue::fromVariant(message).toCbor();
+        qCDebug(dcJsonRpcTraffic()) << "Sending CBOR data:" << message;
+        interface->sendBinaryData(clientId, data);
+        return;
+    }
+
+    QByteArray data = QJsonDocument::fromVariant(message).toJson(QJsonDocument::Compact);
     qCDebug(dcJsonRpcTraffic()) << "Sending data:" << data;
     interface->sendData(clientId, data);
 }
@@ -518,7 +606,9 @@ void JsonRPCServerImplementation::setup()
     registerHandler(this);
     registerHandler(new IntegrationsHandler(NymeaCore::instance()->thingManager(), this));
     registerHandler(new RulesHandler(NymeaCore::instance()->ruleEngine(), this));
-    registerHandler(new LoggingHandler(NymeaCore::instance()->logEngine(), this));
+    LoggingHandler *loggingHandler = new LoggingHandler(NymeaCore::instance()->logEngine(), this);
+    connect(this, &JsonRPCServerImplementation::clientRemoved, loggingHandler, &LoggingHandler::onClientDisconnected);
+    registerHandler(loggingHandler);
     registerHandler(new ConfigurationHandler(this));
     registerHandler(new NetworkManagerHandler(NymeaCore::instance()->networkManager(), this));
     registerHandler(new TagsHandler(this));
@@ -536,22 +626,24 @@ void JsonRPCServerImplementation::processData(const QUuid &clientId, const QByte
 
     TransportInterface *interface = qobject_cast<TransportInterface *>(sender());
 
-    // Handle packet fragmentation
-    QByteArray buffer = m_clientBuffers[clientId];
-    buffer.append(data);
-    int splitIndex = buffer.indexOf("}\n{");
-    while (splitIndex > -1) {
-        processJsonPacket(interface, clientId, buffer.left(splitIndex + 1));
-        buffer = buffer.right(buffer.length() - splitIndex - 2);
-        splitIndex = buffer.indexOf("}\n{");
+    // Handle packet fragmentation. Only the newly received bytes are scanned for message boundaries.
+    // Keep a reference to the reader as the client might be disconnected while processing a message.
+    QSharedPointer<JsonRpcStreamReader> reader = m_clientReaders.value(clientId);
+    if (!reader) {
+        reader = QSharedPointer<JsonRpcStreamReader>::create();
+        m_clientReaders.insert(clientId, reader);
     }
-    if (buffer.trimmed().endsWith("}")) {
-        processJsonPacket(interface, clientId, buffer);
-        buffer.clear();
+    reader->append(data);
+
+    QByteArray message;
+    while (reader->readMessage(&message)) {
+        processJsonPacket(interface, clientId, message);
+        if (m_clientReaders.value(clientId) != reader) {
+            return;
+        }
     }
-    m_clientBuffers[clientId] = buffer;
 
-    if (buffer.size() > 1024 * 1024) {
+    if (reader->bufferedSize() > 1024 * 1024) {
         qCWarning(dcJsonRpc()) << "Client buffer larger than 1MB and no valid data. Dropping client connection.";
         interface->terminateClientConnection(clientId);
     }
@@ -559,16 +651,28 @@ void JsonRPCServerImplementation::processData(const QUuid &clientId, const QByte
 
 void JsonRPCServerImplementation::processJsonPacket(TransportInterface *interface, const QUuid &clientId, const QByteArray &data)
 {
-    QJsonParseError error;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    QVariantMap message;
+    if (m_clientEncodings.value(clientId, MessageEncodingJson) == MessageEncodingCbor) {
+        QCborParserError error;
+        QCborValue cborValue = QCborValue::fromCbor(data, &error);
+        if (error.error != QCborError::NoError) {
+            qCWarning(dcJsonRpc()) << "Failed to parse CBOR data" << data.toHex() << ":" << error.errorString();
+            sendErrorResponse(interface, clientId, -1, QString("Failed to parse CBOR data: %1").arg(error.errorString()));
+            return;
+        }
+        message = cborValue.toVariant().toMap();
+    } else {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
 
-    if(error.error != QJsonParseError::NoError) {
-        qCWarning(dcJsonRpc()) << "Failed to parse JSON data" << data << ":" << error.errorString();
-        sendErrorResponse(interface, clientId, -1, QString("Failed to parse JSON data: %1").arg(error.errorString()));
-        return;
-    }
+        if(error.error != QJsonParseError::NoError) {
+            qCWarning(dcJsonRpc()) << "Failed to parse JSON data" << data << ":" << error.errorString();
+            sendErrorResponse(interface, clientId, -1, QString("Failed to parse JSON data: %1").arg(error.errorString()));
+            return;
+        }
 
-    QVariantMap message = jsonDoc.toVariant().toMap();
+        message = jsonDoc.toVariant().toMap();
+    }
 
     bool success;
     int commandId = message.value("id").toInt(&success);
@@ -655,9 +759,7 @@ void JsonRPCServerImplementation::processJsonPacket(TransportInterface *interfac
 
     QVariantMap params = message.value("params").toMap();
 
-    QVariantMap definition = handler->jsonMethods().value(method).toMap().value("params").toMap();
-    JsonValidator validator;
-    JsonValidator::Result validationResult = validator.validateParams(params, targetNamespace + '.' + method, m_api);
+    JsonValidator::Result validationResult = m_validator.validateParams(params, targetNamespace + '.' + method);
     if (!validationResult.success()) {
         qCWarning(dcJsonRpc()) << "JSON RPC parameter verification failed for method" << targetNamespace + '.' + method;
         qCWarning(dcJsonRpc()) << validationResult.errorString() << "in" << validationResult.where();
@@ -706,10 +808,9 @@ void JsonRPCServerImplementation::processJsonPacket(TransportInterface *interfac
             return;
         }
 
-        JsonValidator validator;
-        Q_ASSERT_X((targetNamespace == "JSONRPC" && method == "Introspect") || validator.validateReturns(reply->data(), targetNamespace + '.' + method, m_api).success(),
-                   validator.result().where().toUtf8(),
-                   validator.result().errorString().toUtf8() + "\nReturn value:\n" + QJsonDocument::fromVariant(reply->data()).toJson());
+        Q_ASSERT_X((targetNamespace == "JSONRPC" && method == "Introspect") || m_validator.validateReturns(reply->data(), targetNamespace + '.' + method).success(),
+                   m_validator.result().where().toUtf8(),
+                   m_validator.result().errorString().toUtf8() + "\nReturn value:\n" + QJsonDocument::fromVariant(reply->data()).toJson());
 
         QString deprecationWarning;
         if (m_api.value("methods").toMap().value(targetNamespace + '.' + method).toMap().contains("deprecated")) {
@@ -720,6 +821,26 @@ void JsonRPCServerImplementation::processJsonPacket(TransportInterface *interfac
 
         sendResponse(interface, clientId, commandId, reply->data(), deprecationWarning);
         reply->deleteLater();
+
+        // The handshake reply is sent in the encoding of the request, a newly requested encoding applies from now on
+        if (m_requestedEncodings.contains(clientId)) {
+            setClientEncoding(clientId, m_requestedEncodings.take(clientId));
+        }
+    }
+}
+
+void JsonRPCServerImplementation::setClientEncoding(const QUuid &clientId, MessageEncoding encoding)
+{
+    qCDebug(dcJsonRpc()) << "Client" << clientId << "switching to" << encoding;
+    if (encoding == MessageEncodingJson) {
+        m_clientEncodings.remove(clientId);
+    } else {
+        m_clientEncodings.insert(clientId, encoding);
+    }
+
+    QSharedPointer<JsonRpcStreamReader> reader = m_clientReaders.value(clientId);
+    if (reader) {
+        reader->setFraming(encoding == MessageEncodingJson ? JsonRpcStreamReader::FramingJson : JsonRpcStreamReader::FramingLengthPrefixed);
     }
 }
 
@@ -732,12 +853,10 @@ void JsonRPCServerImplementation::sendNotification(const QVariantMap &params)
     notification.insert("id", m_notificationId++);
     notification.insert("notification", handler->name() + "." + method.name());
 
-    foreach (const QUuid &clientId, m_clientNotifications.keys()) {
+    foreach (const QUuid &clientId, notificationRecipients(handler->name(), method.name(), params)) {
 
-        // Check if this client wants to be notified
-        if (!m_clientNotifications.value(clientId).contains(handler->name())) {
-            continue;
-        }
+        // Keep the order: deliver collected state changes before anything else
+        flushStateChanges(clientId);
 
         // Add deprecation warning if necessary
         if (m_api.value("notifications").toMap().value(handler->name() + '.' + method.name()).toMap().contains("deprecated")) {
@@ -750,19 +869,14 @@ void JsonRPCServerImplementation::sendNotification(const QVariantMap &params)
         QLocale locale = m_clientLocales.value(clientId);
         QVariantMap translatedParams = handler->translateNotification(method.name(), params, locale);
 
-        JsonValidator validator;
-        Q_ASSERT_X(validator.validateNotificationParams(translatedParams, handler->name() + '.' + method.name(), m_api).success(),
-                   validator.result().where().toUtf8(),
-                   validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(translatedParams).toJson(QJsonDocument::Indented));
+        Q_ASSERT_X(m_validator.validateNotificationParams(translatedParams, handler->name() + '.' + method.name()).success(),
+                   m_validator.result().where().toUtf8(),
+                   m_validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(translatedParams).toJson(QJsonDocument::Indented));
 
         notification.insert("params", translatedParams);
 
-        QByteArray data = QJsonDocument::fromVariant(notification).toJson(QJsonDocument::Compact);
-
         qCDebug(dcJsonRpc()) << "Sending notification" << handler->name() + "." + method.name() << "to client" << clientId;
-        qCDebug(dcJsonRpcTraffic()) << "Notification content:" << data;
-
-        m_clientTransports.value(clientId)->sendData(clientId, data);
+        sendMessage(m_clientTransports.value(clientId), clientId, notification);
     }
 }
 
@@ -776,15 +890,16 @@ void JsonRPCServerImplementation::sendClientNotification(const QUuid &clientId,
         return;
     }
 
+    flushStateChanges(clientId);
+
     QVariantMap notification;
     notification.insert("id", m_notificationId++);
     notification.insert("notification", handler->name() + "." + method.name());
     notification.insert("params", params);
 
-    JsonValidator validator;
-    Q_ASSERT_X(validator.validateNotificationParams(params, handler->name() + '.' + method.name(), m_api).success(),
-               validator.result().where().toUtf8(),
-               validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+    Q_ASSERT_X(m_validator.validateNotificationParams(params, handler->name() + '.' + method.name()).success(),
+               m_validator.result().where().toUtf8(),
+               m_validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
 
     if (m_api.value("notifications").toMap().value(handler->name() + '.' + method.name()).toMap().contains("deprecated")) {
         QString deprecationMessage = m_api.value("notifications").toMap().value(handler->name() + '.' + method.name()).toMap().value("deprecated").toString();
@@ -793,10 +908,8 @@ void JsonRPCServerImplementation::sendClientNotification(const QUuid &clientId,
         notification.insert("deprecationWarning", deprecationMessage);
     }
 
-    QByteArray data = QJsonDocument::fromVariant(notification).toJson(QJsonDocument::Compact);
-    qCDebug(dcJsonRpcTraffic()) << "Notification content:" << data;
     qCDebug(dcJsonRpc()) << "Sending notification:" << handler->name() + "." + method.name();
-    m_clientTransports.value(clientId)->sendData(clientId, data);
+    sendMessage(m_clientTransports.value(clientId), clientId, notification);
 }
 
 void JsonRPCServerImplementation::sendClientNotification(const QVariantMap &params, const ThingId &thingId)
@@ -808,11 +921,9 @@ void JsonRPCServerImplementation::sendClientNotification(const QVariantMap &para
     notification.insert("id", m_notificationId++);
     notification.insert("notification", handler->name() + "." + method.name());
 
-    foreach (const QUuid &clientId, m_clientNotifications.keys()) {
+    const bool isStateChange = handler->name() == QLatin1String("Integrations") && method.name() == "StateChanged";
 
-        // Check if this client wants to be notified
-        if (!m_clientNotifications.value(clientId).contains(handler->name()))
-            continue;
+    foreach (const QUuid &clientId, notificationRecipients(handler->name(), method.name(), params, thingId)) {
 
         // Make sure this client is allowed to receive this notification
         TransportInterface *transport = m_clientTransports.value(clientId, nullptr);
@@ -826,6 +937,19 @@ void JsonRPCServerImplementation::sendClientNotification(const QVariantMap &para
             }
         }
 
+        // Collect state changes for clients which requested batching, the batch timer will deliver them
+        if (m_clientBatchTimers.contains(clientId)) {
+            if (isStateChange) {
+                m_pendingStateChanges[clientId][thingId].insert(params.value("stateTypeId").toUuid(), params);
+                QTimer *batchTimer = m_clientBatchTimers.value(clientId);
+                if (!batchTimer->isActive()) {
+                    batchTimer->start();
+                }
+                continue;
+            }
+            flushStateChanges(clientId);
+        }
+
         // Add deprecation warning if necessary
         if (m_api.value("notifications").toMap().value(handler->name() + '.' + method.name()).toMap().contains("deprecated")) {
             QString deprecationMessage = m_api.value("notifications").toMap().value(handler->name() + '.' + method.name()).toMap().value("deprecated").toString();
@@ -837,19 +961,14 @@ void JsonRPCServerImplementation::sendClientNotification(const QVariantMap &para
         QLocale locale = m_clientLocales.value(clientId);
         QVariantMap translatedParams = handler->translateNotification(method.name(), params, locale);
 
-        JsonValidator validator;
-        Q_ASSERT_X(validator.validateNotificationParams(translatedParams, handler->name() + '.' + method.name(), m_api).success(),
-                   validator.result().where().toUtf8(),
-                   validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(translatedParams).toJson(QJsonDocument::Indented));
+        Q_ASSERT_X(m_validator.validateNotificationParams(translatedParams, handler->name() + '.' + method.name()).success(),
+                   m_validator.result().where().toUtf8(),
+                   m_validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(translatedParams).toJson(QJsonDocument::Indented));
 
         notification.insert("params", translatedParams);
 
-        QByteArray data = QJsonDocument::fromVariant(notification).toJson(QJsonDocument::Compact);
-
         qCDebug(dcJsonRpc()) << "Sending notification" << handler->name() + "." + method.name() << "to client" << clientId;
-        qCDebug(dcJsonRpcTraffic()) << "Notification content:" << data;
-
-        m_clientTransports.value(clientId)->sendData(clientId, data);
+        sendMessage(m_clientTransports.value(clientId), clientId, notification);
     }
 }
 
@@ -879,6 +998,146 @@ void JsonRPCServerImplementation::sendClientNotification(const QVariantMap &para
     }
 }
 
+QList<QUuid> JsonRPCServerImplementation::notificationRecipients(const QString &nameSpace, const QString &notificationName, const QVariantMap &params, const ThingId &thingId) const
+{
+    QList<QUuid> recipients;
+    for (auto it = m_clientNotifications.constBegin(); it != m_clientNotifications.constEnd(); ++it) {
+        if (it.value().contains(nameSpace)) {
+            recipients.append(it.key());
+        }
+    }
+
+    const QHash<QUuid, QList<NotificationFilter>> clientFilters = m_notificationFilters.value(nameSpace + '.' + notificationName);
+    if (clientFilters.isEmpty()) {
+        return recipients;
+    }
+
+    // Find out what this notification refers to once, not for every filter
+    ThingId subjectThingId = thingId.isNull() ? ThingId(params.value("thingId").toUuid()) : thingId;
+    StateTypeId subjectStateTypeId = params.value("stateTypeId").toUuid();
+    QString logStateName;
+    if (subjectThingId.isNull() && nameSpace == QLatin1String("Logging") && notificationName == QLatin1String("LogEntryAdded")) {
+        // Log entries only carry their source, e.g. "state-{thingId}-stateName"
+        static const QRegularExpression thingSource("^(state|event|action)-(\\{[0-9a-fA-F-]{36}\\})-(.+)$");
+        QRegularExpressionMatch match = thingSource.match(params.value("logEntry").toMap().value("source").toString());
+        if (match.hasMatch()) {
+            subjectThingId = ThingId(QUuid(match.captured(2)));
+            if (match.captured(1) == QLatin1String("state")) {
+                logStateName = match.captured(3);
+            }
+        }
+    }
+    Thing *thing = subjectThingId.isNull() ? nullptr : NymeaCore::instance()->thingManager()->findConfiguredThing(subjectThingId);
+    if (thing && !logStateName.isEmpty()) {
+        subjectStateTypeId = thing->thingClass().stateTypes().findByName(logStateName).id();
+    }
+    const QStringList thingInterfaces = thing ? thing->thingClass().interfaces() : QStringList();
+
+    for (auto it = clientFilters.constBegin(); it != clientFilters.constEnd(); ++it) {
+        if (recipients.contains(it.key())) {
+            continue;
+        }
+        foreach (const NotificationFilter &filter, it.value()) {
+            if (!filter.thingIds.isEmpty() && !filter.thingIds.contains(subjectThingId)) {
+                continue;
+            }
+            if (!filter.stateTypeIds.isEmpty() && !filter.stateTypeIds.contains(subjectStateTypeId)) {
+                continue;
+            }
+            if (!filter.interfaces.isEmpty()) {
+                bool implemented = false;
+                foreach (const QString &interface, filter.interfaces) {
+                    if (thingInterfaces.contains(interface)) {
+                        implemented = true;
+                        break;
+                    }
+                }
+                if (!implemented) {
+                    continue;
+                }
+            }
+            recipients.append(it.key());
+            break;
+        }
+    }
+    return recipients;
+}
+
+void JsonRPCServerImplementation::removeNotificationFilters(const QUuid &clientId)
+{
+    for (auto it = m_notificationFilters.begin(); it != m_notificationFilters.end(); ) {
+        it.value().remove(clientId);
+        if (it.value().isEmpty()) {
+            it = m_notificationFilters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void JsonRPCServerImplementation::setNotificationBatchInterval(const QUuid &clientId, int interval)
+{
+    interval = qBound(0, interval, 10000);
+    if (interval == 0) {
+        flushStateChanges(clientId);
+        delete m_clientBatchTimers.take(clientId);
+        return;
+    }
+
+    QTimer *timer = m_clientBatchTimers.value(clientId);
+    if (!timer) {
+        timer = new QTimer(this);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [this, clientId](){
+            flushStateChanges(clientId);
+        });
+        m_clientBatchTimers.insert(clientId, timer);
+    }
+    qCDebug(dcJsonRpc()) << "Batching state change notifications for client" << clientId << "every" << interval << "ms";
+    timer->setInterval(interval);
+}
+
+void JsonRPCServerImplementation::flushStateChanges(const QUuid &clientId)
+{
+    if (!m_pendingStateChanges.contains(clientId)) {
+        return;
+    }
+
+    QHash<ThingId, QHash<QUuid, QVariantMap>> pendingChanges = m_pendingStateChanges.take(clientId);
+    if (m_clientBatchTimers.contains(clientId)) {
+        m_clientBatchTimers.value(clientId)->stop();
+    }
+
+    TransportInterface *transport = m_clientTransports.value(clientId);
+    if (!transport) {
+        return;
+    }
+
+    for (auto it = pendingChanges.constBegin(); it != pendingChanges.constEnd(); ++it) {
+        QVariantList states;
+        foreach (QVariantMap stateChange, it.value()) {
+            stateChange.remove("thingId");
+            states.append(stateChange);
+        }
+
+        QVariantMap params;
+        params.insert("thingId", it.key());
+        params.insert("states", states);
+
+        QVariantMap notification;
+        notification.insert("id", m_notificationId++);
+        notification.insert("notification", "Integrations.StatesChanged");
+        notification.insert("params", params);
+
+        Q_ASSERT_X(m_validator.validateNotificationParams(params, "Integrations.StatesChanged").success(),
+                   m_validator.result().where().toUtf8(),
+                   m_validator.result().errorString().toUtf8() + "\nGot:" + QJsonDocument::fromVariant(params).toJson(QJsonDocument::Indented));
+
+        qCDebug(dcJsonRpc()) << "Sending notification Integrations.StatesChanged with" << states.count() << "states to client" << clientId;
+        sendMessage(transport, clientId, notification);
+    }
+}
+
 void JsonRPCServerImplementation::asyncReplyFinished()
 {
     JsonReply *reply = qobject_cast<JsonReply *>(sender());
@@ -889,11 +1148,10 @@ void JsonRPCServerImplementation::asyncReplyFinished()
         return;
     }
     if (!reply->timedOut()) {
-        JsonValidator validator;
         QString method = reply->handler()->name() + '.' + reply->method();
-        Q_ASSERT_X(validator.validateReturns(reply->data(), method, m_api).success()
-                   ,validator.result().where().toUtf8()
-                   ,validator.result().errorString().toUtf8() + "\nReturn value:\n" + QJsonDocument::fromVariant(reply->data()).toJson());
+        Q_ASSERT_X(m_validator.validateReturns(reply->data(), method).success()
+                   ,m_validator.result().where().toUtf8()
+                   ,m_validator.result().errorString().toUtf8() + "\nReturn value:\n" + QJsonDocument::fromVariant(reply->data()).toJson());
 
         QString deprecationWarning;
         if (m_api.value("methods").toMap().value(method).toMap().contains("deprecated")) {
@@ -1052,6 +1310,7 @@ bool JsonRPCServerImplementation::registerHandler(JsonHandler *handler)
     // Checks completed. Store new API
     qCDebug(dcJsonRpc()) << "Registering JSON RPC handler:" << handler->name();
     m_api = apiIncludingThis;
+    m_validator.compile(m_api);
 
     m_handlers.insert(handler->name(), handler);
     for (int i = 0; i < handler->metaObject()->methodCount(); ++i) {
@@ -1108,9 +1367,14 @@ void JsonRPCServerImplementation::clientDisconnected(const QUuid &clientId)
     qCDebug(dcJsonRpc()) << "Client disconnected:" << clientId;
     m_clientTransports.remove(clientId);
     m_clientNotifications.remove(clientId);
-    m_clientBuffers.remove(clientId);
+    removeNotificationFilters(clientId);
+    m_clientReaders.remove(clientId);
+    m_clientEncodings.remove(clientId);
+    m_requestedEncodings.remove(clientId);
     m_clientLocales.remove(clientId);
     m_clientTokens.remove(clientId);
+    m_pendingStateChanges.remove(clientId);
+    delete m_clientBatchTimers.take(clientId);
 
     if (m_pushButtonTransactions.values().contains(clientId)) {
         NymeaCore::instance()->userManager()->cancelPushButtonAuth(m_pushButtonTransactions.key(clientId));
@@ -1119,6 +1383,8 @@ void JsonRPCServerImplementation::clientDisconnected(const QUuid &clientId)
     if (m_newConnectionWaitTimers.contains(clientId)) {
         delete m_newConnectionWaitTimers.take(clientId);
     }
+
+    emit clientRemoved(clientId);
 }
 
 }
@@ -27,6 +27,8 @@
 
 #include "jsonrpc/jsonrpcserver.h"
 #include "jsonrpc/jsonhandler.h"
+#include "jsonrpcstreamreader.h"
+#include "jsonvalidator.h"
 #include "usermanager/userinfo.h"
 #include "transportinterface.h"
 
@@ -34,6 +36,8 @@
 #include <QVariantMap>
 #include <QString>
 #include <QSslConfiguration>
+#include <QSharedPointer>
+#include <QSet>
 
 class Thing;
 
@@ -43,6 +47,12 @@ class JsonRPCServerImplementation: public JsonHandler, public JsonRPCServer
 {
     Q_OBJECT
 public:
+    enum MessageEncoding {
+        MessageEncodingJson,
+        MessageEncodingCbor
+    };
+    Q_ENUM(MessageEncoding)
+
     JsonRPCServerImplementation(const QSslConfiguration &sslConfiguration = QSslConfiguration(), QObject *parent = nullptr);
 
     // JsonHandler API implementation
@@ -59,6 +69,7 @@ public:
 
 signals:
     void PushButtonAuthFinished(const QUuid &clientId, const QVariantMap &params);
+    void clientRemoved(const QUuid &clientId);
 
     // Server API
 public:
@@ -75,8 +86,18 @@ private:
     void sendErrorResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QString &error);
     void sendUnauthorizedResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QString &error);
 
+    void sendMessage(TransportInterface *interface, const QUuid &clientId, const QVariantMap &message);
+
     void processJsonPacket(TransportInterface *interface, const QUuid &clientId, const QByteArray &data);
 
+    void setClientEncoding(const QUuid &clientId, MessageEncoding encoding);
+
+    QList<QUuid> notificationRecipients(const QString &nameSpace, const QString &notificationName, const QVariantMap &params, const ThingId &thingId = ThingId()) const;
+    void removeNotificationFilters(const QUuid &clientId);
+
+    void setNotificationBatchInterval(const QUuid &clientId, int interval);
+    void flushStateChanges(const QUuid &clientId);
+
 private slots:
     void setup();
 
@@ -96,18 +117,36 @@ private slots:
 
 private:
     QVariantMap m_api;
+    JsonValidator m_validator;
     QHash<JsonHandler *, QString> m_experiences;
     QHash<QString, JsonHandler *> m_handlers;
     QHash<JsonReply *, TransportInterface *> m_asyncReplies;
 
     QHash<QUuid, TransportInterface *> m_clientTransports;
-    QHash<QUuid, QByteArray> m_clientBuffers;
+    QHash<QUuid, QSharedPointer<JsonRpcStreamReader>> m_clientReaders;
+    // Clients using a non-JSON encoding, and encodings requested in the handshake which apply after its reply
+    QHash<QUuid, MessageEncoding> m_clientEncodings;
+    QHash<QUuid, MessageEncoding> m_requestedEncodings;
     QHash<QUuid, QStringList> m_clientNotifications;
+
+    // Subscriptions to single notifications, restricted to things, states or interfaces
+    struct NotificationFilter {
+        QSet<QUuid> thingIds;
+        QSet<QUuid> stateTypeIds;
+        QStringList interfaces;
+    };
+    // notification name -> clientId -> filters
+    QHash<QString, QHash<QUuid, QList<NotificationFilter>>> m_notificationFilters;
     QHash<QUuid, QLocale> m_clientLocales;
     QHash<QUuid, QByteArray> m_clientTokens;
     QHash<int, QUuid> m_pushButtonTransactions;
     QHash<QUuid, QTimer *> m_newConnectionWaitTimers;
 
+    // Clients which requested notification batching in the handshake
+    QHash<QUuid, QTimer *> m_clientBatchTimers;
+    // clientId -> thingId -> stateTypeId -> latest StateChanged params
+    QHash<QUuid, QHash<ThingId, QHash<QUuid, QVariantMap>>> m_pendingStateChanges;
+
     QHash<QString, JsonReply *> m_pairingRequests;
 
     int m_notificationId;
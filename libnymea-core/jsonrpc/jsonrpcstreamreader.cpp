@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "jsonrpcstreamreader.h"
+
+#include <QtEndian>
+
+namespace nymeaserver {
+
+JsonRpcStreamReader::JsonRpcStreamReader()
+{
+
+}
+
+JsonRpcStreamReader::Framing JsonRpcStreamReader::framing() const
+{
+    return m_framing;
+}
+
+void JsonRpcStreamReader::setFraming(Framing framing)
+{
+    m_framing = framing;
+
+    // Start over with whatever has not been handed out yet
+    m_scanPosition = m_readPosition;
+    m_messageStart = -1;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
+
+    // The message which switched the framing is usually terminated by a line break
+    m_skipLineBreak = (framing == FramingLengthPrefixed);
+}
+
+void JsonRpcStreamReader::append(const QByteArray &data)
+{
+    if (m_readPosition > 0) {
+        m_buffer.remove(0, m_readPosition);
+        m_scanPosition -= m_readPosition;
+        if (m_messageStart >= 0) {
+            m_messageStart -= m_readPosition;
+        }
+        m_readPosition = 0;
+    }
+    m_buffer.append(data);
+}
+
+bool JsonRpcStreamReader::readMessage(QByteArray *message)
+{
+    if (m_framing == FramingLengthPrefixed) {
+        return readLengthPrefixedMessage(message);
+    }
+
+    const char *data = m_buffer.constData();
+    const int size = m_buffer.size();
+
+    while (m_scanPosition < size) {
+        const char c = data[m_scanPosition++];
+
+        if (m_messageStart < 0) {
+            // Skip whitespace between messages
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                m_readPosition = m_scanPosition;
+                continue;
+            }
+            m_messageStart = m_scanPosition - 1;
+        }
+
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            } else if (c == '\n') {
+                // JSON strings can't contain raw line breaks. Hand out what we have and let the parser complain.
+                return takeMessage(message, m_scanPosition - 1);
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            break;
+        case '{':
+        case '[':
+            m_depth++;
+            break;
+        case '}':
+        case ']':
+            m_depth--;
+            if (m_depth <= 0) {
+                return takeMessage(message, m_scanPosition);
+            }
+            break;
+        case '\n':
+            // Garbage outside of any object. Hand it out so the client gets an error.
+            if (m_depth <= 0) {
+                return takeMessage(message, m_scanPosition - 1);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+int JsonRpcStreamReader::bufferedSize() const
+{
+    return m_buffer.size() - m_readPosition;
+}
+
+bool JsonRpcStreamReader::readLengthPrefixedMessage(QByteArray *message)
+{
+    while (m_skipLineBreak && bufferedSize() > 0) {
+        const char c = m_buffer.at(m_readPosition);
+        if (c != '\r' && c != '\n') {
+            m_skipLineBreak = false;
+            break;
+        }
+        m_readPosition++;
+        m_scanPosition = m_readPosition;
+    }
+
+    if (bufferedSize() < 4) {
+        return false;
+    }
+
+    const char *data = m_buffer.constData() + m_readPosition;
+    const quint32 length = qFromBigEndian<quint32>(data);
+    if (static_cast<quint32>(bufferedSize() - 4) < length) {
+        return false;
+    }
+
+    *message = QByteArray::fromRawData(data + 4, static_cast<int>(length));
+    m_readPosition += 4 + static_cast<int>(length);
+    m_scanPosition = m_readPosition;
+    return true;
+}
+
+bool JsonRpcStreamReader::takeMessage(QByteArray *message, int end)
+{
+    *message = QByteArray::fromRawData(m_buffer.constData() + m_messageStart, end - m_messageStart);
+    m_readPosition = m_scanPosition;
+    m_messageStart = -1;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
+    return true;
+}
+
+}
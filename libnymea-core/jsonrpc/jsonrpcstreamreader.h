@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef JSONRPCSTREAMREADER_H
+#define JSONRPCSTREAMREADER_H
+
+#include <QByteArray>
+
+namespace nymeaserver {
+
+class JsonRpcStreamReader
+{
+public:
+    enum Framing {
+        // JSON objects, optionally separated by whitespace
+        FramingJson,
+        // Binary messages, each prefixed with its length as 32 bit big endian integer
+        FramingLengthPrefixed
+    };
+
+    JsonRpcStreamReader();
+
+    Framing framing() const;
+    void setFraming(Framing framing);
+
+    void append(const QByteArray &data);
+
+    // The returned message references the internal buffer and is only valid until the next call to append()
+    bool readMessage(QByteArray *message);
+
+    int bufferedSize() const;
+
+private:
+    bool readLengthPrefixedMessage(QByteArray *message);
+    bool takeMessage(QByteArray *message, int end);
+
+    Framing m_framing = FramingJson;
+    bool m_skipLineBreak = false;
+    QByteArray m_buffer;
+
+    // Everything before m_readPosition has been handed out and is dropped on the next append()
+    int m_readPosition = 0;
+    // Everything before m_scanPosition has been looked at already
+    int m_scanPosition = 0;
+
+    // State of the message currently being scanned
+    int m_messageStart = -1;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escaped = false;
+};
+
+}
+
+#endif // JSONRPCSTREAMREADER_H
@@ -30,6 +30,7 @@
 #include <QJsonDocument>
 #include <QColor>
 #include <QDateTime>
+#include <QSet>
 
 namespace nymeaserver {
 
@@ -57,6 +58,56 @@ QString stripTaggedPrefixes(QString key)
 
 }
 
+struct JsonValidator::Node
+{
+    enum Kind {
+        KindInvalid,
+        KindBasic,
+        KindEnum,
+        KindFlags,
+        KindMap,
+        KindList,
+        KindRef
+    };
+
+    struct RequiredKey {
+        QString definitionKey;
+        QString key;
+        bool readOnly = false;
+    };
+
+    Kind kind = KindInvalid;
+    // The type of the definition for the assertion on unsupported definitions
+    int definitionType = QMetaType::UnknownType;
+
+    // KindBasic
+    QString typeName;
+    JsonHandler::BasicType basicType = JsonHandler::Variant;
+    QMetaType::Type metaType = QMetaType::UnknownType;
+
+    // KindEnum, KindFlags
+    QString refName;
+    QSet<QString> enumValues;
+
+    // KindFlags: the flag enum, KindList: the entry type, KindRef: the referenced type
+    const Node *entry = nullptr;
+
+    // KindMap
+    QList<RequiredKey> requiredKeys;
+    QHash<QString, const Node *> fields;
+};
+
+JsonValidator::JsonValidator()
+{
+    m_emptyMap = createNode();
+    m_emptyMap->kind = Node::KindMap;
+}
+
+JsonValidator::~JsonValidator()
+{
+    qDeleteAll(m_nodes);
+}
+
 bool JsonValidator::checkRefs(const QVariantMap &map, const QVariantMap &api)
 {
     QVariantMap enums = api.value("enums").toMap();
@@ -98,26 +149,44 @@ bool JsonValidator::checkRefs(const QVariantMap &map, const QVariantMap &api)
 
 }
 
-JsonValidator::Result JsonValidator::validateParams(const QVariantMap &params, const QString &method, const QVariantMap &api)
+void JsonValidator::compile(const QVariantMap &api)
+{
+    QVariantMap methods = api.value("methods").toMap();
+    for (QVariantMap::const_iterator it = methods.constBegin(); it != methods.constEnd(); ++it) {
+        if (m_methodParams.contains(it.key())) {
+            continue;
+        }
+        QVariantMap method = it.value().toMap();
+        m_methodParams.insert(it.key(), compileEntry(method.value("params").toMap(), api));
+        m_methodReturns.insert(it.key(), compileEntry(method.value("returns").toMap(), api));
+    }
+
+    QVariantMap notifications = api.value("notifications").toMap();
+    for (QVariantMap::const_iterator it = notifications.constBegin(); it != notifications.constEnd(); ++it) {
+        if (m_notificationParams.contains(it.key())) {
+            continue;
+        }
+        m_notificationParams.insert(it.key(), compileEntry(it.value().toMap().value("params").toMap(), api));
+    }
+}
+
+JsonValidator::Result JsonValidator::validateParams(const QVariantMap &params, const QString &method)
 {
-    QVariantMap paramDefinition = api.value("methods").toMap().value(method).toMap().value("params").toMap();
-    m_result = validateMap(params, paramDefinition, api, QIODevice::WriteOnly);
+    m_result = validateMap(params, m_methodParams.value(method, m_emptyMap), QIODevice::WriteOnly);
     m_result.setWhere(method + ", param " + m_result.where());
     return m_result;
 }
 
-JsonValidator::Result JsonValidator::validateReturns(const QVariantMap &returns, const QString &method, const QVariantMap &api)
+JsonValidator::Result JsonValidator::validateReturns(const QVariantMap &returns, const QString &method)
 {
-    QVariantMap returnsDefinition = api.value("methods").toMap().value(method).toMap().value("returns").toMap();
-    m_result = validateMap(returns, returnsDefinition, api, QIODevice::ReadOnly);
+    m_result = validateMap(returns, m_methodReturns.value(method, m_emptyMap), QIODevice::ReadOnly);
     m_result.setWhere(method + ", returns " + m_result.where());
     return m_result;
 }
 
-JsonValidator::Result JsonValidator::validateNotificationParams(const QVariantMap &params, const QString &notification, const QVariantMap &api)
+JsonValidator::Result JsonValidator::validateNotificationParams(const QVariantMap &params, const QString &notification)
 {
-    QVariantMap paramDefinition = api.value("notifications").toMap().value(notification).toMap().value("params").toMap();
-    m_result = validateMap(params, paramDefinition, api, QIODevice::ReadOnly);
+    m_result = validateMap(params, m_notificationParams.value(notification, m_emptyMap), QIODevice::ReadOnly);
     m_result.setWhere(notification + ", param " + m_result.where());
     return m_result;
 }
@@ -127,50 +196,135 @@ JsonValidator::Result JsonValidator::result() const
     return m_result;
 }
 
-JsonValidator::Result JsonValidator::validateMap(const QVariantMap &map, const QVariantMap &definition, const QVariantMap &api, QIODevice::OpenMode openMode)
+JsonValidator::Node *JsonValidator::createNode()
 {
-    // Make sure all required values are available
-    foreach (const QString &key, definition.keys()) {
-        if (hasTaggedPrefix(key, QStringLiteral("o:"))) {
-            continue;
-        }
-        if (hasTaggedPrefix(key, QStringLiteral("r:")) && openMode.testFlag(QIODevice::WriteOnly)) {
-            continue;
+    Node *node = new Node();
+    m_nodes.append(node);
+    return node;
+}
+
+JsonValidator::Node *JsonValidator::compileEntry(const QVariant &definition, const QVariantMap &api)
+{
+    if (definition.userType() == QMetaType::QString && definition.toString().startsWith("$ref:")) {
+        return compileRef(definition.toString().remove("$ref:"), api);
+    }
+    Node *node = createNode();
+    compileInto(node, definition, api);
+    return node;
+}
+
+JsonValidator::Node *JsonValidator::compileRef(const QString &refName, const QVariantMap &api)
+{
+    if (m_refs.contains(refName)) {
+        return m_refs.value(refName);
+    }
+
+    // Register the node before compiling the definition so recursive types resolve to it
+    Node *node = createNode();
+    m_refs.insert(refName, node);
+
+    // Refs might be enums
+    QVariantMap enums = api.value("enums").toMap();
+    if (enums.contains(refName)) {
+        node->kind = Node::KindEnum;
+        node->refName = refName;
+        foreach (const QVariant &enumValue, enums.value(refName).toList()) {
+            node->enumValues.insert(enumValue.toString());
         }
-        const QString trimmedKey = stripTaggedPrefixes(key);
-        if (!map.contains(trimmedKey)) {
-            return Result(false, "Missing required key: " + key, key);
+        return node;
+    }
+
+    // Or flags
+    QVariantMap flags = api.value("flags").toMap();
+    if (flags.contains(refName)) {
+        node->kind = Node::KindFlags;
+        node->refName = refName;
+        node->entry = compileEntry(flags.value(refName).toList().first().toString(), api);
+        return node;
+    }
+
+    compileInto(node, api.value("types").toMap().value(refName), api);
+    return node;
+}
+
+void JsonValidator::compileInto(Node *node, const QVariant &definition, const QVariantMap &api)
+{
+    node->definitionType = definition.userType();
+
+    if (definition.userType() == QMetaType::QString) {
+        QString expectedTypeName = definition.toString();
+        if (expectedTypeName.startsWith("$ref:")) {
+            node->kind = Node::KindRef;
+            node->entry = compileRef(expectedTypeName.remove("$ref:"), api);
+            return;
         }
+        node->kind = Node::KindBasic;
+        node->typeName = expectedTypeName;
+        node->basicType = JsonHandler::enumNameToValue<JsonHandler::BasicType>(expectedTypeName);
+        node->metaType = JsonHandler::basicTypeToMetaType(node->basicType);
+        return;
     }
 
-    // Make sure given values are valid
-    foreach (const QString &key, map.keys()) {
-        // Is the key allowed in here?
-        QVariant expectedValue = definition.value(key);
-        foreach (const QString &definitionKey, definition.keys()) {
-            const QString normalizedDefinitionKey = stripTaggedPrefixes(definitionKey);
-            if (normalizedDefinitionKey == key && definitionKey != key) {
-                expectedValue = definition.value(definitionKey);
-                break;
+    if (definition.userType() == QMetaType::QVariantMap) {
+        node->kind = Node::KindMap;
+        QVariantMap map = definition.toMap();
+        // Keys with tags (e.g. "o:name") take precedence over an untagged key with the same name
+        QHash<QString, const Node *> taggedFields;
+        for (QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it) {
+            const QString &definitionKey = it.key();
+            const QString key = stripTaggedPrefixes(definitionKey);
+            const Node *field = compileEntry(it.value(), api);
+
+            node->fields.insert(definitionKey, field);
+            if (key != definitionKey && !taggedFields.contains(key)) {
+                taggedFields.insert(key, field);
             }
+
+            if (!hasTaggedPrefix(definitionKey, QStringLiteral("o:"))) {
+                Node::RequiredKey requiredKey;
+                requiredKey.definitionKey = definitionKey;
+                requiredKey.key = key;
+                requiredKey.readOnly = hasTaggedPrefix(definitionKey, QStringLiteral("r:"));
+                node->requiredKeys.append(requiredKey);
+            }
+        }
+        for (QHash<QString, const Node *>::const_iterator it = taggedFields.constBegin(); it != taggedFields.constEnd(); ++it) {
+            node->fields.insert(it.key(), it.value());
         }
-        if (!expectedValue.isValid()) {
-            expectedValue = definition.value("o:" + key);
+        return;
+    }
+
+    if (definition.userType() == QMetaType::QVariantList) {
+        node->kind = Node::KindList;
+        node->entry = compileEntry(definition.toList().first(), api);
+        return;
+    }
+}
+
+JsonValidator::Result JsonValidator::validateMap(const QVariantMap &map, const Node *node, QIODevice::OpenMode openMode) const
+{
+    // Make sure all required values are available
+    foreach (const Node::RequiredKey &requiredKey, node->requiredKeys) {
+        if (requiredKey.readOnly && openMode.testFlag(QIODevice::WriteOnly)) {
+            continue;
         }
-        if (!expectedValue.isValid()) {
-            expectedValue = definition.value("d:" + key);
+        if (!map.contains(requiredKey.key)) {
+            return Result(false, "Missing required key: " + requiredKey.definitionKey, requiredKey.definitionKey);
         }
-        if (!expectedValue.isValid()) {
-            return Result(false, "Invalid key: " + key);
+    }
+
+    // Make sure given values are valid
+    for (QVariantMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it) {
+        // Is the key allowed in here?
+        const Node *field = node->fields.value(it.key());
+        if (!field) {
+            return Result(false, "Invalid key: " + it.key());
         }
 
         // Validate content
-        QVariant value = map.value(key);
-
-        Result result = validateEntry(value, expectedValue, api, openMode);
+        Result result = validateEntry(it.value(), field, openMode);
         if (!result.success()) {
-            result.setWhere(key + '.' + result.where());
-            result.setErrorString(result.errorString());
+            result.setWhere(it.key() + '.' + result.where());
             return result;
         }
     }
@@ -178,85 +332,62 @@ JsonValidator::Result JsonValidator::validateMap(const QVariantMap &map, const Q
     return Result(true);
 }
 
-JsonValidator::Result JsonValidator::validateEntry(const QVariant &value, const QVariant &definition, const QVariantMap &api, QIODevice::OpenMode openMode)
+JsonValidator::Result JsonValidator::validateEntry(const QVariant &value, const Node *node, QIODevice::OpenMode openMode) const
 {
-    if (definition.userType() == QMetaType::QString) {
-        QString expectedTypeName = definition.toString();
+    switch (node->kind) {
+    case Node::KindRef:
+        return validateEntry(value, node->entry, openMode);
 
-        if (expectedTypeName.startsWith("$ref:")) {
-            QString refName = expectedTypeName;
-            refName.remove("$ref:");
-
-            // Refs might be enums
-            QVariantMap enums = api.value("enums").toMap();
-            if (enums.contains(refName)) {
-                QVariant refDefinition = enums.value(refName);
-
-                QVariantList enumList = refDefinition.toList();
+    case Node::KindEnum:
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-                if (value.metaType().id() == QMetaType::QStringList) {
-                    foreach (const QString &valueString, value.toStringList()) {
-                        if (!enumList.contains(valueString)) {
-                            return Result(false, "Expected enum value for " + refName + " but got " + value.toString());
-                        }
-                    }
-                } else {
-                    if (!enumList.contains(value.toString())) {
-                        return Result(false, "Expected enum value for " + refName + " but got " + value.toString());
-                    }
+        if (value.metaType().id() == QMetaType::QStringList) {
+            foreach (const QString &valueString, value.toStringList()) {
+                if (!node->enumValues.contains(valueString)) {
+                    return Result(false, "Expected enum value for " + node->refName + " but got " + value.toString());
                 }
+            }
+        } else {
+            if (!node->enumValues.contains(value.toString())) {
+                return Result(false, "Expected enum value for " + node->refName + " but got " + value.toString());
+            }
+        }
 #else
-                if (!enumList.contains(value.toString())) {
-                    return Result(false, "Expected enum value for " + refName + " but got " + value.toString());
-                }
+        if (!node->enumValues.contains(value.toString())) {
+            return Result(false, "Expected enum value for " + node->refName + " but got " + value.toString());
+        }
 #endif
-                return Result(true);
-            }
+        return Result(true);
 
-            // Or flags
-            QVariantMap flags = api.value("flags").toMap();
-            if (flags.contains(refName)) {
-                QVariant refDefinition = flags.value(refName);
-                if (value.userType() != QMetaType::QVariantList && value.userType() != QMetaType::QStringList) {
-                    return Result(false, "Expected flags " + refName + " but got " + value.toString());
-                }
-                QString flagEnum = refDefinition.toList().first().toString();
-                foreach (const QVariant &flagsEntry, value.toList()) {
-                    Result result = validateEntry(flagsEntry, flagEnum, api, openMode);
-                    if (!result.success()) {
-                        return result;
-                    }
-                }
-                return Result(true);
+    case Node::KindFlags:
+        if (value.userType() != QMetaType::QVariantList && value.userType() != QMetaType::QStringList) {
+            return Result(false, "Expected flags " + node->refName + " but got " + value.toString());
+        }
+        foreach (const QVariant &flagsEntry, value.toList()) {
+            Result result = validateEntry(flagsEntry, node->entry, openMode);
+            if (!result.success()) {
+                return result;
             }
-
-            QVariantMap types = api.value("types").toMap();
-            QVariant refDefinition = types.value(refName);
-            return validateEntry(value, refDefinition, api, openMode);
         }
+        return Result(true);
 
-        JsonHandler::BasicType expectedBasicType = JsonHandler::enumNameToValue<JsonHandler::BasicType>(expectedTypeName);
+    case Node::KindBasic: {
+        JsonHandler::BasicType expectedBasicType = node->basicType;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         // Any string converts fine to Uuid, but the resulting uuid might be null
         if (expectedBasicType == JsonHandler::Uuid && value.toUuid().isNull()) {
 
             QString typeName(value.typeName());
-            //qCCritical(dcJsonRpc()) << value << value.userType() << value.typeId() << value.typeName() << value.toString() << value.toUuid() << value.canConvert(QMetaType::QUuid);
 
             // Verify if this is one of our own uuid types
             if (typeName == "ThingId" || typeName == "EventTypeId" || typeName == "StateTypeId" || typeName == "ActionTypeId") {
                 return Result(true);
-            }/* else {
-                return Result(false, "Invalid Uuid: " + value.toString());
-            }*/
+            }
         }
 #else
-        QMetaType::Type expectedVariantType = JsonHandler::basicTypeToMetaType(expectedBasicType);
-
         // Verify basic compatiblity
-        if (expectedBasicType != JsonHandler::Variant && !value.canConvert(expectedVariantType)) {
-            return Result(false, "Invalid value. Expected: " + definition.toString() + ", Got: " + value.toString());
+        if (expectedBasicType != JsonHandler::Variant && !value.canConvert(node->metaType)) {
+            return Result(false, "Invalid value. Expected: " + node->typeName + ", Got: " + value.toString());
         }
 
         // Any string converts fine to Uuid, but the resulting uuid might be null
@@ -304,41 +435,29 @@ JsonValidator::Result JsonValidator::validateEntry(const QVariant &value, const
             }
         }
 
-
         return Result(true);
     }
 
-    if (definition.userType() == QMetaType::QVariantMap) {
+    case Node::KindMap:
         if (value.userType() != QMetaType::QVariantMap) {
             return Result(false, "Invalid value. Expected a map but received: " + value.toString());
         }
-        return validateMap(value.toMap(), definition.toMap(), api, openMode);
-    }
-
-    if (definition.userType() == QMetaType::QVariantList) {
-        QVariantList list = definition.toList();
-        QVariant entryDefinition = list.first();
-
-        if (value.userType() != QMetaType::QVariantList && value.userType() != QMetaType::QStringList) {
+        return validateMap(value.toMap(), node, openMode);
 
-            QString elementType = QString(value.typeName()).remove("QList<").remove(">");
-            if (elementType == "ThingId" || elementType == "EventTypeId" || elementType == "StateTypeId" || elementType == "ActionTypeId") {
-                elementType = "Uuid";
-            } /*else if (elementType == "ParamList") {
-                elementType = "Param";
-            } else {
-                return Result(false, "Expected list of " + entryDefinition.toString() + " but got value of type " + value.typeName() + "\n" + QJsonDocument::fromVariant(value).toJson());
-            }*/
-        }
+    case Node::KindList:
         foreach (const QVariant &entry, value.toList()) {
-            Result result = validateEntry(entry, entryDefinition, api, openMode);
+            Result result = validateEntry(entry, node->entry, openMode);
             if (!result.success()) {
                 return result;
             }
         }
         return Result(true);
+
+    case Node::KindInvalid:
+        break;
     }
-    Q_ASSERT_X(false, "JsonValildator", QString("Incomplete validation. Unexpected type %1 in template").arg(definition.type()).toUtf8());
+
+    Q_ASSERT_X(false, "JsonValildator", QString("Incomplete validation. Unexpected type %1 in template").arg(node->definitionType).toUtf8());
     return Result(false);
 }
 
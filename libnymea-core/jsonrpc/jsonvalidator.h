@@ -28,6 +28,7 @@
 #include <QPair>
 #include <QVariant>
 #include <QIODevice>
+#include <QHash>
 
 namespace nymeaserver {
 
@@ -53,18 +54,39 @@ public:
         bool m_deprecated = false;
     };
 
-    JsonValidator() {}
+    JsonValidator();
+    ~JsonValidator();
 
     static bool checkRefs(const QVariantMap &map, const QVariantMap &api);
 
-    Result validateParams(const QVariantMap &params, const QString &method, const QVariantMap &api);
-    Result validateReturns(const QVariantMap &returns, const QString &method, const QVariantMap &api);
-    Result validateNotificationParams(const QVariantMap &params, const QString &notification, const QVariantMap &api);
+    // Compiles the params and returns definitions of all methods and notifications in the given api which
+    // have not been compiled yet. Referenced types, enums and flags are resolved once and shared.
+    void compile(const QVariantMap &api);
+
+    Result validateParams(const QVariantMap &params, const QString &method);
+    Result validateReturns(const QVariantMap &returns, const QString &method);
+    Result validateNotificationParams(const QVariantMap &params, const QString &notification);
 
     Result result() const;
 private:
-    Result validateMap(const QVariantMap &map, const QVariantMap &definition, const QVariantMap &api, QIODevice::OpenMode openMode);
-    Result validateEntry(const QVariant &value, const QVariant &definition, const QVariantMap &api, QIODevice::OpenMode openMode);
+    struct Node;
+
+    Node *createNode();
+    Node *compileEntry(const QVariant &definition, const QVariantMap &api);
+    Node *compileRef(const QString &refName, const QVariantMap &api);
+    void compileInto(Node *node, const QVariant &definition, const QVariantMap &api);
+
+    Result validateMap(const QVariantMap &map, const Node *node, QIODevice::OpenMode openMode) const;
+    Result validateEntry(const QVariant &value, const Node *node, QIODevice::OpenMode openMode) const;
+
+    Q_DISABLE_COPY(JsonValidator)
+
+    QList<Node *> m_nodes;
+    QHash<QString, Node *> m_refs;
+    QHash<QString, Node *> m_methodParams;
+    QHash<QString, Node *> m_methodReturns;
+    QHash<QString, Node *> m_notificationParams;
+    Node *m_emptyMap = nullptr;
 
     Result m_result;
 };
@@ -28,6 +28,8 @@
 #include "loggingcategories.h"
 #include "nymeacore.h"
 
+#include <QJsonDocument>
+
 namespace nymeaserver {
 
 LoggingHandler::LoggingHandler(LogEngine *logEngine, QObject *parent) :
@@ -52,7 +54,16 @@ LoggingHandler::LoggingHandler(LogEngine *logEngine, QObject *parent) :
                   "\"sampleRate\": If given, returns a sampled series of the values, filling in gaps with the previous value.\n"
                   "\"sortOrder\": Sort order of results. Note that this impacts the filling of gaps when resampling.\n"
                   "\"limit\": Maximum amount of entries to be returned.\n"
-                  "\"offset\": Offset to be skipped before returning entries.";
+                  "\"offset\": Offset to be skipped before returning entries.\n"
+                  "\"cursor\": Enables paging by cursor. Pass an empty string for the first page and the returned "
+                  "\"nextCursor\" for the following pages, together with the same query parameters. Sources are read one "
+                  "after another, a page contains at most \"limit\" (default 1000) entries of a single source. Paging is "
+                  "complete when no \"nextCursor\" is returned. \"offset\" is ignored in this mode.\n"
+                  "\"stream\": If true, the reply only contains a \"streamId\" and the entries are delivered in chunks "
+                  "of at most \"limit\" (default 1000) entries by LogEntriesStreamed notifications to this connection, "
+                  "regardless of the enabled notification namespaces. At most 2 chunks are sent ahead, each chunk needs "
+                  "to be acknowledged with AcknowledgeLogEntries before more are sent. Can be combined with \"cursor\" "
+                  "to resume a stream.";
     params.insert("sources", QVariantList() << enumValueName(String));
     params.insert("o:columns", QVariantList() << enumValueName(String));
     params.insert("o:filter", enumValueName(Variant));
@@ -62,17 +73,35 @@ LoggingHandler::LoggingHandler(LogEngine *logEngine, QObject *parent) :
     params.insert("o:sortOrder", enumRef<Qt::SortOrder>());
     params.insert("o:limit", enumValueName(Int));
     params.insert("o:offset", enumValueName(Int));
+    params.insert("o:cursor", enumValueName(String));
+    params.insert("o:stream", enumValueName(Bool));
     returns.insert("o:logEntries", objectRef<LogEntries>());
     returns.insert("count", enumValueName(Int));
     returns.insert("offset", enumValueName(Int));
+    returns.insert("o:nextCursor", enumValueName(String));
+    returns.insert("o:streamId", enumValueName(Uuid));
     registerMethod("GetLogEntries", description, params, returns, Types::PermissionScopeControlThings);
 
+    params.clear(); returns.clear();
+    description = "Acknowledge a chunk received by a LogEntriesStreamed notification. The stream continues once the "
+                  "chunks sent ahead have been acknowledged. Acknowledging the last chunk of a stream is not required.";
+    params.insert("streamId", enumValueName(Uuid));
+    registerMethod("AcknowledgeLogEntries", description, params, returns, Types::PermissionScopeControlThings);
+
     // Notifications
     params.clear();
     description = "Emitted when a log entry is added. This will only be emitted for discrete series, not for resampled entries";
     params.insert("logEntry", objectRef<LogEntry>());
     registerNotification("LogEntryAdded", description, params);
 
+    params.clear();
+    description = "Emitted to the requesting connection for each chunk of a streamed GetLogEntries call. \"finished\" "
+                  "is true for the last chunk of the stream.";
+    params.insert("streamId", enumValueName(Uuid));
+    params.insert("logEntries", objectRef<LogEntries>());
+    params.insert("finished", enumValueName(Bool));
+    registerNotification("LogEntriesStreamed", description, params);
+
     connect(m_logEngine, &LogEngine::logEntryAdded, this, [this](const LogEntry &logEntry){
         emit LogEntryAdded({{"logEntry", packLogEntry(logEntry)}});
     });
@@ -83,51 +112,91 @@ QString LoggingHandler::name() const
     return "Logging";
 }
 
-JsonReply* LoggingHandler::GetLogEntries(const QVariantMap &params) const
+JsonReply* LoggingHandler::GetLogEntries(const QVariantMap &params, const JsonContext &context)
 {
-    JsonReply *reply = createAsyncReply("GetLogEntries");
-
-    QVariantMap filter = params.value("filter").toMap();
-    QDateTime startTime;
+    LogQuery query;
+    query.sources = params.value("sources").toStringList();
+    query.filter = params.value("filter").toMap();
     if (params.contains("startTime")) {
-        startTime = QDateTime::fromMSecsSinceEpoch(params.value("startTime").toULongLong());
+        query.startTime = QDateTime::fromMSecsSinceEpoch(params.value("startTime").toULongLong());
     }
-    QDateTime endTime;
     if (params.contains("endTime")) {
-        endTime = QDateTime::fromMSecsSinceEpoch(params.value("endTime").toULongLong());
+        query.endTime = QDateTime::fromMSecsSinceEpoch(params.value("endTime").toULongLong());
     }
-    Types::SampleRate sampleRate = Types::SampleRateAny;
     if (params.contains("sampleRate")) {
         QMetaEnum sampleRateEnum = QMetaEnum::fromType<Types::SampleRate>();
-        sampleRate = static_cast<Types::SampleRate>(sampleRateEnum.keyToValue(params.value("sampleRate").toByteArray()));
+        query.sampleRate = static_cast<Types::SampleRate>(sampleRateEnum.keyToValue(params.value("sampleRate").toByteArray()));
     }
-    QStringList columns;
     if (params.contains("columns")) {
-        columns = params.value("columns").toStringList();
+        query.columns = params.value("columns").toStringList();
+    }
+    if (params.contains("sortOrder")) {
+        query.sortOrder = enumNameToValue<Qt::SortOrder>(params.value("sortOrder").toString());
     }
+    query.limit = params.value("limit").toInt();
 
-    int offset = params.value("offset").toInt();
-    int limit = params.value("limit").toInt();
+    if (params.contains("cursor") || params.value("stream").toBool()) {
+        if (query.limit <= 0) {
+            query.limit = 1000;
+        }
 
-    Qt::SortOrder sortOrder = Qt::AscendingOrder;
-    if (params.contains("sortOrder")) {
-        sortOrder = enumNameToValue<Qt::SortOrder>(params.value("sortOrder").toString());
+        LogCursor cursor;
+        if (!decodeCursor(query, params.value("cursor").toString(), &cursor)) {
+            return createErrorReply("Invalid cursor");
+        }
+
+        if (params.value("stream").toBool()) {
+            QUuid streamId = QUuid::createUuid();
+            if (query.sources.isEmpty()) {
+                // Nothing to fetch, still deliver the final chunk as promised
+                QMetaObject::invokeMethod(this, "LogEntriesStreamed", Qt::QueuedConnection, Q_ARG(QUuid, context.clientId()),
+                                          Q_ARG(QVariantMap, QVariantMap({{"streamId", streamId}, {"logEntries", QVariantList()}, {"finished", true}})));
+            } else {
+                LogStream stream;
+                stream.query = query;
+                stream.cursor = cursor;
+                stream.clientId = context.clientId();
+                m_streams.insert(streamId, stream);
+                streamPage(streamId);
+            }
+            return createReply({{"count", 0}, {"offset", 0}, {"streamId", streamId}});
+        }
+
+        if (query.sources.isEmpty()) {
+            return createReply({{"count", 0}, {"offset", 0}, {"logEntries", QVariantList()}});
+        }
+
+        JsonReply *reply = createAsyncReply("GetLogEntries");
+        LogFetchJob *job = fetchPage(query, cursor);
+        connect(job, &LogFetchJob::finished, reply, [reply, query, cursor](const LogEntries &entries){
+            QVariantList entryMaps;
+            foreach (const LogEntry &logEntry, entries) {
+                entryMaps.append(packLogEntry(logEntry));
+            }
+            QVariantMap params {
+                {"count", entries.count()},
+                {"offset", 0},
+                {"logEntries", entryMaps}
+            };
+            LogCursor nextCursor = cursor;
+            if (advanceCursor(query, entries, &nextCursor)) {
+                params.insert("nextCursor", encodeCursor(query, nextCursor));
+            }
+            reply->setData(params);
+            reply->finished();
+        });
+        return reply;
     }
 
-    QStringList sources = params.value("sources").toStringList();
-    LogFetchJob *job = m_logEngine->fetchLogEntries(sources, columns, startTime, endTime, filter, sampleRate, sortOrder, offset, limit);
+    JsonReply *reply = createAsyncReply("GetLogEntries");
+
+    int offset = params.value("offset").toInt();
+    LogFetchJob *job = m_logEngine->fetchLogEntries(query.sources, query.columns, query.startTime, query.endTime, query.filter, query.sampleRate, query.sortOrder, offset, query.limit);
+    connect(job, &LogFetchJob::finished, job, &LogFetchJob::deleteLater);
     connect(job, &LogFetchJob::finished, reply, [reply](const LogEntries &entries){
         QVariantList entryMaps;
         foreach (const LogEntry &logEntry, entries) {
-            QVariantMap logEntryMap;
-            logEntryMap.insert("timestamp", logEntry.timestamp().toMSecsSinceEpoch());
-            logEntryMap.insert("source", logEntry.source());
-            QVariantMap values;
-            foreach (const QString &valueKey, logEntry.values().keys()) {
-                values.insert(valueKey, logEntry.values().value(valueKey));
-            }
-            logEntryMap.insert("values", values);
-            entryMaps.append(logEntryMap);
+            entryMaps.append(packLogEntry(logEntry));
         }
         QVariantMap params {
             {"count", entries.count()},
@@ -141,6 +210,28 @@ JsonReply* LoggingHandler::GetLogEntries(const QVariantMap &params) const
     return reply;
 }
 
+JsonReply *LoggingHandler::AcknowledgeLogEntries(const QVariantMap &params, const JsonContext &context)
+{
+    QUuid streamId = params.value("streamId").toUuid();
+    // Finished streams are gone already, acknowledging their last chunks is fine
+    if (m_streams.contains(streamId) && m_streams.value(streamId).clientId == context.clientId()) {
+        LogStream &stream = m_streams[streamId];
+        stream.unacknowledgedChunks = qMax(0, stream.unacknowledgedChunks - 1);
+        streamPage(streamId);
+    }
+    return createReply(QVariantMap());
+}
+
+void LoggingHandler::onClientDisconnected(const QUuid &clientId)
+{
+    foreach (const QUuid &streamId, m_streams.keys()) {
+        if (m_streams.value(streamId).clientId == clientId) {
+            qCDebug(dcJsonRpc()) << "Client" << clientId << "disconnected. Stopping log entry stream" << streamId;
+            m_streams.remove(streamId);
+        }
+    }
+}
+
 QVariantMap LoggingHandler::packLogEntry(const LogEntry &logEntry)
 {
     QVariantMap logEntryMap;
@@ -154,4 +245,121 @@ QVariantMap LoggingHandler::packLogEntry(const LogEntry &logEntry)
     return logEntryMap;
 }
 
+QString LoggingHandler::encodeCursor(const LogQuery &query, const LogCursor &cursor)
+{
+    QVariantMap map;
+    map.insert("source", query.sources.at(cursor.sourceIndex));
+    map.insert("timestamp", cursor.timestamp);
+    map.insert("skip", cursor.skip);
+    return QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact).toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
+
+bool LoggingHandler::decodeCursor(const LogQuery &query, const QString &cursorString, LogCursor *cursor)
+{
+    *cursor = LogCursor();
+    if (cursorString.isEmpty()) {
+        return true;
+    }
+
+    QByteArray data = QByteArray::fromBase64(cursorString.toUtf8(), QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+    QVariantMap map = QJsonDocument::fromJson(data).toVariant().toMap();
+    int sourceIndex = query.sources.indexOf(map.value("source").toString());
+    if (sourceIndex < 0 || !map.contains("timestamp") || !map.contains("skip")) {
+        qCWarning(dcJsonRpc()) << "Invalid log cursor" << cursorString;
+        return false;
+    }
+    cursor->sourceIndex = sourceIndex;
+    cursor->timestamp = map.value("timestamp").toLongLong();
+    cursor->skip = map.value("skip").toInt();
+    return true;
+}
+
+LogFetchJob *LoggingHandler::fetchPage(const LogQuery &query, const LogCursor &cursor)
+{
+    // Resume by timestamp. The skip only covers entries sharing the exact timestamp of the last delivered entry.
+    QDateTime startTime = query.startTime;
+    QDateTime endTime = query.endTime;
+    if (cursor.timestamp >= 0) {
+        if (query.sortOrder == Qt::AscendingOrder) {
+            startTime = QDateTime::fromMSecsSinceEpoch(cursor.timestamp);
+        } else {
+            endTime = QDateTime::fromMSecsSinceEpoch(cursor.timestamp);
+        }
+    }
+
+    QStringList sources = {query.sources.at(cursor.sourceIndex)};
+    LogFetchJob *job = m_logEngine->fetchLogEntries(sources, query.columns, startTime, endTime, query.filter, query.sampleRate, query.sortOrder, cursor.skip, query.limit);
+    // The engine parents jobs to itself, clean them up once a page has been handled
+    connect(job, &LogFetchJob::finished, job, &LogFetchJob::deleteLater);
+    return job;
+}
+
+bool LoggingHandler::advanceCursor(const LogQuery &query, const LogEntries &entries, LogCursor *cursor)
+{
+    if (entries.count() < query.limit) {
+        // This source is exhausted, continue with the next one
+        cursor->sourceIndex++;
+        cursor->timestamp = -1;
+        cursor->skip = 0;
+        return cursor->sourceIndex < query.sources.count();
+    }
+
+    foreach (const LogEntry &entry, entries) {
+        qint64 timestamp = entry.timestamp().toMSecsSinceEpoch();
+        if (timestamp == cursor->timestamp) {
+            cursor->skip++;
+        } else {
+            cursor->timestamp = timestamp;
+            cursor->skip = 1;
+        }
+    }
+    return true;
+}
+
+void LoggingHandler::streamPage(const QUuid &streamId)
+{
+    if (!m_streams.contains(streamId)) {
+        return;
+    }
+
+    LogStream &stream = m_streams[streamId];
+    // Only fetch the next chunk once the client keeps up with the ones sent already
+    if (stream.fetching || stream.unacknowledgedChunks >= m_streamWindow) {
+        return;
+    }
+
+    stream.fetching = true;
+    LogFetchJob *job = fetchPage(stream.query, stream.cursor);
+    connect(job, &LogFetchJob::finished, this, [this, streamId](const LogEntries &entries){
+        if (!m_streams.contains(streamId)) {
+            // The client went away in the meantime
+            return;
+        }
+
+        LogStream &stream = m_streams[streamId];
+        stream.fetching = false;
+
+        QVariantList entryMaps;
+        foreach (const LogEntry &logEntry, entries) {
+            entryMaps.append(packLogEntry(logEntry));
+        }
+
+        bool more = advanceCursor(stream.query, entries, &stream.cursor);
+        QUuid clientId = stream.clientId;
+        if (more) {
+            stream.unacknowledgedChunks++;
+        } else {
+            m_streams.remove(streamId);
+        }
+
+        QVariantMap params;
+        params.insert("streamId", streamId);
+        params.insert("logEntries", entryMaps);
+        params.insert("finished", !more);
+        emit LogEntriesStreamed(clientId, params);
+
+        streamPage(streamId);
+    });
+}
+
 }
@@ -29,6 +29,7 @@
 #include "logging/logentry.h"
 
 class LogEngine;
+class LogFetchJob;
 
 namespace nymeaserver {
 
@@ -39,16 +40,60 @@ public:
     explicit LoggingHandler(LogEngine *logEngine, QObject *parent = nullptr);
     QString name() const override;
 
-    Q_INVOKABLE JsonReply *GetLogEntries(const QVariantMap &params) const;
+    Q_INVOKABLE JsonReply *GetLogEntries(const QVariantMap &params, const JsonContext &context);
+    Q_INVOKABLE JsonReply *AcknowledgeLogEntries(const QVariantMap &params, const JsonContext &context);
+
+public slots:
+    void onClientDisconnected(const QUuid &clientId);
 
 signals:
     void LogEntryAdded(const QVariantMap &params);
+    void LogEntriesStreamed(const QUuid &clientId, const QVariantMap &params);
 
 private:
-    QVariantMap packLogEntry(const LogEntry &logEntry);
+    struct LogQuery {
+        QStringList sources;
+        QStringList columns;
+        QDateTime startTime;
+        QDateTime endTime;
+        QVariantMap filter;
+        Types::SampleRate sampleRate = Types::SampleRateAny;
+        Qt::SortOrder sortOrder = Qt::AscendingOrder;
+        int limit = 0;
+    };
+
+    // Position within a LogQuery. Sources are read one after another, within a source
+    // the position is the timestamp of the last delivered entry and the number of
+    // entries delivered with exactly that timestamp.
+    struct LogCursor {
+        int sourceIndex = 0;
+        qint64 timestamp = -1;
+        int skip = 0;
+    };
+
+    struct LogStream {
+        LogQuery query;
+        LogCursor cursor;
+        QUuid clientId;
+        int unacknowledgedChunks = 0;
+        bool fetching = false;
+    };
+
+    static QVariantMap packLogEntry(const LogEntry &logEntry);
+
+    static QString encodeCursor(const LogQuery &query, const LogCursor &cursor);
+    static bool decodeCursor(const LogQuery &query, const QString &cursorString, LogCursor *cursor);
+
+    LogFetchJob *fetchPage(const LogQuery &query, const LogCursor &cursor);
+    static bool advanceCursor(const LogQuery &query, const LogEntries &entries, LogCursor *cursor);
+    void streamPage(const QUuid &streamId);
 
 private:
     LogEngine *m_logEngine = nullptr;
+
+    // Number of streamed chunks sent ahead of the client's acknowledgements
+    int m_streamWindow = 2;
+    QHash<QUuid, LogStream> m_streams;
 };
 
 }
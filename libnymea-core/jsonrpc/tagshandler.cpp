@@ -97,8 +97,17 @@ QString TagsHandler::name() const
 
 JsonReply *TagsHandler::GetTags(const QVariantMap &params) const
 {
+    QList<Tag> tags;
+    if (params.contains("thingId")) {
+        tags = NymeaCore::instance()->tagsStorage()->tags(ThingId(params.value("thingId").toUuid()));
+    } else if (params.contains("ruleId")) {
+        tags = NymeaCore::instance()->tagsStorage()->tags(RuleId(params.value("ruleId").toUuid()));
+    } else {
+        tags = NymeaCore::instance()->tagsStorage()->tags();
+    }
+
     QVariantList ret;
-    foreach (const Tag &tag, NymeaCore::instance()->tagsStorage()->tags()) {
+    foreach (const Tag &tag, tags) {
         if (params.contains("thingId") && params.value("thingId").toUuid() != tag.thingId()) {
             continue;
         }
@@ -5,7 +5,7 @@ include(../nymea.pri)
 
 QT += core bluetooth dbus qml sql websockets serialport
 INCLUDEPATH += $$top_srcdir/libnymea $$top_builddir
-LIBS += -L$$top_builddir/libnymea/ -lnymea -lssl -lcrypto
+LIBS += -L$$top_builddir/libnymea/ -lnymea -lssl -lcrypto -lz
 
 CONFIG += link_pkgconfig
 PKGCONFIG += nymea-mqtt nymea-networkmanager nymea-zigbee nymea-remoteproxyclient nymea-gpio
@@ -61,6 +61,7 @@ RESOURCES += $$top_srcdir/icons.qrc \
 
 HEADERS += nymeacore.h \
     backupmanager.h \
+    appdata/appdatastorage.h \
     hardware/bluetoothlowenergy/bluetoothpairingjobimplementation.h \
     hardware/bluetoothlowenergy/nymeabluetoothagent.h \
     hardware/network/macaddressdatabasereplyimpl.h \
@@ -74,6 +75,7 @@ HEADERS += nymeacore.h \
     zwave/zwavemanagerreply.h \
     zwave/zwavenodeimplementation.h \
     integrations/apikeysprovidersloader.h \
+    integrations/plugincallstatistics.h \
     integrations/plugininfocache.h \
     integrations/python/pyapikeystorage.h \
     integrations/python/pybrowseractioninfo.h \
@@ -91,11 +93,13 @@ HEADERS += nymeacore.h \
     ruleengine/ruleengine.h \
     ruleengine/rule.h \
     ruleengine/stateevaluator.h \
+    ruleengine/boundstateevaluator.h \
     ruleengine/ruleaction.h \
     ruleengine/ruleactionparam.h \
     scriptengine/script.h \
     scriptengine/scriptaction.h \
     scriptengine/scriptalarm.h \
+    scriptengine/scriptalarmscheduler.h \
     scriptengine/scriptengine.h \
     scriptengine/scriptevent.h \
     scriptengine/scriptinterfaceaction.h \
@@ -114,6 +118,7 @@ HEADERS += nymeacore.h \
     servers/mqttbroker.h \
     servers/tunnelproxyserver.h \
     jsonrpc/jsonrpcserverimplementation.h \
+    jsonrpc/jsonrpcstreamreader.h \
     jsonrpc/jsonvalidator.h \
     jsonrpc/integrationshandler.h \
     jsonrpc/ruleshandler.h \
@@ -158,11 +163,13 @@ HEADERS += nymeacore.h \
     hardware/network/mqtt/mqttproviderimplementation.h \
     hardware/network/mqtt/mqttchannelimplementation.h \
     hardware/i2c/i2cmanagerimplementation.h \
+    hardware/i2c/i2cbusworker.h \
     hardware/zigbee/zigbeehardwareresourceimplementation.h \
     debugserverhandler.h \
     tagging/tagsstorage.h \
     tagging/tag.h \
     debugreportgenerator.h \
+    tararchivewriter.h \
     platform/platform.h \
     zigbee/zigbeeadapter.h \
     zigbee/zigbeeadapters.h \
@@ -174,6 +181,7 @@ HEADERS += nymeacore.h \
 
 SOURCES += nymeacore.cpp \
     backupmanager.cpp \
+    appdata/appdatastorage.cpp \
     hardware/bluetoothlowenergy/bluetoothpairingjobimplementation.cpp \
     hardware/bluetoothlowenergy/nymeabluetoothagent.cpp \
     hardware/network/macaddressdatabasereplyimpl.cpp \
@@ -187,6 +195,7 @@ SOURCES += nymeacore.cpp \
     zwave/zwavemanagerreply.cpp \
     zwave/zwavenodeimplementation.cpp \
     integrations/apikeysprovidersloader.cpp \
+    integrations/plugincallstatistics.cpp \
     integrations/plugininfocache.cpp \
     integrations/thingmanagerimplementation.cpp \
     integrations/translator.cpp \
@@ -197,11 +206,13 @@ SOURCES += nymeacore.cpp \
     ruleengine/ruleengine.cpp \
     ruleengine/rule.cpp \
     ruleengine/stateevaluator.cpp \
+    ruleengine/boundstateevaluator.cpp \
     ruleengine/ruleaction.cpp \
     ruleengine/ruleactionparam.cpp \
     scriptengine/script.cpp \
     scriptengine/scriptaction.cpp \
     scriptengine/scriptalarm.cpp \
+    scriptengine/scriptalarmscheduler.cpp \
     scriptengine/scriptengine.cpp \
     scriptengine/scriptevent.cpp \
     scriptengine/scriptinterfaceaction.cpp \
@@ -220,6 +231,7 @@ SOURCES += nymeacore.cpp \
     servers/mqttbroker.cpp \
     servers/tunnelproxyserver.cpp \
     jsonrpc/jsonrpcserverimplementation.cpp \
+    jsonrpc/jsonrpcstreamreader.cpp \
     jsonrpc/jsonvalidator.cpp \
     jsonrpc/integrationshandler.cpp \
     jsonrpc/ruleshandler.cpp \
@@ -264,11 +276,13 @@ SOURCES += nymeacore.cpp \
     hardware/network/mqtt/mqttproviderimplementation.cpp \
     hardware/network/mqtt/mqttchannelimplementation.cpp \
     hardware/i2c/i2cmanagerimplementation.cpp \
+    hardware/i2c/i2cbusworker.cpp \
     hardware/zigbee/zigbeehardwareresourceimplementation.cpp \
     debugserverhandler.cpp \
     tagging/tagsstorage.cpp \
     tagging/tag.cpp \
     debugreportgenerator.cpp \
+    tararchivewriter.cpp \
     platform/platform.cpp \
     zigbee/zigbeeadapter.cpp \
     zigbee/zigbeeadapters.cpp \
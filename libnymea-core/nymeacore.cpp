@@ -44,6 +44,7 @@
 #include "integrations/thing.h"
 #include "integrations/thingactioninfo.h"
 #include "integrations/thingmanagerimplementation.h"
+#include "integrations/plugincallstatistics.h"
 
 #include "zigbee/zigbeemanager.h"
 
@@ -177,6 +178,9 @@ void NymeaCore::init(const QStringList &additionalInterfaces, bool disableLogEng
     qCDebug(dcCore()) << "Create Modbus RTU Manager";
     m_modbusRtuManager = new ModbusRtuManager(m_serialPortMonitor, this);
 
+    // Hardware resources register plugin timers already, create this before them
+    m_pluginCallStatistics = new PluginCallStatistics(this);
+
     qCDebug(dcCore) << "Creating Hardware Manager";
     m_hardwareManager = new HardwareManagerImplementation(m_platform, m_configuration, m_serverManager->mqttBroker(), m_zigbeeManager, m_zwaveManager, m_modbusRtuManager, this);
 
@@ -191,7 +195,7 @@ void NymeaCore::init(const QStringList &additionalInterfaces, bool disableLogEng
     m_logger = m_logEngine->registerLogSource("core", {"event"});
 
     qCDebug(dcCore) << "Creating Thing Manager (locale:" << m_configuration->locale() << ")";
-    m_thingManager = new ThingManagerImplementation(m_hardwareManager, m_logEngine, m_configuration->locale(), this);
+    m_thingManager = new ThingManagerImplementation(m_hardwareManager, m_logEngine, m_pluginCallStatistics, m_configuration->locale(), this);
 
     qCDebug(dcCore) << "Creating Rule Engine";
     m_ruleEngine = new RuleEngine(m_thingManager, m_timeManager, m_logEngine, this);
@@ -308,6 +312,9 @@ void NymeaCore::destroy(ShutdownReason reason)
     }
 
     s_instance = nullptr;
+
+    // Settings are written to disk lazily, make sure everything is stored before touching the files
+    NymeaSettings::syncAll();
     performPendingRestartAction();
 }
 
@@ -338,6 +345,11 @@ ThingManager *NymeaCore::thingManager() const
     return m_thingManager;
 }
 
+PluginCallStatistics *NymeaCore::pluginCallStatistics() const
+{
+    return m_pluginCallStatistics;
+}
+
 RuleEngine *NymeaCore::ruleEngine() const
 {
     return m_ruleEngine;
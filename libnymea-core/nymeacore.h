@@ -43,6 +43,7 @@
 class Thing;
 class LogEngine;
 class Logger;
+class PluginCallStatistics;
 
 class NetworkManager;
 
@@ -99,6 +100,7 @@ public:
     LogEngine *logEngine() const;
     JsonRPCServerImplementation *jsonRPCServer() const;
     ThingManager *thingManager() const;
+    PluginCallStatistics *pluginCallStatistics() const;
     RuleEngine *ruleEngine() const;
     ScriptEngine *scriptEngine() const;
     TimeManager *timeManager() const;
@@ -143,6 +145,7 @@ private:
     BackupManager *m_backupManager = nullptr;
     ServerManager *m_serverManager = nullptr;
     ThingManagerImplementation *m_thingManager = nullptr;
+    PluginCallStatistics *m_pluginCallStatistics = nullptr;
     RuleEngine *m_ruleEngine = nullptr;
     ScriptEngine *m_scriptEngine = nullptr;
     LogEngine *m_logEngine = nullptr;
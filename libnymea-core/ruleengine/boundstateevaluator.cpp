@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "boundstateevaluator.h"
+#include "integrations/thingmanager.h"
+#include "integrations/thing.h"
+#include "loggingcategories.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+#include <QColor>
+#endif
+
+namespace nymeaserver {
+
+BoundStateEvaluator BoundStateEvaluator::bind(const StateEvaluator &stateEvaluator, ThingManager *thingManager)
+{
+    BoundStateEvaluator ret;
+    if (!stateEvaluator.isEmpty()) {
+        ret.bindNode(stateEvaluator, thingManager);
+    }
+    return ret;
+}
+
+bool BoundStateEvaluator::evaluate() const
+{
+    // Same as evaluating an empty StateEvaluator
+    if (m_nodes.isEmpty()) {
+        return true;
+    }
+    return evaluateNode(0);
+}
+
+bool BoundStateEvaluator::containsState(const ThingId &thingId, const StateTypeId &stateTypeId) const
+{
+    foreach (const Node &node, m_nodes) {
+        if (!node.hasDescriptor) {
+            continue;
+        }
+        if (node.interfaceBased) {
+            // Any state change of a thing implementing the interface is of interest
+            for (int i = node.firstComparison; i < node.firstComparison + node.comparisonCount; i++) {
+                if (m_comparisons.at(i).state.thingId == thingId) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        if (node.thingId == thingId && node.stateTypeId == stateTypeId) {
+            return true;
+        }
+        if (node.valueThingId == thingId && node.valueStateTypeId == stateTypeId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BoundStateEvaluator::isEmpty() const
+{
+    return m_nodes.isEmpty();
+}
+
+int BoundStateEvaluator::bindNode(const StateEvaluator &stateEvaluator, ThingManager *thingManager)
+{
+    int index = m_nodes.count();
+    m_nodes.append(Node());
+
+    Node node;
+    node.operatorType = stateEvaluator.operatorType();
+    node.hasDescriptor = stateEvaluator.stateDescriptor().isValid();
+    node.firstComparison = m_comparisons.count();
+    if (node.hasDescriptor) {
+        StateDescriptor descriptor = stateEvaluator.stateDescriptor();
+        node.interfaceBased = descriptor.type() == StateDescriptor::TypeInterface;
+        node.thingId = descriptor.thingId();
+        node.stateTypeId = descriptor.stateTypeId();
+        node.valueThingId = descriptor.valueThingId();
+        node.valueStateTypeId = descriptor.valueStateTypeId();
+        bindDescriptor(descriptor, thingManager);
+    }
+    node.comparisonCount = m_comparisons.count() - node.firstComparison;
+
+    // Children append their own subtrees, so collect them first to keep the child list contiguous
+    QVector<int> children;
+    foreach (const StateEvaluator &childEvaluator, stateEvaluator.childEvaluators()) {
+        children.append(bindNode(childEvaluator, thingManager));
+    }
+    node.firstChild = m_children.count();
+    node.childCount = children.count();
+    m_children.append(children);
+
+    m_nodes[index] = node;
+    return index;
+}
+
+void BoundStateEvaluator::bindDescriptor(const StateDescriptor &descriptor, ThingManager *thingManager)
+{
+    if (descriptor.type() == StateDescriptor::TypeThing) {
+        Thing *thing = thingManager->findConfiguredThing(descriptor.thingId());
+        if (!thing) {
+            qCWarning(dcRuleEngine()) << "Thing listed in state descriptor not found in system.";
+            return;
+        }
+        bindComparison(thing, descriptor.stateTypeId(), descriptor, thingManager);
+        return;
+    }
+
+    // Interface based: matches if any of the things implementing the interface matches
+    foreach (Thing *thing, thingManager->findConfiguredThings(descriptor.interface())) {
+        StateType stateType = thing->thingClass().stateTypes().findByName(descriptor.interfaceState());
+        if (stateType.id().isNull()) {
+            continue;
+        }
+        bindComparison(thing, stateType.id(), descriptor, thingManager);
+    }
+}
+
+void BoundStateEvaluator::bindComparison(Thing *thing, const StateTypeId &stateTypeId, const StateDescriptor &descriptor, ThingManager *thingManager)
+{
+    Comparison comparison;
+    comparison.operatorType = descriptor.operatorType();
+    if (!bindSlot(thing, stateTypeId, &comparison.state)) {
+        qCWarning(dcRuleEngine()) << "State" << stateTypeId << "not found in thing" << thing->name() << thing->id().toString();
+        return;
+    }
+
+    if (!descriptor.stateValue().isNull()) {
+        StateType stateType = thing->thingClass().stateTypes().findById(stateTypeId);
+        comparison.value = descriptor.stateValue();
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+        if (!comparison.value.convert(QMetaType(stateType.type()))) {
+            return;
+        }
+        // Equivalent QColor variants don't compare as equivalent, compare the color names instead
+        if (stateType.type() == QMetaType::QColor) {
+            comparison.compareColorNames = true;
+            comparison.value = comparison.value.value<QColor>().name();
+        }
+#else
+        if (!comparison.value.convert(stateType.type())) {
+            return;
+        }
+#endif
+    } else if (!descriptor.valueThingId().isNull() && !descriptor.valueStateTypeId().isNull()) {
+        Thing *valueThing = thingManager->findConfiguredThing(descriptor.valueThingId());
+        if (!valueThing) {
+            qCWarning(dcRuleEngine()) << "Thing" << descriptor.valueThingId().toString() << "defined in statedescriptor value but not found in system.";
+            return;
+        }
+        if (!bindSlot(valueThing, descriptor.valueStateTypeId(), &comparison.valueState)) {
+            qCWarning(dcRuleEngine()) << "State" << descriptor.valueStateTypeId().toString() << "defined in statedescriptor value not found in thing" << valueThing->name() << valueThing->id().toString();
+            return;
+        }
+    } else {
+        return;
+    }
+
+    m_comparisons.append(comparison);
+}
+
+bool BoundStateEvaluator::bindSlot(Thing *thing, const StateTypeId &stateTypeId, StateSlot *slot)
+{
+    const States states = thing->states();
+    for (int i = 0; i < states.count(); i++) {
+        if (states.at(i).stateTypeId() == stateTypeId) {
+            slot->thing = thing;
+            slot->thingId = thing->id();
+            slot->stateTypeId = stateTypeId;
+            slot->index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BoundStateEvaluator::evaluateNode(int index) const
+{
+    const Node &node = m_nodes.at(index);
+
+    bool descriptorMatching = true;
+    if (node.hasDescriptor) {
+        descriptorMatching = false;
+        for (int i = node.firstComparison; i < node.firstComparison + node.comparisonCount; i++) {
+            if (evaluateComparison(m_comparisons.at(i))) {
+                descriptorMatching = true;
+                break;
+            }
+        }
+    }
+
+    if (node.operatorType == Types::StateOperatorOr) {
+        if (node.hasDescriptor && descriptorMatching) {
+            return true;
+        }
+        for (int i = node.firstChild; i < node.firstChild + node.childCount; i++) {
+            if (evaluateNode(m_children.at(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (!descriptorMatching) {
+        return false;
+    }
+    for (int i = node.firstChild; i < node.firstChild + node.childCount; i++) {
+        if (!evaluateNode(m_children.at(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BoundStateEvaluator::evaluateComparison(const Comparison &comparison) const
+{
+    QVariant stateValue;
+    if (!readState(comparison.state, &stateValue)) {
+        return false;
+    }
+
+    if (comparison.valueState.thingId.isNull()) {
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+        if (comparison.compareColorNames) {
+            stateValue = stateValue.value<QColor>().name();
+        }
+#endif
+        bool result = compare(stateValue, comparison.value, comparison.operatorType);
+        qCDebug(dcRuleEngineDebug()) << "Comparing" << stateValue << "to" << comparison.value << "with operator" << comparison.operatorType << "-->" << result;
+        return result;
+    }
+
+    QVariant valueStateValue;
+    if (!readState(comparison.valueState, &valueStateValue)) {
+        return false;
+    }
+    bool result = compare(stateValue, valueStateValue, comparison.operatorType);
+    qCDebug(dcRuleEngineDebug()) << "Comparing" << stateValue << "to" << valueStateValue << "with operator" << comparison.operatorType << "-->" << result;
+    return result;
+}
+
+bool BoundStateEvaluator::readState(const StateSlot &slot, QVariant *value)
+{
+    if (slot.thing.isNull()) {
+        return false;
+    }
+
+    const States states = slot.thing->states();
+    if (slot.index < states.count() && states.at(slot.index).stateTypeId() == slot.stateTypeId) {
+        *value = states.at(slot.index).value();
+        return true;
+    }
+
+    // The states of the thing have been replaced since binding
+    State state = slot.thing->state(slot.stateTypeId);
+    if (state.stateTypeId().isNull()) {
+        return false;
+    }
+    *value = state.value();
+    return true;
+}
+
+bool BoundStateEvaluator::compare(const QVariant &left, const QVariant &right, Types::ValueOperator operatorType)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+    QPartialOrdering ordering = QVariant::compare(left, right);
+    switch (operatorType) {
+    case Types::ValueOperatorEquals:
+        return ordering == QPartialOrdering::Equivalent;
+    case Types::ValueOperatorGreater:
+        return ordering == QPartialOrdering::Greater;
+    case Types::ValueOperatorGreaterOrEqual:
+        return ordering == QPartialOrdering::Greater || ordering == QPartialOrdering::Equivalent;
+    case Types::ValueOperatorLess:
+        return ordering == QPartialOrdering::Less;
+    case Types::ValueOperatorLessOrEqual:
+        return ordering == QPartialOrdering::Less || ordering == QPartialOrdering::Equivalent;
+    case Types::ValueOperatorNotEquals:
+        return ordering != QPartialOrdering::Equivalent;
+    }
+#else
+    switch (operatorType) {
+    case Types::ValueOperatorEquals:
+        return left == right;
+    case Types::ValueOperatorGreater:
+        return left > right;
+    case Types::ValueOperatorGreaterOrEqual:
+        return left >= right;
+    case Types::ValueOperatorLess:
+        return left < right;
+    case Types::ValueOperatorLessOrEqual:
+        return left <= right;
+    case Types::ValueOperatorNotEquals:
+        return left != right;
+    }
+#endif
+    return false;
+}
+
+}
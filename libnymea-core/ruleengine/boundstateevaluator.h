@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef BOUNDSTATEEVALUATOR_H
+#define BOUNDSTATEEVALUATOR_H
+
+#include "stateevaluator.h"
+
+#include <QPointer>
+#include <QVector>
+
+class Thing;
+class ThingManager;
+
+namespace nymeaserver {
+
+// A StateEvaluator resolved against the currently configured things. Thing pointers, state
+// positions and comparison operands are looked up once when binding, so evaluating the
+// condition tree does not search things or convert values any more. Needs to be bound again
+// whenever things are added or removed.
+class BoundStateEvaluator
+{
+public:
+    BoundStateEvaluator() = default;
+
+    static BoundStateEvaluator bind(const StateEvaluator &stateEvaluator, ThingManager *thingManager);
+
+    bool evaluate() const;
+    bool containsState(const ThingId &thingId, const StateTypeId &stateTypeId) const;
+
+    bool isEmpty() const;
+
+private:
+    struct StateSlot {
+        QPointer<Thing> thing;
+        ThingId thingId;
+        StateTypeId stateTypeId;
+        int index = -1;
+    };
+
+    struct Comparison {
+        StateSlot state;
+        StateSlot valueState; // Only used when not comparing to a static value
+        QVariant value;
+        Types::ValueOperator operatorType = Types::ValueOperatorEquals;
+        bool compareColorNames = false;
+    };
+
+    struct Node {
+        Types::StateOperator operatorType = Types::StateOperatorAnd;
+        bool hasDescriptor = false;
+        bool interfaceBased = false;
+        // Kept even if the descriptor could not be bound, to know which state changes affect this node
+        ThingId thingId;
+        StateTypeId stateTypeId;
+        ThingId valueThingId;
+        StateTypeId valueStateTypeId;
+        int firstComparison = 0;
+        int comparisonCount = 0;
+        int firstChild = 0;
+        int childCount = 0;
+    };
+
+    int bindNode(const StateEvaluator &stateEvaluator, ThingManager *thingManager);
+    void bindDescriptor(const StateDescriptor &descriptor, ThingManager *thingManager);
+    void bindComparison(Thing *thing, const StateTypeId &stateTypeId, const StateDescriptor &descriptor, ThingManager *thingManager);
+    static bool bindSlot(Thing *thing, const StateTypeId &stateTypeId, StateSlot *slot);
+
+    bool evaluateNode(int index) const;
+    bool evaluateComparison(const Comparison &comparison) const;
+    static bool readState(const StateSlot &slot, QVariant *value);
+    static bool compare(const QVariant &left, const QVariant &right, Types::ValueOperator operatorType);
+
+    QVector<Node> m_nodes;
+    QVector<int> m_children;
+    QVector<Comparison> m_comparisons;
+};
+
+}
+
+#endif // BOUNDSTATEEVALUATOR_H
@@ -152,6 +152,7 @@ RuleEngine::RuleEngine(ThingManager *thingManager, TimeManager *timeManager, Log
     });
 
     connect(m_thingManager, &ThingManager::thingRemoved, this, &RuleEngine::onThingRemoved);
+    connect(m_thingManager, &ThingManager::thingAdded, this, &RuleEngine::bindStateEvaluators);
 
     connect(m_timeManager, &TimeManager::dateTimeChanged, this, &RuleEngine::onDateTimeChanged);
 
@@ -171,6 +172,9 @@ RuleEngine::~RuleEngine()
     and evaluate their states in the system. It will return a
     list of all \l{Rule}{Rules} that are triggered or change its active state
     because of this \a event.
+
+    This does not execute any actions, which happens when the \l{ThingManager}
+    delivers the event. It is public to measure the rule matching in the benchmarks.
 */
 QList<Rule> RuleEngine::evaluateEvent(const Event &event)
 {
@@ -206,8 +210,9 @@ QList<Rule> RuleEngine::evaluateEvent(const Event &event)
         }
 
         // If we have a state based on this event
-        if (containsState(rule.stateEvaluator(), event)) {
-            rule.setStatesActive(rule.stateEvaluator().evaluate());
+        const BoundStateEvaluator &stateEvaluator = m_boundStateEvaluators[rule.id()];
+        if (stateEvaluator.containsState(event.thingId(), StateTypeId(event.eventTypeId()))) {
+            rule.setStatesActive(stateEvaluator.evaluate());
             m_rules[rule.id()] = rule;
         }
 
@@ -535,6 +540,7 @@ RuleEngine::RuleError RuleEngine::removeRule(const RuleId &ruleId, bool fromEdit
     m_ruleIds.takeAt(index);
     Rule rule = m_rules.take(ruleId);
     m_activeRules.removeAll(ruleId);
+    m_boundStateEvaluators.remove(ruleId);
 
     NymeaSettings settings(NymeaSettings::SettingsRoleRules);
     settings.beginGroup(ruleId.toString());
@@ -836,6 +842,7 @@ void RuleEngine::removeThingFromRule(const RuleId &id, const ThingId &thingId)
         // The rule doesn't have any actions any more and is useless at this point... let's remove it altogether
         qCDebug(dcRuleEngine()) << "Rule" << rule.name() << "(" + rule.id().toString() + ")" << "does not have any actions any more. Removing it.";
         m_rules.take(id);
+        m_boundStateEvaluators.remove(id);
         emit ruleRemoved(id);
         return;
     }
@@ -849,6 +856,7 @@ void RuleEngine::removeThingFromRule(const RuleId &id, const ThingId &thingId)
     newRule.setActions(actions);
     newRule.setExitActions(exitActions);
     m_rules[id] = newRule;
+    bindStateEvaluator(newRule);
 
     // save it
     saveRule(newRule);
@@ -996,32 +1004,17 @@ bool RuleEngine::containsEvent(const Rule &rule, const Event &event, const Thing
     return false;
 }
 
-bool RuleEngine::containsState(const StateEvaluator &stateEvaluator, const Event &stateChangeEvent)
+void RuleEngine::bindStateEvaluator(const Rule &rule)
 {
-    if (stateEvaluator.stateDescriptor().isValid()) {
-        if (stateEvaluator.stateDescriptor().type() == StateDescriptor::TypeThing) {
-            if (stateEvaluator.stateDescriptor().thingId() == stateChangeEvent.thingId() && stateEvaluator.stateDescriptor().stateTypeId() == stateChangeEvent.eventTypeId()) {
-                return true;
-            }
-            if (stateEvaluator.stateDescriptor().valueThingId() == stateChangeEvent.thingId() && stateEvaluator.stateDescriptor().valueStateTypeId() == stateChangeEvent.eventTypeId()) {
-                return true;
-            }
-        } else {
-            Thing *thing = m_thingManager->findConfiguredThing(stateChangeEvent.thingId());
-            ThingClass thingClass = m_thingManager->findThingClass(thing->thingClassId());
-            if (thingClass.interfaces().contains(stateEvaluator.stateDescriptor().interface())) {
-                return true;
-            }
-        }
-    }
+    m_boundStateEvaluators.insert(rule.id(), BoundStateEvaluator::bind(rule.stateEvaluator(), m_thingManager));
+}
 
-    foreach (const StateEvaluator &childEvaluator, stateEvaluator.childEvaluators()) {
-        if (containsState(childEvaluator, stateChangeEvent)) {
-            return true;
-        }
+void RuleEngine::bindStateEvaluators()
+{
+    // Bound evaluators hold pointers to things and things matching interfaces, resolve them again
+    foreach (const Rule &rule, m_rules) {
+        bindStateEvaluator(rule);
     }
-
-    return false;
 }
 
 RuleEngine::RuleError RuleEngine::checkRuleAction(const RuleAction &ruleAction, const Rule &rule)
@@ -1219,7 +1212,8 @@ QMetaType::Type RuleEngine::getEventParamType(const EventTypeId &eventTypeId, co
 void RuleEngine::appendRule(const Rule &rule)
 {
     Rule newRule = rule;
-    newRule.setStatesActive(newRule.stateEvaluator().evaluate());
+    bindStateEvaluator(newRule);
+    newRule.setStatesActive(m_boundStateEvaluators.value(rule.id()).evaluate());
     newRule.setTimeActive(newRule.timeDescriptor().evaluate(QDateTime(), QDateTime::currentDateTime()));
     qCDebug(dcRuleEngine()) << "Adding Rule:" << newRule;
     m_rules.insert(rule.id(), newRule);
@@ -1697,6 +1691,8 @@ void RuleEngine::onThingRemoved(const ThingId &thingId)
     while (!affectedRules.isEmpty()) {
         removeRule(affectedRules.takeFirst());
     }
+
+    bindStateEvaluators();
 }
 
 void RuleEngine::init()
@@ -1888,7 +1884,6 @@ void RuleEngine::init()
         rule.setExitActions(exitActions);
         rule.setEnabled(enabled);
         rule.setExecutable(executable);
-        rule.setStatesActive(rule.stateEvaluator().evaluate());
         appendRule(rule);
         settings.endGroup();
     }
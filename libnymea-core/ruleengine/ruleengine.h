@@ -27,6 +27,7 @@
 
 #include "rule.h"
 #include "stateevaluator.h"
+#include "boundstateevaluator.h"
 #include "types/event.h"
 
 #include "integrations/thingmanager.h"
@@ -99,6 +100,8 @@ public:
 
     void removeThingFromRule(const RuleId &id, const ThingId &thingId);
 
+    QList<Rule> evaluateEvent(const Event &event);
+
 signals:
     void ruleAdded(const Rule &rule);
     void ruleRemoved(const RuleId &ruleId);
@@ -112,11 +115,11 @@ private slots:
     void onThingRemoved(const ThingId &thingId);
 
 private:    
-    QList<Rule> evaluateEvent(const Event &event);
     QList<Rule> evaluateTime(const QDateTime &dateTime);
 
     bool containsEvent(const Rule &rule, const Event &event, const ThingClassId &thingClassId);
-    bool containsState(const StateEvaluator &stateEvaluator, const Event &stateChangeEvent);
+    void bindStateEvaluator(const Rule &rule);
+    void bindStateEvaluators();
 
     RuleError checkRuleAction(const RuleAction &ruleAction, const Rule &rule);
     RuleError checkRuleActionParam(const RuleActionParam &ruleActionParam, const ActionType &actionType, const Rule &rule);
@@ -140,6 +143,7 @@ private:
     QList<RuleId> m_ruleIds; // Keeping a list of RuleIds to keep sorting order...
     QHash<RuleId, Rule> m_rules; // ...but use a Hash for faster finding
     QList<RuleId> m_activeRules;
+    QHash<RuleId, BoundStateEvaluator> m_boundStateEvaluators;
 
     QDateTime m_lastEvaluationTime;
 
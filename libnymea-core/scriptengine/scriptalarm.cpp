@@ -23,8 +23,8 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "scriptalarm.h"
+#include "scriptalarmscheduler.h"
 
-#include <QTimer>
 #include <QLoggingCategory>
 Q_DECLARE_LOGGING_CATEGORY(dcScriptEngine)
 
@@ -35,6 +35,14 @@ ScriptAlarm::ScriptAlarm(QObject *parent) : QObject(parent)
 {
 }
 
+ScriptAlarm::~ScriptAlarm()
+{
+    ScriptAlarmScheduler *scheduler = ScriptAlarmScheduler::instance();
+    if (scheduler) {
+        scheduler->unschedule(this);
+    }
+}
+
 QTime ScriptAlarm::time() const
 {
     return m_time;
@@ -50,13 +58,7 @@ void ScriptAlarm::setTime(const QTime &time)
             qCWarning(dcScriptEngine()) << "Invalid time:" << time;
         }
 
-        if (time.isValid() && m_timerId == 0) {
-            m_timerId = startTimer(1000, Qt::VeryCoarseTimer);
-        } else if (!time.isValid() && m_timerId != 0) {
-            killTimer(m_timerId);
-        }
-
-        updateActive();
+        reschedule();
     }
 }
 
@@ -71,7 +73,7 @@ void ScriptAlarm::setEndTime(const QTime &endTime)
         m_endTime = endTime;
         emit endTimeChanged();
 
-        updateActive();
+        reschedule();
     }
 }
 
@@ -86,7 +88,7 @@ void ScriptAlarm::setWeekDays(const WeekDays &weekDays)
         m_weekDays = weekDays;
         emit weekDaysChanged();
 
-        updateActive();
+        reschedule();
     }
 }
 
@@ -95,53 +97,87 @@ bool ScriptAlarm::active() const
     return m_active;
 }
 
-void ScriptAlarm::timerEvent(QTimerEvent *event)
+QDateTime ScriptAlarm::evaluate(const QDateTime &now)
 {
-    Q_UNUSED(event)
-
-    QTime now = QTime::currentTime();
-
-
-    updateActive();
-
-    if (!m_weekDays.testFlag(today())) {
-        return;
-    }
-    if (!m_weekDays.testFlag(today())) {
-        return;
-    }
-    if (m_time.hour() != now.hour()) {
-        return;
+    // If the clock jumped past the trigger time, don't fire belatedly
+    bool trigger = m_nextTrigger.isValid() && m_nextTrigger <= now && m_nextTrigger.msecsTo(now) < 60000;
+    m_nextTrigger = QDateTime();
+
+    // Script handlers may modify this alarm while we're emitting. Any changes are
+    // picked up below, the scheduler takes the returned deadline.
+    m_evaluating = true;
+    updateActive(now);
+    if (trigger) {
+        emit triggered();
     }
-    if (m_time.minute() != now.minute()) {
-        return;
+    m_evaluating = false;
+
+    QDateTime deadline;
+    if (m_time.isValid()) {
+        m_nextTrigger = nextOccurrence(now, m_time, true);
+        deadline = m_nextTrigger;
     }
-    if (m_time.second() != now.second()) {
-        return;
+    if (m_endTime.isValid()) {
+        // The active state changes at the start time, right after the end time and whenever the day changes
+        QList<QDateTime> boundaries = {
+            nextOccurrence(now, m_time, false),
+            nextOccurrence(now, m_endTime.addSecs(1), false),
+            QDateTime(now.date().addDays(1), QTime(0, 0))
+        };
+        foreach (const QDateTime &boundary, boundaries) {
+            if (boundary.isValid() && (!deadline.isValid() || boundary < deadline)) {
+                deadline = boundary;
+            }
+        }
     }
+    return deadline;
+}
 
-    emit triggered();
+ScriptAlarm::WeekDay ScriptAlarm::weekDay(const QDate &date)
+{
+    return static_cast<WeekDay>(1 << (date.dayOfWeek() - 1));
 }
 
-ScriptAlarm::WeekDay ScriptAlarm::today() const
+QDateTime ScriptAlarm::nextOccurrence(const QDateTime &now, const QTime &time, bool honourWeekDays) const
 {
-    QList<WeekDay> allDays = {Monday, Tuesday, Wednesday, Thursday, Friday, Saturday, Sunday};
-    return allDays.at(QDateTime::currentDateTime().date().dayOfWeek() - 1);
+    if (!time.isValid()) {
+        return QDateTime();
+    }
+    for (int i = 0; i <= 7; i++) {
+        QDate date = now.date().addDays(i);
+        if (honourWeekDays && !m_weekDays.testFlag(weekDay(date))) {
+            continue;
+        }
+        QDateTime candidate(date, time);
+        if (candidate > now) {
+            return candidate;
+        }
+    }
+    return QDateTime();
 }
 
-void ScriptAlarm::updateActive()
+void ScriptAlarm::reschedule()
 {
-    QTime now = QTime::currentTime();
+    m_nextTrigger = QDateTime();
+    ScriptAlarmScheduler *scheduler = ScriptAlarmScheduler::instance();
+    if (m_evaluating || !scheduler) {
+        return;
+    }
+    scheduler->schedule(this);
+}
 
-    bool active = m_endTime.isValid() && m_weekDays.testFlag(today());
+void ScriptAlarm::updateActive(const QDateTime &now)
+{
+    bool active = m_endTime.isValid() && m_weekDays.testFlag(weekDay(now.date()));
 
     if (active) {
-        bool beforeStart = now < m_time;
-        bool afterEnd = now > m_endTime;
+        bool beforeStart = now.time() < m_time;
+        bool afterEnd = now.time() > m_endTime;
         if (m_time < m_endTime) {
             active = !beforeStart && !afterEnd;
         } else {
-            active = beforeStart || afterEnd;
+            // Spans midnight, active from the start time until the end of the day and from the start of the day until the end time
+            active = !beforeStart || !afterEnd;
         }
     }
     if (active != m_active) {
@@ -27,7 +27,7 @@
 
 #include <QObject>
 #include <QDateTime>
-#include <QTimer>
+
 namespace nymeaserver {
 namespace scriptengine {
 
@@ -56,6 +56,7 @@ public:
     Q_FLAG(WeekDays)
 
     explicit ScriptAlarm(QObject *parent = nullptr);
+    ~ScriptAlarm() override;
 
     QTime time() const;
     void setTime(const QTime &time);
@@ -68,6 +69,10 @@ public:
 
     bool active() const;
 
+    // Updates the active state, emits triggered() if due and returns the time this alarm
+    // needs to be evaluated again. Called by the ScriptAlarmScheduler.
+    QDateTime evaluate(const QDateTime &now);
+
 signals:
     void timeChanged();
     void endTimeChanged();
@@ -76,13 +81,12 @@ signals:
     void triggered();
     void activeChanged();
 
-protected:
-    void timerEvent(QTimerEvent *event) override;
-
 private:
-    WeekDay today() const;
+    static WeekDay weekDay(const QDate &date);
+    QDateTime nextOccurrence(const QDateTime &now, const QTime &time, bool honourWeekDays) const;
 
-    void updateActive();
+    void reschedule();
+    void updateActive(const QDateTime &now);
 
 private:
     QTime m_time;
@@ -90,7 +94,8 @@ private:
     WeekDays m_weekDays = AllDays;
 
     bool m_active = false;
-    int m_timerId = 0;
+    QDateTime m_nextTrigger;
+    bool m_evaluating = false;
 };
 
 }
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "scriptalarmscheduler.h"
+#include "scriptalarm.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+Q_DECLARE_LOGGING_CATEGORY(dcScriptEngine)
+
+namespace nymeaserver {
+namespace scriptengine {
+
+// Upper bound for sleeping between two evaluations. Wall clock and time zone changes
+// can't be observed while sleeping, so they are detected at the latest after this time.
+static const qint64 maximumSleepTime = 60 * 1000;
+// A deviation between the wall clock and the monotonic clock larger than this is a clock change
+static const qint64 clockChangeThreshold = 2000;
+
+ScriptAlarmScheduler *ScriptAlarmScheduler::instance()
+{
+    // Lives as long as the application. Returns nullptr once the application is shutting down.
+    static ScriptAlarmScheduler *scheduler = nullptr;
+    static bool destroyed = false;
+    if (!scheduler && !destroyed && QCoreApplication::instance()) {
+        scheduler = new ScriptAlarmScheduler(QCoreApplication::instance());
+        connect(scheduler, &QObject::destroyed, [](){
+            scheduler = nullptr;
+            destroyed = true;
+        });
+    }
+    return scheduler;
+}
+
+ScriptAlarmScheduler::ScriptAlarmScheduler(QObject *parent) : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ScriptAlarmScheduler::evaluate);
+
+    m_lastWallClock = QDateTime::currentDateTime();
+    m_lastUtcOffset = m_lastWallClock.offsetFromUtc();
+    m_monotonicClock.start();
+}
+
+void ScriptAlarmScheduler::schedule(ScriptAlarm *alarm)
+{
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime deadline = alarm->evaluate(now);
+    if (deadline.isValid()) {
+        m_deadlines.insert(alarm, deadline);
+    } else {
+        m_deadlines.remove(alarm);
+    }
+    restartTimer(now);
+}
+
+void ScriptAlarmScheduler::unschedule(ScriptAlarm *alarm)
+{
+    m_deadlines.remove(alarm);
+    restartTimer(QDateTime::currentDateTime());
+}
+
+void ScriptAlarmScheduler::evaluate()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    bool reevaluateAll = clockChanged(now);
+    if (reevaluateAll) {
+        qCDebug(dcScriptEngine()) << "System clock or time zone changed. Rescheduling" << m_deadlines.count() << "alarms.";
+    }
+
+    // Alarms may emit signals which end up in scripts modifying or destroying alarms, work on a copy
+    foreach (ScriptAlarm *alarm, m_deadlines.keys()) {
+        if (!m_deadlines.contains(alarm)) {
+            continue;
+        }
+        if (!reevaluateAll && m_deadlines.value(alarm) > now) {
+            continue;
+        }
+        QDateTime deadline = alarm->evaluate(now);
+        if (!m_deadlines.contains(alarm)) {
+            continue;
+        }
+        if (deadline.isValid()) {
+            m_deadlines.insert(alarm, deadline);
+        } else {
+            m_deadlines.remove(alarm);
+        }
+    }
+
+    restartTimer(now);
+}
+
+void ScriptAlarmScheduler::restartTimer(const QDateTime &now)
+{
+    if (m_deadlines.isEmpty()) {
+        m_timer->stop();
+        return;
+    }
+
+    qint64 interval = maximumSleepTime;
+    foreach (const QDateTime &deadline, m_deadlines) {
+        interval = qMin(interval, now.msecsTo(deadline));
+    }
+    m_timer->start(static_cast<int>(qMax<qint64>(0, interval)));
+}
+
+bool ScriptAlarmScheduler::clockChanged(const QDateTime &now)
+{
+    qint64 wallClockElapsed = m_lastWallClock.msecsTo(now);
+    qint64 monotonicElapsed = m_monotonicClock.restart();
+    bool changed = qAbs(wallClockElapsed - monotonicElapsed) > clockChangeThreshold || now.offsetFromUtc() != m_lastUtcOffset;
+
+    m_lastWallClock = now;
+    m_lastUtcOffset = now.offsetFromUtc();
+    return changed;
+}
+
+}
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SCRIPTALARMSCHEDULER_H
+#define SCRIPTALARMSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+namespace nymeaserver {
+namespace scriptengine {
+
+class ScriptAlarm;
+
+class ScriptAlarmScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static ScriptAlarmScheduler *instance();
+
+    void schedule(ScriptAlarm *alarm);
+    void unschedule(ScriptAlarm *alarm);
+
+private:
+    explicit ScriptAlarmScheduler(QObject *parent = nullptr);
+
+    void evaluate();
+    void restartTimer(const QDateTime &now);
+    bool clockChanged(const QDateTime &now);
+
+private:
+    QTimer *m_timer = nullptr;
+    QHash<ScriptAlarm *, QDateTime> m_deadlines;
+
+    QElapsedTimer m_monotonicClock;
+    QDateTime m_lastWallClock;
+    int m_lastUtcOffset = 0;
+};
+
+}
+}
+
+#endif // SCRIPTALARMSCHEDULER_H
@@ -102,6 +102,17 @@ void BluetoothServer::sendData(const QList<QUuid> &clients, const QByteArray &da
         sendData(client, data);
 }
 
+/*! Send the binary message \a data to the client with the given \a clientId.*/
+void BluetoothServer::sendBinaryData(const QUuid &clientId, const QByteArray &data)
+{
+    QBluetoothSocket *client = m_clientList.value(clientId);
+    if (!client)
+        return;
+
+    qCDebug(dcBluetoothServerTraffic()) << "Send binary data:" << data.size() << "bytes";
+    client->write(lengthPrefixed(data));
+}
+
 void BluetoothServer::terminateClientConnection(const QUuid &clientId)
 {
     QBluetoothSocket *client = m_clientList.value(clientId);
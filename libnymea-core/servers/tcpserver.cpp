@@ -128,6 +128,18 @@ void TcpServer::sendData(const QUuid &clientId, const QByteArray &data)
     }
 }
 
+/*! Sending the binary message \a data to the client with the given \a clientId.*/
+void TcpServer::sendBinaryData(const QUuid &clientId, const QByteArray &data)
+{
+    QTcpSocket *client = m_clientList.value(clientId);
+    if (client) {
+        qCDebug(dcTcpServerTraffic()) << "Sending binary data to client" << clientId.toString() << data.size() << "bytes";
+        client->write(lengthPrefixed(data));
+    } else {
+        qCWarning(dcTcpServer()) << "Client" << clientId.toString() << "unknown to this transport";
+    }
+}
+
 void TcpServer::onClientConnected(QSslSocket *socket)
 {
     QUuid clientId = QUuid::createUuid();
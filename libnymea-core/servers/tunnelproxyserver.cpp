@@ -78,6 +78,17 @@ void TunnelProxyServer::sendData(const QList<QUuid> &clients, const QByteArray &
     }
 }
 
+void TunnelProxyServer::sendBinaryData(const QUuid &clientId, const QByteArray &data)
+{
+    TunnelProxySocket *tunnelProxySocket = m_clients.value(clientId);
+    if (!tunnelProxySocket) {
+        qCWarning(dcTunnelProxyServer()) << "Failed to send data to client" << clientId.toString() << "because there is no tunnel socket for this client UUID.";
+        return;
+    }
+
+    tunnelProxySocket->writeData(lengthPrefixed(data));
+}
+
 void TunnelProxyServer::terminateClientConnection(const QUuid &clientId)
 {
     TunnelProxySocket *tunnelProxySocket = m_clients.value(clientId);
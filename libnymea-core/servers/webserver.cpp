@@ -158,6 +158,42 @@ void WebServer::sendHttpReply(HttpReply *reply)
     qCDebug(dcWebServerTraffic()) << "Send reply to" << socket->peerAddress().toString() << reply;
     qCDebug(dcWebServer()) << "Respond" << socket->peerAddress().toString() << reply->httpStatusCode() << reply->httpReasonPhrase();
     socket->write(reply->data());
+
+    if (!reply->payloadFile().isEmpty()) {
+        streamFile(socket, reply->payloadFile());
+    }
+}
+
+void WebServer::streamFile(QSslSocket *socket, const QString &fileName)
+{
+    // The file is owned by the socket, so it goes away with the connection
+    QFile *file = new QFile(fileName, socket);
+    if (!file->open(QIODevice::ReadOnly)) {
+        qCWarning(dcWebServer()) << "Could not open payload file" << fileName << file->errorString();
+        delete file;
+        // The header announcing the content length has been sent already. Close the connection so the client notices.
+        socket->close();
+        return;
+    }
+
+    qCDebug(dcWebServer()) << "Streaming file" << fileName << file->size() << "B to" << socket->peerAddress().toString();
+
+    // Only keep a limited amount of data in the socket buffer and refill it as it is written out
+    auto writeChunks = [socket, file](){
+        while (socket->bytesToWrite() < 256 * 1024 && !file->atEnd()) {
+            QByteArray chunk = file->read(64 * 1024);
+            if (chunk.isEmpty()) {
+                break;
+            }
+            socket->write(chunk);
+        }
+        if (file->atEnd()) {
+            qCDebug(dcWebServer()) << "Finished streaming file" << file->fileName();
+            file->deleteLater();
+        }
+    };
+    connect(socket, &QSslSocket::bytesWritten, file, writeChunks);
+    writeChunks();
 }
 
 QList<WebServerResource *> WebServer::resources() const
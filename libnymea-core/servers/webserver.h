@@ -108,6 +108,8 @@ private:
     QByteArray createServerXmlDocument(QHostAddress address);
     HttpReply *processIconRequest(const QString &fileName);
 
+    void streamFile(QSslSocket *socket, const QString &fileName);
+
 protected:
     void incomingConnection(qintptr socketDescriptor) override;
 
@@ -111,6 +111,21 @@ void WebSocketServer::sendData(const QList<QUuid> &clients, const QByteArray &da
     }
 }
 
+/*! Send the binary message \a data to the client with the given \a clientId as binary frame.
+ *
+ * \sa TransportInterface::sendBinaryData()
+ */
+void WebSocketServer::sendBinaryData(const QUuid &clientId, const QByteArray &data)
+{
+    QWebSocket *client = m_clientList.value(clientId);
+    if (client) {
+        qCDebug(dcWebSocketServerTraffic()) << "Sending binary data to client" << data.size() << "bytes";
+        client->sendBinaryMessage(data);
+    } else {
+        qCWarning(dcWebSocketServer()) << "Client" << clientId << "unknown to this transport";
+    }
+}
+
 void WebSocketServer::terminateClientConnection(const QUuid &clientId)
 {
     QWebSocket *client = m_clientList.value(clientId);
@@ -173,6 +188,7 @@ void WebSocketServer::onBinaryMessageReceived(const QByteArray &data)
     QWebSocket *client = qobject_cast<QWebSocket *>(sender());
     QUuid clientId = m_clientList.key(client);
     qCDebug(dcWebSocketServerTraffic()) << "Binary message from" << clientId.toString() << ":" << data;
+    emit dataAvailable(clientId, lengthPrefixed(data));
 }
 
 void WebSocketServer::onTextMessageReceived(const QString &message)
@@ -37,6 +37,12 @@ TagsStorage::TagsStorage(ThingManager *thingManager, RuleEngine *ruleEngine, QOb
     connect(thingManager, &ThingManager::thingRemoved, this, &TagsStorage::thingRemoved);
     connect(ruleEngine, &RuleEngine::ruleRemoved, this, &TagsStorage::ruleRemoved);
 
+    // Coalesce settings writes, bulk operations would rewrite the whole file for each tag otherwise
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setInterval(1000);
+    m_writeTimer->setSingleShot(true);
+    connect(m_writeTimer, &QTimer::timeout, this, &TagsStorage::writeTags);
+
     NymeaSettings settings(NymeaSettings::SettingsRoleTags);
 
     if (settings.childGroups().contains("Things")) {
@@ -51,7 +57,7 @@ TagsStorage::TagsStorage(ThingManager *thingManager, RuleEngine *ruleEngine, QOb
             settings.beginGroup(appId);
             foreach (const QString &tagId, settings.childKeys()) {
                 Tag tag(ThingId(thingId), appId, tagId, settings.value(tagId).toString());
-                m_tags.append(tag);
+                m_thingTags[tag.thingId()].insert(TagKey(appId, tagId), tag);
             }
             settings.endGroup();
         }
@@ -62,9 +68,10 @@ TagsStorage::TagsStorage(ThingManager *thingManager, RuleEngine *ruleEngine, QOb
     // Migration path from nymea <= 0.19
     if (settings.childGroups().contains("Devices")) {
         // Save all Devices tags to things tags and drop Devices group
-        foreach (const Tag &tag, m_tags) {
+        foreach (const Tag &tag, tags()) {
             saveTag(tag);
         }
+        writeTags();
         settings.remove("Devices");
     }
 
@@ -75,7 +82,7 @@ TagsStorage::TagsStorage(ThingManager *thingManager, RuleEngine *ruleEngine, QOb
             settings.beginGroup(appId);
             foreach (const QString &tagId, settings.childKeys()) {
                 Tag tag(RuleId(ruleId), appId, tagId, settings.value(tagId).toString());
-                m_tags.append(tag);
+                m_ruleTags[tag.ruleId()].insert(TagKey(appId, tagId), tag);
             }
             settings.endGroup();
         }
@@ -84,31 +91,31 @@ TagsStorage::TagsStorage(ThingManager *thingManager, RuleEngine *ruleEngine, QOb
     settings.endGroup();
 }
 
-QList<Tag> TagsStorage::tags() const
+TagsStorage::~TagsStorage()
 {
-    return m_tags;
+    writeTags();
 }
 
-QList<Tag> TagsStorage::tags(const ThingId &thingId) const
+QList<Tag> TagsStorage::tags() const
 {
     QList<Tag> ret;
-    foreach (const Tag &tag, m_tags) {
-        if (tag.thingId() == thingId) {
-            ret.append(tag);
-        }
+    foreach (const auto &thingTags, m_thingTags) {
+        ret.append(thingTags.values());
+    }
+    foreach (const auto &ruleTags, m_ruleTags) {
+        ret.append(ruleTags.values());
     }
     return ret;
 }
 
+QList<Tag> TagsStorage::tags(const ThingId &thingId) const
+{
+    return m_thingTags.value(thingId).values();
+}
+
 QList<Tag> TagsStorage::tags(const RuleId &ruleId) const
 {
-    QList<Tag> ret;
-    foreach (const Tag &tag, m_tags) {
-        if (tag.ruleId() == ruleId) {
-            ret.append(tag);
-        }
-    }
-    return ret;
+    return m_ruleTags.value(ruleId).values();
 }
 
 TagsStorage::TagError TagsStorage::addTag(const Tag &tag)
@@ -123,12 +130,13 @@ TagsStorage::TagError TagsStorage::addTag(const Tag &tag)
        }
     }
 
-    int index = m_tags.indexOf(tag);
-    if (index >= 0) {
-        m_tags.replace(index, tag);
+    QHash<TagKey, Tag> &ownerTags = !tag.thingId().isNull() ? m_thingTags[tag.thingId()] : m_ruleTags[tag.ruleId()];
+    TagKey key(tag.appId(), tag.tagId());
+    bool existing = ownerTags.contains(key);
+    ownerTags.insert(key, tag);
+    if (existing) {
         emit tagValueChanged(tag);
     } else {
-        m_tags.append(tag);
         emit tagAdded(tag);
     }
     saveTag(tag);
@@ -137,10 +145,26 @@ TagsStorage::TagError TagsStorage::addTag(const Tag &tag)
 
 TagsStorage::TagError TagsStorage::removeTag(const Tag &tag)
 {
-    if (!m_tags.contains(tag)) {
-        return TagErrorTagNotFound;
+    TagKey key(tag.appId(), tag.tagId());
+    if (!tag.thingId().isNull()) {
+        if (!m_thingTags.value(tag.thingId()).contains(key)) {
+            return TagErrorTagNotFound;
+        }
+        QHash<TagKey, Tag> &thingTags = m_thingTags[tag.thingId()];
+        thingTags.remove(key);
+        if (thingTags.isEmpty()) {
+            m_thingTags.remove(tag.thingId());
+        }
+    } else {
+        if (!m_ruleTags.value(tag.ruleId()).contains(key)) {
+            return TagErrorTagNotFound;
+        }
+        QHash<TagKey, Tag> &ruleTags = m_ruleTags[tag.ruleId()];
+        ruleTags.remove(key);
+        if (ruleTags.isEmpty()) {
+            m_ruleTags.remove(tag.ruleId());
+        }
     }
-    m_tags.removeAll(tag);
     unsaveTag(tag);
     emit tagRemoved(tag);
     return TagErrorNoError;
@@ -149,58 +173,80 @@ TagsStorage::TagError TagsStorage::removeTag(const Tag &tag)
 
 void TagsStorage::thingRemoved(const ThingId &thingId)
 {
-    QList<Tag> tagsToRemove;
-    foreach (const Tag &tag, m_tags) {
-        if (tag.thingId() == thingId) {
-            tagsToRemove.append(tag);
-        }
+    QHash<TagKey, Tag> tagsToRemove = m_thingTags.take(thingId);
+    if (tagsToRemove.isEmpty()) {
+        return;
     }
-    while (!tagsToRemove.isEmpty()) {
-        removeTag(tagsToRemove.takeFirst());
+    unsaveGroup("Things/" + thingId.toString());
+    foreach (const Tag &tag, tagsToRemove) {
+        emit tagRemoved(tag);
     }
 }
 
 void TagsStorage::ruleRemoved(const RuleId &ruleId)
 {
-    QList<Tag> tagsToRemove;
-    foreach (const Tag &tag, m_tags) {
-        if (tag.ruleId() == ruleId) {
-            tagsToRemove.append(tag);
-        }
+    QHash<TagKey, Tag> tagsToRemove = m_ruleTags.take(ruleId);
+    if (tagsToRemove.isEmpty()) {
+        return;
     }
-    while (!tagsToRemove.isEmpty()) {
-        removeTag(tagsToRemove.takeFirst());
+    unsaveGroup("Rules/" + ruleId.toString());
+    foreach (const Tag &tag, tagsToRemove) {
+        emit tagRemoved(tag);
     }
 }
 
 void TagsStorage::saveTag(const Tag &tag)
 {
-    NymeaSettings settings(NymeaSettings::SettingsRoleTags);
-
-    if (!tag.thingId().isNull()) {
-        settings.beginGroup("Things");
-        settings.beginGroup(tag.thingId().toString());
-    } else {
-        settings.beginGroup("Rules");
-        settings.beginGroup(tag.ruleId().toString());
+    QString group = !tag.thingId().isNull() ? "Things/" + tag.thingId().toString() : "Rules/" + tag.ruleId().toString();
+    m_pendingWrites.insert(group + "/" + tag.appId() + "/" + tag.tagId(), tag.value());
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start();
     }
-    settings.beginGroup(tag.appId());
-    settings.setValue(tag.tagId(), tag.value());
 }
 
 void TagsStorage::unsaveTag(const Tag &tag)
 {
-    NymeaSettings settings(NymeaSettings::SettingsRoleTags);
+    QString group = !tag.thingId().isNull() ? "Things/" + tag.thingId().toString() : "Rules/" + tag.ruleId().toString();
+    m_pendingWrites.insert(group + "/" + tag.appId() + "/" + tag.tagId(), QVariant());
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start();
+    }
+}
 
-    if (!tag.thingId().isNull()) {
-        settings.beginGroup("Things");
-        settings.beginGroup(tag.thingId().toString());
-    } else {
-        settings.beginGroup("Rules");
-        settings.beginGroup(tag.thingId().toString());
+void TagsStorage::unsaveGroup(const QString &group)
+{
+    // Pending writes within the group are superseded by removing it
+    foreach (const QString &key, m_pendingWrites.keys()) {
+        if (key.startsWith(group + "/")) {
+            m_pendingWrites.remove(key);
+        }
+    }
+    m_pendingWrites.insert(group, QVariant());
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start();
+    }
+}
+
+void TagsStorage::writeTags()
+{
+    m_writeTimer->stop();
+    if (m_pendingWrites.isEmpty()) {
+        return;
+    }
+
+    NymeaSettings settings(NymeaSettings::SettingsRoleTags);
+    // Removals first, anything written after removing a group has been queued after that
+    for (auto it = m_pendingWrites.constBegin(); it != m_pendingWrites.constEnd(); ++it) {
+        if (!it.value().isValid()) {
+            settings.remove(it.key());
+        }
+    }
+    for (auto it = m_pendingWrites.constBegin(); it != m_pendingWrites.constEnd(); ++it) {
+        if (it.value().isValid()) {
+            settings.setValue(it.key(), it.value());
+        }
     }
-    settings.beginGroup(tag.appId());
-    settings.remove(tag.tagId());
+    m_pendingWrites.clear();
 }
 
 }
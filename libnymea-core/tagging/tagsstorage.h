@@ -30,6 +30,9 @@
 
 #include <QObject>
 #include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QTimer>
 
 class ThingManager;
 
@@ -50,6 +53,7 @@ public:
     Q_ENUM(TagError)
 
     explicit TagsStorage(ThingManager* thingManager, RuleEngine* ruleEngine, QObject *parent = nullptr);
+    ~TagsStorage() override;
 
     TagError addTag(const Tag &tag);
     TagError removeTag(const Tag &tag);
@@ -68,13 +72,23 @@ private slots:
     void ruleRemoved(const RuleId &ruleId);
 
 private:
+    // appId, tagId
+    typedef QPair<QString, QString> TagKey;
+
     void saveTag(const Tag &tag);
     void unsaveTag(const Tag &tag);
+    void unsaveGroup(const QString &group);
+    void writeTags();
 
 private:
     ThingManager *m_thingManager;
     RuleEngine *m_ruleEngine;
-    QList<Tag> m_tags;
+    QHash<ThingId, QHash<TagKey, Tag>> m_thingTags;
+    QHash<RuleId, QHash<TagKey, Tag>> m_ruleTags;
+
+    // Settings key => value to be written, invalid values are removed
+    QHash<QString, QVariant> m_pendingWrites;
+    QTimer *m_writeTimer = nullptr;
 };
 
 }
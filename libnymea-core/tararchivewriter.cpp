@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "tararchivewriter.h"
+
+#include <zlib.h>
+
+namespace nymeaserver {
+
+static const int tarBlockSize = 512;
+
+static void writeOctal(char *field, int length, qint64 value)
+{
+    QByteArray octal = QByteArray::number(value, 8).rightJustified(length - 1, '0');
+    memcpy(field, octal.constData(), length - 1);
+    field[length - 1] = '\0';
+}
+
+TarArchiveWriter::TarArchiveWriter(const QString &fileName):
+    m_file(fileName),
+    m_hash(QCryptographicHash::Md5)
+{
+
+}
+
+TarArchiveWriter::~TarArchiveWriter()
+{
+    if (m_stream) {
+        deflateEnd(m_stream);
+        delete m_stream;
+    }
+}
+
+bool TarArchiveWriter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QString("Could not open %1: %2").arg(m_file.fileName()).arg(m_file.errorString());
+        return false;
+    }
+
+    m_stream = new z_stream;
+    memset(m_stream, 0, sizeof(z_stream));
+    // 15 window bits + 16 makes zlib write a gzip header and trailer
+    if (deflateInit2(m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        m_errorString = "Could not initialize the compressor";
+        delete m_stream;
+        m_stream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TarArchiveWriter::addFile(const QString &sourceFileName, const QString &archiveFileName)
+{
+    QFile sourceFile(sourceFileName);
+    if (!sourceFile.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("Could not open %1: %2").arg(sourceFileName).arg(sourceFile.errorString());
+        return false;
+    }
+
+    // Log files might still grow while we are reading them. Only archive what was there when we started.
+    qint64 size = sourceFile.size();
+    if (!writeHeader(archiveFileName, size, sourceFile.fileTime(QFileDevice::FileModificationTime))) {
+        return false;
+    }
+
+    qint64 remaining = size;
+    while (remaining > 0) {
+        QByteArray chunk = sourceFile.read(qMin<qint64>(remaining, 64 * 1024));
+        if (chunk.isEmpty()) {
+            break;
+        }
+        if (!writeCompressed(chunk.constData(), chunk.size())) {
+            return false;
+        }
+        remaining -= chunk.size();
+    }
+
+    // The file shrunk in the meantime, fill up to the announced size
+    while (remaining > 0) {
+        QByteArray zeros(qMin<qint64>(remaining, 64 * 1024), '\0');
+        if (!writeCompressed(zeros.constData(), zeros.size())) {
+            return false;
+        }
+        remaining -= zeros.size();
+    }
+
+    return writePadding(size);
+}
+
+bool TarArchiveWriter::addData(const QString &archiveFileName, const QByteArray &data)
+{
+    if (!writeHeader(archiveFileName, data.size(), QDateTime::currentDateTime())) {
+        return false;
+    }
+    if (!writeCompressed(data.constData(), data.size())) {
+        return false;
+    }
+    return writePadding(data.size());
+}
+
+bool TarArchiveWriter::close()
+{
+    // A tar archive ends with two empty blocks
+    QByteArray endOfArchive(2 * tarBlockSize, '\0');
+    bool success = writeCompressed(endOfArchive.constData(), endOfArchive.size(), true);
+    m_file.close();
+    return success;
+}
+
+QString TarArchiveWriter::errorString() const
+{
+    return m_errorString;
+}
+
+qint64 TarArchiveWriter::size() const
+{
+    return m_file.size();
+}
+
+QString TarArchiveWriter::md5Sum() const
+{
+    return QString::fromUtf8(m_hash.result().toHex());
+}
+
+bool TarArchiveWriter::writeHeader(const QString &archiveFileName, qint64 size, const QDateTime &lastModified)
+{
+    char header[tarBlockSize];
+    memset(header, 0, tarBlockSize);
+
+    // Names longer than 100 bytes are split into prefix and name at a path separator
+    QByteArray name = archiveFileName.toUtf8();
+    QByteArray prefix;
+    if (name.size() > 100) {
+        int splitIndex = name.lastIndexOf('/', 155);
+        if (splitIndex <= 0 || name.size() - splitIndex - 1 > 100) {
+            m_errorString = QString("File name too long for the archive: %1").arg(archiveFileName);
+            return false;
+        }
+        prefix = name.left(splitIndex);
+        name = name.mid(splitIndex + 1);
+    }
+
+    memcpy(header, name.constData(), name.size());
+    writeOctal(header + 100, 8, 0644);
+    writeOctal(header + 108, 8, 0);
+    writeOctal(header + 116, 8, 0);
+    writeOctal(header + 124, 12, size);
+    writeOctal(header + 136, 12, lastModified.toMSecsSinceEpoch() / 1000);
+    header[156] = '0';
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memcpy(header + 345, prefix.constData(), prefix.size());
+
+    // The checksum is calculated with the checksum field filled with spaces
+    memset(header + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (int i = 0; i < tarBlockSize; i++) {
+        checksum += static_cast<unsigned char>(header[i]);
+    }
+    writeOctal(header + 148, 7, checksum);
+    header[155] = ' ';
+
+    return writeCompressed(header, tarBlockSize);
+}
+
+bool TarArchiveWriter::writePadding(qint64 size)
+{
+    int padding = (tarBlockSize - size % tarBlockSize) % tarBlockSize;
+    if (padding == 0) {
+        return true;
+    }
+    QByteArray zeros(padding, '\0');
+    return writeCompressed(zeros.constData(), zeros.size());
+}
+
+bool TarArchiveWriter::writeCompressed(const char *data, int length, bool finish)
+{
+    if (!m_stream) {
+        m_errorString = "The archive is not open";
+        return false;
+    }
+
+    char buffer[16 * 1024];
+    m_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    m_stream->avail_in = static_cast<uInt>(length);
+    do {
+        m_stream->next_out = reinterpret_cast<Bytef *>(buffer);
+        m_stream->avail_out = sizeof(buffer);
+        if (deflate(m_stream, finish ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+            m_errorString = "Error compressing the archive data";
+            return false;
+        }
+        int compressedSize = sizeof(buffer) - m_stream->avail_out;
+        if (compressedSize > 0) {
+            if (m_file.write(buffer, compressedSize) != compressedSize) {
+                m_errorString = QString("Could not write to %1: %2").arg(m_file.fileName()).arg(m_file.errorString());
+                return false;
+            }
+            m_hash.addData(QByteArray::fromRawData(buffer, compressedSize));
+        }
+    } while (m_stream->avail_out == 0);
+
+    return true;
+}
+
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TARARCHIVEWRITER_H
+#define TARARCHIVEWRITER_H
+
+#include <QFile>
+#include <QDateTime>
+#include <QCryptographicHash>
+
+struct z_stream_s;
+
+namespace nymeaserver {
+
+// Writes a gzip compressed tar archive (ustar format) straight to the given file.
+// Entries are streamed through the compressor, so neither the input files nor
+// the resulting archive need to be held in memory.
+class TarArchiveWriter
+{
+public:
+    explicit TarArchiveWriter(const QString &fileName);
+    ~TarArchiveWriter();
+
+    bool open();
+    bool addFile(const QString &sourceFileName, const QString &archiveFileName);
+    bool addData(const QString &archiveFileName, const QByteArray &data);
+    bool close();
+
+    QString errorString() const;
+    qint64 size() const;
+    QString md5Sum() const;
+
+private:
+    bool writeHeader(const QString &archiveFileName, qint64 size, const QDateTime &lastModified);
+    bool writePadding(qint64 size);
+    bool writeCompressed(const char *data, int length, bool finish = false);
+
+    QFile m_file;
+    z_stream_s *m_stream = nullptr;
+    QCryptographicHash m_hash;
+    QString m_errorString;
+};
+
+}
+
+#endif // TARARCHIVEWRITER_H
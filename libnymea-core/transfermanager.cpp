@@ -24,6 +24,7 @@
 
 #include "transfermanager.h"
 #include "loggingcategories.h"
+#include "nymeasettings.h"
 
 #include <QDir>
 #include <QFile>
@@ -45,7 +46,12 @@ int transferProgressPercent(qint64 offset, qint64 size)
 
 TransferManager::TransferManager(QObject *parent)
     : QObject(parent)
-{}
+{
+    // Uploads of a previous run can not be resumed any more
+    QDir uploadDir(uploadDirectory());
+    if (uploadDir.exists() && !uploadDir.removeRecursively())
+        qCWarning(dcTransfer()) << "Failed to clean up upload directory" << uploadDir.absolutePath();
+}
 
 TransferManager::TransferSessionInfo TransferManager::createUpload(const QString &fileName, qint64 size, const JsonContext &context)
 {
@@ -54,6 +60,8 @@ TransferManager::TransferSessionInfo TransferManager::createUpload(const QString
     session.transferToken = QUuid::createUuid().toString(QUuid::WithoutBraces);
     session.direction = Direction::Upload;
     session.fileName = fileName;
+    session.filePath = uploadDirectory() + "/" + session.transferId;
+    session.removeFile = true;
     session.size = size;
     session.ownerClientId = context.clientId();
     session.ownerToken = context.token();
@@ -78,7 +86,7 @@ TransferManager::TransferSessionInfo TransferManager::createRestoreUpload(const
     session.direction = Direction::Upload;
     session.uploadAction = UploadAction::RestoreBackup;
     session.fileName = fileName;
-    session.targetFilePath = targetFilePath;
+    session.filePath = targetFilePath;
     session.size = size;
     session.ownerClientId = context.clientId();
     session.ownerToken = context.token();
@@ -102,6 +110,7 @@ TransferManager::DownloadInfo TransferManager::createDownload(const QString &fil
     DownloadEntry entry;
     entry.downloadId = QUuid::createUuid().toString(QUuid::WithoutBraces);
     entry.fileName = fileName;
+    entry.size = data.size();
     entry.data = data;
     entry.ownerClientId = context.clientId();
     entry.ownerToken = context.token();
@@ -111,18 +120,48 @@ TransferManager::DownloadInfo TransferManager::createDownload(const QString &fil
         QVariantMap params;
         params.insert("downloadId", entry.downloadId);
         params.insert("fileName", entry.fileName);
-        params.insert("size", entry.data.size());
+        params.insert("size", entry.size);
         emit downloadAvailable(entry.ownerClientId, params);
     }
 
     info.downloadId = entry.downloadId;
     info.fileName = entry.fileName;
-    info.size = entry.data.size();
+    info.size = entry.size;
 
     qCDebug(dcTransfer()) << "Creating download ID" << info.downloadId << info.fileName << "size:" << info.size;
     return info;
 }
 
+TransferManager::DownloadInfo TransferManager::createFileDownload(const QString &fileName, const QString &filePath, const JsonContext &context, bool emitNotification, bool removeFile)
+{
+    DownloadInfo info;
+
+    DownloadEntry entry;
+    entry.downloadId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    entry.fileName = fileName;
+    entry.filePath = filePath;
+    entry.removeFile = removeFile;
+    entry.size = QFileInfo(filePath).size();
+    entry.ownerClientId = context.clientId();
+    entry.ownerToken = context.token();
+    m_downloads.insert(entry.downloadId, entry);
+
+    if (emitNotification) {
+        QVariantMap params;
+        params.insert("downloadId", entry.downloadId);
+        params.insert("fileName", entry.fileName);
+        params.insert("size", entry.size);
+        emit downloadAvailable(entry.ownerClientId, params);
+    }
+
+    info.downloadId = entry.downloadId;
+    info.fileName = entry.fileName;
+    info.size = entry.size;
+
+    qCDebug(dcTransfer()) << "Creating file download ID" << info.downloadId << info.fileName << "from" << filePath << "size:" << info.size;
+    return info;
+}
+
 TransferManager::TransferSessionInfo TransferManager::createDownloadTransfer(const QString &downloadId, const JsonContext &context)
 {
     TransferSessionInfo info;
@@ -136,7 +175,9 @@ TransferManager::TransferSessionInfo TransferManager::createDownloadTransfer(con
     session.transferToken = QUuid::createUuid().toString(QUuid::WithoutBraces);
     session.direction = Direction::Download;
     session.fileName = entry.fileName;
-    session.size = entry.data.size();
+    session.filePath = entry.filePath;
+    session.removeFile = entry.removeFile;
+    session.size = entry.size;
     session.data = entry.data;
     session.downloadId = entry.downloadId;
     session.ownerClientId = entry.ownerClientId;
@@ -182,7 +223,61 @@ qint64 TransferManager::transferOffset(const QString &transferId) const
     return m_transferSessions.value(transferId).offset;
 }
 
+bool TransferManager::seekTransfer(const QString &transferId, qint64 offset, QString *errorString)
+{
+    if (!m_transferSessions.contains(transferId)) {
+        if (errorString)
+            *errorString = QStringLiteral("Unknown transfer");
+
+        return false;
+    }
+
+    TransferSession &session = m_transferSessions[transferId];
+    if (session.direction == Direction::Download) {
+        if (offset < 0 || offset > session.size) {
+            if (errorString)
+                *errorString = QStringLiteral("Invalid resume offset");
+
+            return false;
+        }
+
+        session.offset = offset;
+        return true;
+    }
+
+    // An upload can only be resumed from data which has actually been received
+    if (offset < 0 || offset > session.offset) {
+        if (errorString)
+            *errorString = QStringLiteral("Invalid resume offset");
+
+        return false;
+    }
+
+    if (offset == session.offset)
+        return true;
+
+    QFile *file = openSessionFile(session, QIODevice::WriteOnly | QIODevice::Append, errorString);
+    if (!file)
+        return false;
+
+    if (!file->resize(offset)) {
+        if (errorString)
+            *errorString = file->errorString();
+
+        return false;
+    }
+
+    qCDebug(dcTransfer()) << "Resuming upload" << session.fileName << "at" << offset << "of" << session.size;
+    session.offset = offset;
+    return true;
+}
+
 bool TransferManager::appendUploadData(const QString &transferId, const QByteArray &data, QString *errorString)
+{
+    return writeUploadData(transferId, transferOffset(transferId), data, errorString);
+}
+
+bool TransferManager::writeUploadData(const QString &transferId, qint64 offset, const QByteArray &data, QString *errorString)
 {
     if (!m_transferSessions.contains(transferId)) {
         if (errorString)
@@ -199,41 +294,29 @@ bool TransferManager::appendUploadData(const QString &transferId, const QByteArr
         return false;
     }
 
-    if (session.size > 0 && session.offset + data.size() > session.size) {
+    if (offset != session.offset) {
         if (errorString)
-            *errorString = QStringLiteral("Upload exceeds announced size");
+            *errorString = QStringLiteral("Unexpected upload offset");
 
         return false;
     }
 
-    if (session.uploadAction == UploadAction::RestoreBackup) {
-        QFileInfo targetFileInfo(session.targetFilePath);
-        const QString targetDirectoryPath = targetFileInfo.absolutePath();
-        if (!QDir(targetDirectoryPath).exists() && !QDir().mkpath(targetDirectoryPath)) {
-            if (errorString)
-                *errorString = QStringLiteral("Failed to create upload destination directory");
-
-            return false;
-        }
-
-        QFile targetFile(session.targetFilePath);
-        if (!targetFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
-            if (errorString)
-                *errorString = targetFile.errorString();
+    if (session.size > 0 && session.offset + data.size() > session.size) {
+        if (errorString)
+            *errorString = QStringLiteral("Upload exceeds announced size");
 
-            return false;
-        }
+        return false;
+    }
 
-        if (targetFile.write(data) != data.size()) {
-            if (errorString)
-                *errorString = targetFile.errorString();
+    QFile *file = openSessionFile(session, QIODevice::WriteOnly | QIODevice::Append, errorString);
+    if (!file)
+        return false;
 
-            return false;
-        }
+    if (file->write(data) != data.size()) {
+        if (errorString)
+            *errorString = file->errorString();
 
-        targetFile.close();
-    } else {
-        session.data.append(data);
+        return false;
     }
 
     session.offset += data.size();
@@ -257,7 +340,7 @@ TransferManager::FinishedUploadInfo TransferManager::finishUpload(const QString
         return info;
     }
 
-    const TransferSession session = m_transferSessions.value(transferId);
+    TransferSession &session = m_transferSessions[transferId];
     if (session.direction != Direction::Upload) {
         if (errorString)
             *errorString = QStringLiteral("Transfer is not an upload");
@@ -272,33 +355,30 @@ TransferManager::FinishedUploadInfo TransferManager::finishUpload(const QString
         return info;
     }
 
+    // Make sure the file exists and everything is on disk, even for empty uploads
+    if (!openSessionFile(session, QIODevice::WriteOnly | QIODevice::Append, errorString))
+        return info;
+
+    session.file.reset();
+
     info.fileName = session.fileName;
     info.size = session.offset;
 
     if (session.uploadAction == UploadAction::RestoreBackup) {
-        if (!QFileInfo::exists(session.targetFilePath)) {
-            QFile targetFile(session.targetFilePath);
-            if (!targetFile.open(QIODevice::WriteOnly)) {
-                if (errorString)
-                    *errorString = targetFile.errorString();
-
-                return info;
-            }
-            targetFile.close();
-        }
         info.restoreTriggered = true;
     } else {
         JsonContext context(session.ownerClientId, QLocale(), !session.ownerToken.isEmpty());
         context.setToken(session.ownerToken);
-        const DownloadInfo downloadInfo = createDownload(session.fileName, session.data, context, true);
+        const DownloadInfo downloadInfo = createFileDownload(session.fileName, session.filePath, context, true, session.removeFile);
         info.downloadId = downloadInfo.downloadId;
         info.fileName = downloadInfo.fileName;
         info.size = downloadInfo.size;
     }
 
+    const QString filePath = session.filePath;
     m_transferSessions.remove(transferId);
     if (info.restoreTriggered)
-        emit restoreUploadFinished(session.transferId, session.targetFilePath);
+        emit restoreUploadFinished(transferId, filePath);
 
     return info;
 }
@@ -308,6 +388,24 @@ QByteArray TransferManager::readDownloadChunk(const QString &transferId, int max
     if (finished)
         *finished = false;
 
+    QString error;
+    const QByteArray chunk = readDownloadData(transferId, transferOffset(transferId), maxSize, &error);
+    if (!error.isEmpty()) {
+        if (errorString)
+            *errorString = error;
+
+        return QByteArray();
+    }
+
+    const bool done = acknowledgeDownload(transferId, transferOffset(transferId) + chunk.size());
+    if (finished)
+        *finished = done;
+
+    return chunk;
+}
+
+QByteArray TransferManager::readDownloadData(const QString &transferId, qint64 offset, int maxSize, QString *errorString)
+{
     if (!m_transferSessions.contains(transferId)) {
         if (errorString)
             *errorString = QStringLiteral("Unknown transfer");
@@ -323,17 +421,41 @@ QByteArray TransferManager::readDownloadChunk(const QString &transferId, int max
         return QByteArray();
     }
 
-    const QByteArray chunk = session.data.mid(session.offset, maxSize);
-    session.offset += chunk.size();
-    qCDebug(dcTransfer()) << "Download progress:" << session.fileName << session.offset << "/" << session.data.size()
-                          << QString("%1%").arg(transferProgressPercent(session.offset, session.data.size()));
-    if (finished)
-        *finished = session.offset >= session.data.size();
+    if (session.filePath.isEmpty())
+        return session.data.mid(static_cast<int>(offset), maxSize);
 
-    if (finished && *finished)
-        m_transferSessions.remove(transferId);
+    QFile *file = openSessionFile(session, QIODevice::ReadOnly, errorString);
+    if (!file)
+        return QByteArray();
 
-    return chunk;
+    if (file->pos() != offset && !file->seek(offset)) {
+        if (errorString)
+            *errorString = file->errorString();
+
+        return QByteArray();
+    }
+
+    return file->read(maxSize);
+}
+
+bool TransferManager::acknowledgeDownload(const QString &transferId, qint64 offset)
+{
+    if (!m_transferSessions.contains(transferId))
+        return false;
+
+    TransferSession &session = m_transferSessions[transferId];
+    if (session.direction != Direction::Download)
+        return false;
+
+    session.offset = qBound(session.offset, offset, session.size);
+    qCDebug(dcTransfer()) << "Download progress:" << session.fileName << session.offset << "/" << session.size
+                          << QString("%1%").arg(transferProgressPercent(session.offset, session.size));
+
+    if (session.offset < session.size)
+        return false;
+
+    closeSession(transferId);
+    return true;
 }
 
 bool TransferManager::matchesOwner(const DownloadEntry &entry, const JsonContext &context) const
@@ -344,4 +466,44 @@ bool TransferManager::matchesOwner(const DownloadEntry &entry, const JsonContext
     return entry.ownerClientId == context.clientId();
 }
 
+QFile *TransferManager::openSessionFile(TransferSession &session, QIODevice::OpenMode mode, QString *errorString)
+{
+    if (session.file && session.file->openMode() == mode)
+        return session.file.data();
+
+    if (mode & QIODevice::WriteOnly) {
+        const QString directoryPath = QFileInfo(session.filePath).absolutePath();
+        if (!QDir(directoryPath).exists() && !QDir().mkpath(directoryPath)) {
+            if (errorString)
+                *errorString = QStringLiteral("Failed to create upload destination directory");
+
+            return nullptr;
+        }
+    }
+
+    session.file.reset(new QFile(session.filePath));
+    if (!session.file->open(mode)) {
+        if (errorString)
+            *errorString = session.file->errorString();
+
+        session.file.reset();
+        return nullptr;
+    }
+
+    return session.file.data();
+}
+
+void TransferManager::closeSession(const QString &transferId)
+{
+    TransferSession session = m_transferSessions.take(transferId);
+    session.file.reset();
+    if (session.removeFile && !session.filePath.isEmpty())
+        QFile::remove(session.filePath);
+}
+
+QString TransferManager::uploadDirectory() const
+{
+    return NymeaSettings::cachePath() + "/transfers";
+}
+
 } // namespace nymeaserver
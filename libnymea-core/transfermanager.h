@@ -26,8 +26,10 @@
 #define TRANSFERMANAGER_H
 
 #include <QByteArray>
+#include <QFile>
 #include <QHash>
 #include <QObject>
+#include <QSharedPointer>
 #include <QUuid>
 #include <QVariantMap>
 
@@ -72,6 +74,7 @@ public:
     TransferSessionInfo createUpload(const QString &fileName, qint64 size, const JsonContext &context);
     TransferSessionInfo createRestoreUpload(const QString &fileName, qint64 size, const QString &targetFilePath, const JsonContext &context);
     DownloadInfo createDownload(const QString &fileName, const QByteArray &data, const JsonContext &context, bool emitNotification = false);
+    DownloadInfo createFileDownload(const QString &fileName, const QString &filePath, const JsonContext &context, bool emitNotification = false, bool removeFile = false);
     TransferSessionInfo createDownloadTransfer(const QString &downloadId, const JsonContext &context);
 
     bool uploadTransferExists(const QString &transferId) const;
@@ -82,10 +85,15 @@ public:
     QString transferFileName(const QString &transferId) const;
     qint64 transferOffset(const QString &transferId) const;
 
+    bool seekTransfer(const QString &transferId, qint64 offset, QString *errorString = nullptr);
+
     bool appendUploadData(const QString &transferId, const QByteArray &data, QString *errorString = nullptr);
+    bool writeUploadData(const QString &transferId, qint64 offset, const QByteArray &data, QString *errorString = nullptr);
     FinishedUploadInfo finishUpload(const QString &transferId, QString *errorString = nullptr);
 
     QByteArray readDownloadChunk(const QString &transferId, int maxSize, bool *finished, QString *errorString = nullptr);
+    QByteArray readDownloadData(const QString &transferId, qint64 offset, int maxSize, QString *errorString = nullptr);
+    bool acknowledgeDownload(const QString &transferId, qint64 offset);
 
 signals:
     void downloadAvailable(const QUuid &clientId, const QVariantMap &params);
@@ -104,8 +112,12 @@ private:
         Direction direction = Direction::Upload;
         UploadAction uploadAction = UploadAction::CreateDownload;
         QString fileName;
-        QString targetFilePath;
+        // Uploads are written to and downloads are read from this file, unless the download is held in data
+        QString filePath;
+        QSharedPointer<QFile> file;
+        bool removeFile = false;
         qint64 size = 0;
+        // Uploads: bytes written, downloads: bytes acknowledged by the client
         qint64 offset = 0;
         QByteArray data;
         QString downloadId;
@@ -117,12 +129,18 @@ private:
     {
         QString downloadId;
         QString fileName;
+        QString filePath;
+        bool removeFile = false;
+        qint64 size = 0;
         QByteArray data;
         QUuid ownerClientId;
         QByteArray ownerToken;
     };
 
     bool matchesOwner(const DownloadEntry &entry, const JsonContext &context) const;
+    QFile *openSessionFile(TransferSession &session, QIODevice::OpenMode mode, QString *errorString);
+    void closeSession(const QString &transferId);
+    QString uploadDirectory() const;
 
     QHash<QString, TransferSession> m_transferSessions;
     QHash<QString, DownloadEntry> m_downloads;
@@ -26,9 +26,19 @@
 #include "loggingcategories.h"
 
 #include <QJsonDocument>
+#include <QtEndian>
 
 namespace nymeaserver {
 
+namespace {
+
+const int defaultChunkSize = 64 * 1024;
+const int maxChunkSize = 1024 * 1024;
+const int defaultWindow = 8;
+const int maxWindow = 64;
+
+}
+
 TransferServerImplementation::TransferServerImplementation(TransferManager *transferManager, QObject *parent)
     : QObject(parent)
     , m_transferManager(transferManager)
@@ -77,28 +87,19 @@ void TransferServerImplementation::processData(const QUuid &clientId, const QByt
     if (!interface)
         interface = m_clients.value(clientId).transport;
 
-    QByteArray buffer = m_clients.value(clientId).buffer;
-    buffer.append(data);
-
-    int splitIndex = buffer.indexOf("}\n{");
-    while (splitIndex > -1) {
-        processPacket(interface, clientId, buffer.left(splitIndex + 1));
-        if (!m_clients.contains(clientId))
-            return;
-
-        buffer = buffer.right(buffer.length() - splitIndex - 2);
-        splitIndex = buffer.indexOf("}\n{");
-    }
-
-    if (buffer.trimmed().endsWith('}')) {
-        processPacket(interface, clientId, buffer);
-        if (!m_clients.contains(clientId))
-            return;
+    m_clients[clientId].reader.append(data);
 
-        buffer.clear();
+    // Note: the message references the buffer of the reader, which is gone once the client has been removed
+    QByteArray message;
+    auto clientIt = m_clients.find(clientId);
+    while (clientIt != m_clients.end() && clientIt->reader.readMessage(&message)) {
+        if (clientIt->binary) {
+            processBinaryFrame(interface, clientId, message);
+        } else {
+            processPacket(interface, clientId, message);
+        }
+        clientIt = m_clients.find(clientId);
     }
-
-    m_clients[clientId].buffer = buffer;
 }
 
 void TransferServerImplementation::processPacket(TransportInterface *interface, const QUuid &clientId, const QByteArray &data)
@@ -142,16 +143,46 @@ void TransferServerImplementation::processPacket(TransportInterface *interface,
             return;
         }
 
+        // Resume an interrupted transfer
+        if (params.contains("offset")) {
+            QString errorString;
+            if (!m_transferManager->seekTransfer(transferId, params.value("offset").toLongLong(), &errorString)) {
+                qCWarning(dcTransfer()) << "Error occurred in" << method << errorString;
+                sendErrorResponse(interface, clientId, commandId, errorString);
+                return;
+            }
+        }
+
         state.transferId = transferId;
         state.connected = true;
 
+        const bool binary = params.value("binary", false).toBool();
+        const bool download = m_transferManager->transferDirection(transferId) == TransferManager::Direction::Download;
+
         QVariantMap ret;
-        ret.insert("direction", m_transferManager->transferDirection(transferId) == TransferManager::Direction::Upload ? "upload" : "download");
+        ret.insert("direction", download ? "download" : "upload");
         ret.insert("fileName", m_transferManager->transferFileName(transferId));
         ret.insert("size", m_transferManager->transferSize(transferId));
         ret.insert("offset", m_transferManager->transferOffset(transferId));
+        if (binary) {
+            state.chunkSize = qBound(1024, params.value("chunkSize", defaultChunkSize).toInt(), maxChunkSize);
+            state.window = qBound(1, params.value("window", defaultWindow).toInt(), maxWindow);
+            ret.insert("binary", true);
+            ret.insert("chunkSize", state.chunkSize);
+            ret.insert("window", state.window);
+        }
         qCDebug(dcTransfer()) << "Transfer connected:" << qUtf8Printable(QJsonDocument::fromVariant(ret).toJson());
         sendResponse(interface, clientId, commandId, ret);
+
+        if (binary) {
+            // Everything after the handshake is sent as length prefixed binary frames
+            state.binary = true;
+            state.reader.setFraming(JsonRpcStreamReader::FramingLengthPrefixed);
+            if (download) {
+                state.sendOffset = m_transferManager->transferOffset(transferId);
+                sendDownloadData(interface, clientId);
+            }
+        }
         return;
     }
 
@@ -225,13 +256,117 @@ void TransferServerImplementation::processPacket(TransportInterface *interface,
     sendErrorResponse(interface, clientId, commandId, QStringLiteral("Unknown transfer method"));
 }
 
+void TransferServerImplementation::processBinaryFrame(TransportInterface *interface, const QUuid &clientId, const QByteArray &frame)
+{
+    if (frame.isEmpty())
+        return;
+
+    const BinaryFrameType type = static_cast<BinaryFrameType>(static_cast<quint8>(frame.at(0)));
+    if (type == BinaryFrameMessage) {
+        processPacket(interface, clientId, frame.mid(1));
+        return;
+    }
+
+    if (frame.size() < 9) {
+        qCWarning(dcTransfer()) << "Invalid binary frame from" << clientId.toString() << "Closing client connection.";
+        sendErrorResponse(interface, clientId, -1, QStringLiteral("Invalid binary frame"));
+        interface->terminateClientConnection(clientId);
+        return;
+    }
+
+    const qint64 offset = qFromBigEndian<qint64>(frame.constData() + 1);
+    const QString transferId = m_clients.constFind(clientId)->transferId;
+
+    if (type == BinaryFrameData) {
+        // Written straight to disk, the client keeps sending up to its window without waiting for each ack
+        QString errorString;
+        if (!m_transferManager->writeUploadData(transferId, offset, QByteArray::fromRawData(frame.constData() + 9, frame.size() - 9), &errorString)) {
+            qCWarning(dcTransfer()) << "Error writing binary upload data at offset" << offset << errorString;
+            sendErrorResponse(interface, clientId, -1, errorString);
+            interface->terminateClientConnection(clientId);
+            return;
+        }
+
+        sendFrame(interface, clientId, BinaryFrameAck, m_transferManager->transferOffset(transferId));
+        return;
+    }
+
+    if (type == BinaryFrameAck) {
+        if (m_transferManager->acknowledgeDownload(transferId, offset)) {
+            qCDebug(dcTransfer()) << "Binary download finished";
+            interface->terminateClientConnection(clientId);
+            return;
+        }
+
+        sendDownloadData(interface, clientId);
+        return;
+    }
+
+    qCWarning(dcTransfer()) << "Unknown binary frame type" << static_cast<int>(type) << "from" << clientId.toString();
+    sendErrorResponse(interface, clientId, -1, QStringLiteral("Unknown frame type"));
+}
+
+void TransferServerImplementation::sendDownloadData(TransportInterface *interface, const QUuid &clientId)
+{
+    auto clientIt = m_clients.find(clientId);
+    if (clientIt == m_clients.end())
+        return;
+
+    ClientState &state = clientIt.value();
+    const qint64 size = m_transferManager->transferSize(state.transferId);
+    const qint64 acknowledged = m_transferManager->transferOffset(state.transferId);
+
+    // Nothing to send for empty downloads, we are done right away
+    if (size == 0) {
+        m_transferManager->acknowledgeDownload(state.transferId, 0);
+        interface->terminateClientConnection(clientId);
+        return;
+    }
+
+    // Keep up to window chunks in flight, read from disk only what is about to be sent
+    const qint64 windowSize = static_cast<qint64>(state.chunkSize) * state.window;
+    while (state.sendOffset < size && state.sendOffset - acknowledged < windowSize) {
+        QString errorString;
+        const QByteArray chunk = m_transferManager->readDownloadData(state.transferId, state.sendOffset, state.chunkSize, &errorString);
+        if (!errorString.isEmpty() || chunk.isEmpty()) {
+            qCWarning(dcTransfer()) << "Error reading binary download data at offset" << state.sendOffset << errorString;
+            sendErrorResponse(interface, clientId, -1, errorString.isEmpty() ? QStringLiteral("Unexpected end of download") : errorString);
+            interface->terminateClientConnection(clientId);
+            return;
+        }
+
+        sendFrame(interface, clientId, BinaryFrameData, state.sendOffset, chunk);
+        state.sendOffset += chunk.size();
+    }
+}
+
+void TransferServerImplementation::sendFrame(TransportInterface *interface, const QUuid &clientId, BinaryFrameType type, qint64 offset, const QByteArray &payload)
+{
+    QByteArray frame(9, Qt::Uninitialized);
+    frame[0] = static_cast<char>(type);
+    qToBigEndian<qint64>(offset, frame.data() + 1);
+    frame.append(payload);
+    interface->sendBinaryData(clientId, frame);
+}
+
+void TransferServerImplementation::sendMessage(TransportInterface *interface, const QUuid &clientId, const QVariantMap &message)
+{
+    const QByteArray data = QJsonDocument::fromVariant(message).toJson(QJsonDocument::Compact);
+    auto clientIt = m_clients.constFind(clientId);
+    if (clientIt != m_clients.constEnd() && clientIt->binary) {
+        interface->sendBinaryData(clientId, char(BinaryFrameMessage) + data);
+    } else {
+        interface->sendData(clientId, data);
+    }
+}
+
 void TransferServerImplementation::sendResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QVariantMap &params)
 {
     QVariantMap response;
     response.insert("id", commandId);
     response.insert("status", "success");
     response.insert("params", params);
-    interface->sendData(clientId, QJsonDocument::fromVariant(response).toJson(QJsonDocument::Compact));
+    sendMessage(interface, clientId, response);
 }
 
 void TransferServerImplementation::sendErrorResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QString &error)
@@ -240,7 +375,7 @@ void TransferServerImplementation::sendErrorResponse(TransportInterface *interfa
     response.insert("id", commandId);
     response.insert("status", "error");
     response.insert("error", error);
-    interface->sendData(clientId, QJsonDocument::fromVariant(response).toJson(QJsonDocument::Compact));
+    sendMessage(interface, clientId, response);
 }
 
 } // namespace nymeaserver
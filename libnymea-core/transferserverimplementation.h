@@ -31,6 +31,7 @@
 
 #include "transportinterface.h"
 #include "transfermanager.h"
+#include "jsonrpc/jsonrpcstreamreader.h"
 
 namespace nymeaserver {
 
@@ -49,14 +50,33 @@ private slots:
     void processData(const QUuid &clientId, const QByteArray &data);
 
 private:
+    // In binary mode each message after Transfer.Connect starts with one of these types
+    enum BinaryFrameType {
+        // 64 bit big endian offset followed by the raw data
+        BinaryFrameData = 0x01,
+        // 64 bit big endian offset up to which data has been received
+        BinaryFrameAck = 0x02,
+        // A JSON encoded command or response
+        BinaryFrameMessage = 0x03
+    };
+
     struct ClientState {
         TransportInterface *transport = nullptr;
-        QByteArray buffer;
+        JsonRpcStreamReader reader;
         QString transferId;
         bool connected = false;
+        bool binary = false;
+        int chunkSize = 0;
+        int window = 0;
+        // Downloads in binary mode: data sent but possibly not acknowledged yet
+        qint64 sendOffset = 0;
     };
 
     void processPacket(TransportInterface *interface, const QUuid &clientId, const QByteArray &data);
+    void processBinaryFrame(TransportInterface *interface, const QUuid &clientId, const QByteArray &frame);
+    void sendDownloadData(TransportInterface *interface, const QUuid &clientId);
+    void sendFrame(TransportInterface *interface, const QUuid &clientId, BinaryFrameType type, qint64 offset, const QByteArray &payload = QByteArray());
+    void sendMessage(TransportInterface *interface, const QUuid &clientId, const QVariantMap &message);
     void sendResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QVariantMap &params = QVariantMap());
     void sendErrorResponse(TransportInterface *interface, const QUuid &clientId, int commandId, const QString &error);
 
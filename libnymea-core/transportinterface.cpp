@@ -66,6 +66,13 @@
     Pure virtual method for sending \a data to \a clients over the corresponding \l{TransportInterface}.
 */
 
+/*! \fn void nymeaserver::TransportInterface::sendBinaryData(const QUuid &clientId, const QByteArray &data);
+    Pure virtual method for sending a binary encoded message \a data to the client with the id \a clientId.
+    Stream based transports prefix the message with its length as 32 bit big endian integer, message based
+    transports send it as a single binary message. Incoming binary messages are emitted in the length prefixed
+    form in \l{dataAvailable()}.
+*/
+
 /*! \fn void nymeaserver::TransportInterface::terminateClientConnection(const QUuid &clientId);
     Pure virtual method for terminating \a clients connection. The JSON RPC server might call this when a
     client violates the protocol. Transports should close the connection to the client.
@@ -84,6 +91,7 @@
 #include "loggingcategories.h"
 
 #include <QJsonDocument>
+#include <QtEndian>
 
 namespace nymeaserver {
 
@@ -114,6 +122,15 @@ void TransportInterface::setServerName(
     m_serverName = serverName;
 }
 
+/*! Returns the given \a data prefixed with its length as 32 bit big endian integer. */
+QByteArray TransportInterface::lengthPrefixed(const QByteArray &data)
+{
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(data.size(), frame.data());
+    frame.append(data);
+    return frame;
+}
+
 /*! Virtual destructor for \l{TransportInterface}. */
 TransportInterface::~TransportInterface() {}
 
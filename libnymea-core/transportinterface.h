@@ -43,6 +43,7 @@ public:
 
     virtual void sendData(const QUuid &clientId, const QByteArray &data) = 0;
     virtual void sendData(const QList<QUuid> &clients, const QByteArray &data) = 0;
+    virtual void sendBinaryData(const QUuid &clientId, const QByteArray &data) = 0;
 
     virtual void terminateClientConnection(const QUuid &clientId) = 0;
 
@@ -50,6 +51,8 @@ public:
     ServerConfiguration configuration() const;
 
 protected:
+    static QByteArray lengthPrefixed(const QByteArray &data);
+
     QString m_serverName;
 
 signals:
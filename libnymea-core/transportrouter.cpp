@@ -45,6 +45,11 @@ void RoutedTransportInterface::sendData(const QList<QUuid> &clients, const QByte
     m_backend->sendData(clients, data);
 }
 
+void RoutedTransportInterface::sendBinaryData(const QUuid &clientId, const QByteArray &data)
+{
+    m_backend->sendBinaryData(clientId, data);
+}
+
 void RoutedTransportInterface::terminateClientConnection(const QUuid &clientId)
 {
     m_backend->terminateClientConnection(clientId);
@@ -41,6 +41,7 @@ public:
 
     void sendData(const QUuid &clientId, const QByteArray &data) override;
     void sendData(const QList<QUuid> &clients, const QByteArray &data) override;
+    void sendBinaryData(const QUuid &clientId, const QByteArray &data) override;
     void terminateClientConnection(const QUuid &clientId) override;
 
     bool startServer() override;
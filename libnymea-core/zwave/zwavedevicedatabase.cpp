@@ -38,15 +38,26 @@ Q_DECLARE_LOGGING_CATEGORY(dcZWave)
 
 namespace nymeaserver {
 
-ZWaveDeviceDatabase::ZWaveDeviceDatabase(const QString &path, const QUuid &networkUuid):
+ZWaveDeviceDatabase::ZWaveDeviceDatabase(const QString &path, const QUuid &networkUuid, QObject *parent):
+    QObject(parent),
     m_path(path),
     m_networkUuid(networkUuid)
 {
+    // Value reports arrive in bursts, collect them and write them in one transaction
+    m_flushTimer.setInterval(2000);
+    m_flushTimer.setSingleShot(true);
+    connect(&m_flushTimer, &QTimer::timeout, this, &ZWaveDeviceDatabase::flush);
+}
+
+ZWaveDeviceDatabase::~ZWaveDeviceDatabase()
+{
+    flush();
+    closeDB();
 }
 
 bool ZWaveDeviceDatabase::initDB()
 {
-    m_db.close();
+    closeDB();
 
     QDir path(m_path);
     if (!path.exists()) {
@@ -66,6 +77,14 @@ bool ZWaveDeviceDatabase::initDB()
         return false;
     }
 
+    QSqlQuery pragmaQuery(m_db);
+    if (!pragmaQuery.exec("PRAGMA journal_mode=WAL;")) {
+        qCWarning(dcZWave()) << "Unable to enable write-ahead logging for ZWave device DB:" << pragmaQuery.lastError().databaseText();
+    }
+    if (!pragmaQuery.exec("PRAGMA synchronous=NORMAL;")) {
+        qCWarning(dcZWave()) << "Unable to set synchronous mode for ZWave device DB:" << pragmaQuery.lastError().databaseText();
+    }
+
     if (!m_db.tables().contains("metadata")) {
         qCDebug(dcZWave()) << "No \"metadata\" table in database. Creating it.";
         QSqlQuery query(m_db);
@@ -133,18 +152,34 @@ bool ZWaveDeviceDatabase::initDB()
         }
     }
 
+    m_storeNodeQuery = QSqlQuery(m_db);
+    if (!m_storeNodeQuery.prepare("INSERT OR REPLACE INTO nodes(nodeId, basicType, deviceType, plusDeviceType, manufacturerId, manufacturerName, name, productId, productName, productType, isZWavePlus, isSecure, isBeaming, version) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);")) {
+        qCCritical(dcZWave()) << "Unable to prepare node query:" << m_storeNodeQuery.lastError().databaseText();
+        return false;
+    }
+    m_storeValueQuery = QSqlQuery(m_db);
+    if (!m_storeValueQuery.prepare("INSERT OR REPLACE INTO nodevalues(valueId, nodeId, valueGenre, commandClass, instance, idx, type, value, valueSelection, description) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);")) {
+        qCCritical(dcZWave()) << "Unable to prepare node value query:" << m_storeValueQuery.lastError().databaseText();
+        return false;
+    }
+
     qCInfo(dcZWave()) << "Initialized devices DB successfully." << m_db.databaseName();
     return true;
 }
 
 void ZWaveDeviceDatabase::removeDB()
 {
-    m_db.close();
+    discardPendingWrites();
+    closeDB();
     QFile::remove(m_db.databaseName());
+    QFile::remove(m_db.databaseName() + "-wal");
+    QFile::remove(m_db.databaseName() + "-shm");
 }
 
 void ZWaveDeviceDatabase::clearDB()
 {
+    discardPendingWrites();
+
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM nodes;");
     if (!query.exec()) {
@@ -156,35 +191,40 @@ void ZWaveDeviceDatabase::clearDB()
 
 void ZWaveDeviceDatabase::storeNode(ZWaveNode *node)
 {
-    QSqlQuery query(m_db);
-    query.prepare("INSERT OR REPLACE INTO nodes(nodeId, basicType, deviceType, plusDeviceType, manufacturerId, manufacturerName, name, productId, productName, productType, isZWavePlus, isSecure, isBeaming, version) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
-    query.addBindValue(node->nodeId());
-    query.addBindValue(node->nodeType());
-    query.addBindValue(node->deviceType());
-    query.addBindValue(node->plusDeviceType());
-    query.addBindValue(node->manufacturerId());
-    query.addBindValue(node->manufacturerName());
-    query.addBindValue(node->name());
-    query.addBindValue(node->productId());
-    query.addBindValue(node->productName());
-    query.addBindValue(node->productType());
-    query.addBindValue(node->isZWavePlusDevice());
-    query.addBindValue(node->isSecurityDevice());
-    query.addBindValue(node->isBeamingDevice());
-    query.addBindValue(node->version());
-    if (!query.exec()) {
-        qCWarning(dcZWave) << "Error inserting node into db:" << query.lastError().databaseText() << query.lastError().driverText();
-        qCDebug(dcZWave) << "Query was:" << query.executedQuery();
-        return;
-    }
+    QVariantList bindValues;
+    bindValues << node->nodeId();
+    bindValues << node->nodeType();
+    bindValues << node->deviceType();
+    bindValues << node->plusDeviceType();
+    bindValues << node->manufacturerId();
+    bindValues << node->manufacturerName();
+    bindValues << node->name();
+    bindValues << node->productId();
+    bindValues << node->productName();
+    bindValues << node->productType();
+    bindValues << node->isZWavePlusDevice();
+    bindValues << node->isSecurityDevice();
+    bindValues << node->isBeamingDevice();
+    bindValues << node->version();
+    m_pendingNodes.insert(node->nodeId(), bindValues);
 
     foreach (const ZWaveValue &value, node->values()) {
         storeValue(node, value.id());
     }
+
+    scheduleFlush();
 }
 
 void ZWaveDeviceDatabase::removeNode(quint8 nodeId)
 {
+    m_pendingNodes.remove(nodeId);
+    QMutableHashIterator<QPair<quint8, quint64>, QVariantList> it(m_pendingValues);
+    while (it.hasNext()) {
+        if (it.next().key().first == nodeId) {
+            it.remove();
+        }
+    }
+
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM nodes WHERE nodeId = ?;");
     query.addBindValue(nodeId);
@@ -203,25 +243,26 @@ void ZWaveDeviceDatabase::storeValue(ZWaveNode *node, quint64 valueId)
     QDataStream out(&byteArray, QIODevice::WriteOnly);
     out << value.value();
 
-    QSqlQuery query(m_db);
-    query.prepare("INSERT OR REPLACE INTO nodevalues(valueId, nodeId, valueGenre, commandClass, instance, idx, type, value, valueSelection, description) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
-    query.addBindValue(value.id());
-    query.addBindValue(node->nodeId());
-    query.addBindValue(value.genre());
-    query.addBindValue(value.commandClass());
-    query.addBindValue(value.instance());
-    query.addBindValue(value.index());
-    query.addBindValue(value.type());
-    query.addBindValue(byteArray.toBase64());
-    query.addBindValue(value.valueListSelection());
-    query.addBindValue(value.description());
-    if (!query.exec()) {
-        qCWarning(dcZWave) << "Unable to store node value:" << query.lastError().databaseText();
-    }
+    QVariantList bindValues;
+    bindValues << value.id();
+    bindValues << node->nodeId();
+    bindValues << value.genre();
+    bindValues << value.commandClass();
+    bindValues << value.instance();
+    bindValues << value.index();
+    bindValues << value.type();
+    bindValues << byteArray.toBase64();
+    bindValues << value.valueListSelection();
+    bindValues << value.description();
+    m_pendingValues.insert(qMakePair(node->nodeId(), valueId), bindValues);
+
+    scheduleFlush();
 }
 
 void ZWaveDeviceDatabase::removeValue(ZWaveNode *node, quint64 valueId)
 {
+    m_pendingValues.remove(qMakePair(node->nodeId(), valueId));
+
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM nodevalues WHERE nodeId = ? AND valueId = ?;");
     query.addBindValue(node->nodeId());
@@ -233,6 +274,8 @@ void ZWaveDeviceDatabase::removeValue(ZWaveNode *node, quint64 valueId)
 
 ZWaveNodes ZWaveDeviceDatabase::createNodes(ZWaveManager *manager)
 {
+    flush();
+
     ZWaveNodes ret;
     QSqlQuery query(m_db);
     query.prepare("SELECT * FROM nodes;");
@@ -289,4 +332,87 @@ ZWaveNodes ZWaveDeviceDatabase::createNodes(ZWaveManager *manager)
     return ret;
 }
 
+void ZWaveDeviceDatabase::flush()
+{
+    m_flushTimer.stop();
+
+    if (m_pendingNodes.isEmpty() && m_pendingValues.isEmpty()) {
+        return;
+    }
+
+    if (!m_db.isOpen()) {
+        qCWarning(dcZWave()) << "ZWave device DB not open. Dropping" << m_pendingNodes.count() << "node and" << m_pendingValues.count() << "value updates.";
+        discardPendingWrites();
+        return;
+    }
+
+    if (!m_db.transaction()) {
+        qCWarning(dcZWave()) << "Unable to start transaction on ZWave device DB:" << m_db.lastError().databaseText();
+        scheduleFlush();
+        return;
+    }
+
+    // Nodes first, values reference them
+    foreach (const QVariantList &bindValues, m_pendingNodes) {
+        if (!execStoreQuery(m_storeNodeQuery, bindValues)) {
+            m_db.rollback();
+            scheduleFlush();
+            return;
+        }
+    }
+    foreach (const QVariantList &bindValues, m_pendingValues) {
+        if (!execStoreQuery(m_storeValueQuery, bindValues)) {
+            m_db.rollback();
+            scheduleFlush();
+            return;
+        }
+    }
+
+    if (!m_db.commit()) {
+        qCWarning(dcZWave()) << "Unable to commit ZWave device DB transaction:" << m_db.lastError().databaseText();
+        m_db.rollback();
+        scheduleFlush();
+        return;
+    }
+
+    qCDebug(dcZWave()) << "Stored" << m_pendingNodes.count() << "nodes and" << m_pendingValues.count() << "values to ZWave device DB";
+    m_pendingNodes.clear();
+    m_pendingValues.clear();
+}
+
+void ZWaveDeviceDatabase::scheduleFlush()
+{
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void ZWaveDeviceDatabase::discardPendingWrites()
+{
+    m_flushTimer.stop();
+    m_pendingNodes.clear();
+    m_pendingValues.clear();
+}
+
+void ZWaveDeviceDatabase::closeDB()
+{
+    // Prepared statements keep the connection busy, release them before closing
+    m_storeNodeQuery.clear();
+    m_storeValueQuery.clear();
+    m_db.close();
+}
+
+bool ZWaveDeviceDatabase::execStoreQuery(QSqlQuery &query, const QVariantList &bindValues)
+{
+    for (int i = 0; i < bindValues.count(); i++) {
+        query.bindValue(i, bindValues.at(i));
+    }
+    if (!query.exec()) {
+        qCWarning(dcZWave()) << "Error storing data in ZWave device DB:" << query.lastError().databaseText() << query.lastError().driverText();
+        qCDebug(dcZWave()) << "Query was:" << query.executedQuery();
+        return false;
+    }
+    return true;
+}
+
 }
@@ -25,7 +25,10 @@
 #ifndef ZWAVEDEVICEDATABASE_H
 #define ZWAVEDEVICEDATABASE_H
 
+#include <QObject>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTimer>
 
 #include "hardware/zwave/zwavenode.h"
 
@@ -33,10 +36,12 @@ namespace nymeaserver {
 
 class ZWaveManager;
 
-class ZWaveDeviceDatabase
+class ZWaveDeviceDatabase: public QObject
 {
+    Q_OBJECT
 public:
-    explicit ZWaveDeviceDatabase(const QString &path, const QUuid &networkUuid);
+    explicit ZWaveDeviceDatabase(const QString &path, const QUuid &networkUuid, QObject *parent = nullptr);
+    ~ZWaveDeviceDatabase() override;
 
     bool initDB();
     void removeDB();
@@ -48,10 +53,25 @@ public:
     void removeValue(ZWaveNode *node, quint64 valueId);
     ZWaveNodes createNodes(ZWaveManager *manager);
 
+    void flush();
+
 private:
+    void scheduleFlush();
+    void discardPendingWrites();
+    void closeDB();
+    bool execStoreQuery(QSqlQuery &query, const QVariantList &bindValues);
+
     QString m_path;
     QUuid m_networkUuid;
     QSqlDatabase m_db;
+
+    // Write-behind buffers, deduplicated so only the latest state of a node or value gets written
+    QHash<quint8, QVariantList> m_pendingNodes;
+    QHash<QPair<quint8, quint64>, QVariantList> m_pendingValues;
+    QTimer m_flushTimer;
+
+    QSqlQuery m_storeNodeQuery;
+    QSqlQuery m_storeValueQuery;
 };
 
 }
@@ -157,7 +157,7 @@ bool ZWaveManager::loadNetwork(ZWaveNetwork *network)
         return false;
     }
 
-    ZWaveDeviceDatabase *db = new ZWaveDeviceDatabase(NymeaSettings::settingsPath(), network->networkUuid());
+    ZWaveDeviceDatabase *db = new ZWaveDeviceDatabase(NymeaSettings::settingsPath(), network->networkUuid(), this);
     if (!db->initDB()) {
         qCCritical(dcZWave()) << "Unable to initialize ZWave device database";
         delete db;
@@ -586,9 +586,15 @@ void PluginMetadata::parse(const QJsonObject &jsonObject)
                     QString filter = st.value("filter").toString();
                     if (filter == "adaptive") {
                         stateType.setFilter(Types::StateValueFilterAdaptive);
+                    } else if (filter == "exponential") {
+                        stateType.setFilter(Types::StateValueFilterExponential);
+                    } else if (filter == "deadband") {
+                        stateType.setFilter(Types::StateValueFilterDeadband);
+                    } else if (filter == "ratelimit") {
+                        stateType.setFilter(Types::StateValueFilterRateLimit);
                     } else if (!filter.isEmpty()) {
                         m_validationErrors.append("Thing class \"" + thingClass.name() + "\" state type \"" + stateTypeName + "\" has invalid filter value \"" + filter
-                                                  + "\". Supported filters are: \"adaptive\"");
+                                                  + "\". Supported filters are: \"adaptive\", \"exponential\", \"deadband\", \"ratelimit\"");
                         hasError = true;
                     }
                 }
@@ -28,14 +28,15 @@
 
 StateValueFilterAdaptive::StateValueFilterAdaptive()
 {
-
+    m_inputValues.resize(m_windowSize);
 }
 
 void StateValueFilterAdaptive::addValue(const QVariant &value)
 {
-    m_inputValues.prepend(value.toDouble());
+    double currentValue = value.toDouble();
+    appendInput(currentValue);
     m_inputValueCount++;
-    update();
+    update(currentValue);
 }
 
 QVariant StateValueFilterAdaptive::filteredValue() const
@@ -43,25 +44,44 @@ QVariant StateValueFilterAdaptive::filteredValue() const
     return m_outputValue;
 }
 
-void StateValueFilterAdaptive::update()
+void StateValueFilterAdaptive::appendInput(double value)
 {
-    while (m_inputValues.count() > m_windowSize) {
-        m_inputValues.removeLast();
+    if (m_inputCount == m_windowSize) {
+        // Buffer is full, the slot at the head holds the oldest value
+        m_inputSum -= m_inputValues.at(m_inputHead);
+    } else {
+        m_inputCount++;
     }
-
-    if (m_inputValues.isEmpty()) {
-        m_outputValue = 0;
-        return;
+    m_inputValues[m_inputHead] = value;
+    m_inputSum += value;
+    m_inputHead = (m_inputHead + 1) % m_windowSize;
+
+    // Re-sum once per full cycle to get rid of accumulated floating point errors
+    if (m_inputHead == 0 && m_inputCount == m_windowSize) {
+        m_inputSum = 0;
+        for (int i = 0; i < m_windowSize; i++) {
+            m_inputSum += m_inputValues.at(i);
+        }
     }
+}
 
-    if (m_inputValues.count() == 1) {
+void StateValueFilterAdaptive::resetInput(double value)
+{
+    m_inputValues[0] = value;
+    m_inputHead = 1 % m_windowSize;
+    m_inputCount = 1;
+    m_inputSum = value;
+}
+
+void StateValueFilterAdaptive::update(double currentValue)
+{
+    if (m_inputCount == 1) {
         // Not enough data
-        m_outputValue = m_inputValues.first();
+        m_outputValue = currentValue;
         m_outputValueCount++;
         return;
     }
 
-    double currentValue = m_inputValues.first();
     if (qFuzzyCompare(currentValue, 0)) {
         // If we went to 0, follow right away.
         m_outputValue = 0;
@@ -69,12 +89,8 @@ void StateValueFilterAdaptive::update()
     }
 
     // Calculate average of history, for all values and for all but the last one
-    double sum = 0;
-    for (int i = 0; i < m_inputValues.count(); i++) {
-        sum += m_inputValues.at(i);
-    }
-    double normalizedValue = sum / m_inputValues.count();
-    double previousNormalizedValue = (sum - m_inputValues.first()) / (m_inputValues.count() - 1);
+    double normalizedValue = m_inputSum / m_inputCount;
+    double previousNormalizedValue = (m_inputSum - currentValue) / (m_inputCount - 1);
 
     if (qFuzzyCompare(previousNormalizedValue, 0)) {
         // We can't calculate anything if the history is at 0. Follow right away to the new value.
@@ -93,8 +109,7 @@ void StateValueFilterAdaptive::update()
     // it's a 99% chance a big change happened that's not jitter (e.g turned on/off)
     // Discard the history and follow the new value right away
     if (qAbs(changeRatioToAverage) > m_standardDeviation * 3) {
-        m_inputValues.clear();
-        m_inputValues.prepend(currentValue);
+        resetInput(currentValue);
         m_totalDeviation = 0;
         if (!qFuzzyCompare(m_outputValue, normalizedValue)) {
             m_outputValue = currentValue;
@@ -128,9 +143,12 @@ void StateValueFilterAdaptive::update()
         m_outputValueCount = 0;
     }
 
-    qCDebug(dcStateValueFilter()) << "Filter statistics for" << this;
-    qCDebug(dcStateValueFilter()) << "Input:" << currentValue << "AVG:" << previousNormalizedValue << "Filtered:" << normalizedValue;
-    qCDebug(dcStateValueFilter()) << "Change ratios: Input/average:" << changeRatioToAverage << "Filtered/average:" << changeRatioFiltered  << "Input/output:" << changeRatioToCurrentOutput;
-    qCDebug(dcStateValueFilter()) << "Std deviation:" << m_standardDeviation << "Total deviation:" << m_totalDeviation;
-    qCDebug(dcStateValueFilter()) << "Compression ratio:" << (1.0 * m_inputValueCount / m_outputValueCount) << "(" << m_outputValueCount << "/" << m_inputValueCount << ")";
+    // This runs for every single input value, don't even build the debug output unless it's going to be printed
+    if (dcStateValueFilter().isDebugEnabled()) {
+        qCDebug(dcStateValueFilter()) << "Filter statistics for" << this;
+        qCDebug(dcStateValueFilter()) << "Input:" << currentValue << "AVG:" << previousNormalizedValue << "Filtered:" << normalizedValue;
+        qCDebug(dcStateValueFilter()) << "Change ratios: Input/average:" << changeRatioToAverage << "Filtered/average:" << changeRatioFiltered  << "Input/output:" << changeRatioToCurrentOutput;
+        qCDebug(dcStateValueFilter()) << "Std deviation:" << m_standardDeviation << "Total deviation:" << m_totalDeviation;
+        qCDebug(dcStateValueFilter()) << "Compression ratio:" << (1.0 * m_inputValueCount / m_outputValueCount) << "(" << m_outputValueCount << "/" << m_inputValueCount << ")";
+    }
 }
@@ -27,6 +27,8 @@
 
 #include "statevaluefilter.h"
 
+#include <QVector>
+
 class StateValueFilterAdaptive : public StateValueFilter
 {
 public:
@@ -36,10 +38,17 @@ public:
     QVariant filteredValue() const override;
 
 private:
-    void update();
+    void update(double currentValue);
+    void appendInput(double value);
+    void resetInput(double value);
 
 private:
-    QList<double> m_inputValues;
+    // Ring buffer holding the last m_windowSize input values. m_inputSum is kept
+    // up to date on every insert so the average can be calculated in constant time.
+    QVector<double> m_inputValues;
+    int m_inputHead = 0;
+    int m_inputCount = 0;
+    double m_inputSum = 0;
 
     int m_windowSize = 20;
     double m_standardDeviation = 0.05;
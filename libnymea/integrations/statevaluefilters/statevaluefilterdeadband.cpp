@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "statevaluefilterdeadband.h"
+
+#include <qmath.h>
+
+StateValueFilterDeadband::StateValueFilterDeadband()
+{
+
+}
+
+void StateValueFilterDeadband::addValue(const QVariant &value)
+{
+    double currentValue = value.toDouble();
+
+    if (!m_initialized || qFuzzyCompare(currentValue, 0)) {
+        // First value or we went to 0. Follow right away.
+        m_outputValue = currentValue;
+        m_initialized = true;
+        return;
+    }
+
+    double band = qMax(qAbs(m_outputValue) * m_relativeBand, m_absoluteBand);
+    if (qAbs(currentValue - m_outputValue) > band) {
+        m_outputValue = currentValue;
+    }
+}
+
+QVariant StateValueFilterDeadband::filteredValue() const
+{
+    return m_outputValue;
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef STATEVALUEFILTERDEADBAND_H
+#define STATEVALUEFILTERDEADBAND_H
+
+#include "statevaluefilter.h"
+
+class StateValueFilterDeadband : public StateValueFilter
+{
+public:
+    StateValueFilterDeadband();
+
+    void addValue(const QVariant &value) override;
+    QVariant filteredValue() const override;
+
+private:
+    // The output only follows the input if it moves away further than the band,
+    // which is relative to the current output but never smaller than the absolute minimum.
+    double m_relativeBand = 0.01;
+    double m_absoluteBand = 0.01;
+
+    bool m_initialized = false;
+    double m_outputValue = 0;
+};
+
+#endif // STATEVALUEFILTERDEADBAND_H
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "statevaluefilterexponential.h"
+
+#include <qmath.h>
+
+StateValueFilterExponential::StateValueFilterExponential()
+{
+
+}
+
+void StateValueFilterExponential::addValue(const QVariant &value)
+{
+    double currentValue = value.toDouble();
+
+    if (!m_initialized || qFuzzyCompare(currentValue, 0) || qFuzzyCompare(m_outputValue, 0)) {
+        // Nothing to smooth yet, or we went to/from 0. Follow right away.
+        m_outputValue = currentValue;
+        m_initialized = true;
+        return;
+    }
+
+    if (qAbs(currentValue - m_outputValue) > qAbs(m_outputValue) * m_stepThreshold) {
+        qCDebug(dcStateValueFilter()) << "Updating output value:" << currentValue << "(input exceeds step threshold)";
+        m_outputValue = currentValue;
+        return;
+    }
+
+    double change = m_smoothingFactor * (currentValue - m_outputValue);
+    if (qAbs(change) < qMax(qAbs(m_outputValue) * m_minRelativeChange, m_minAbsoluteChange)) {
+        // Not worth a state change
+        return;
+    }
+
+    m_outputValue += change;
+}
+
+QVariant StateValueFilterExponential::filteredValue() const
+{
+    return m_outputValue;
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef STATEVALUEFILTEREXPONENTIAL_H
+#define STATEVALUEFILTEREXPONENTIAL_H
+
+#include "statevaluefilter.h"
+
+class StateValueFilterExponential : public StateValueFilter
+{
+public:
+    StateValueFilterExponential();
+
+    void addValue(const QVariant &value) override;
+    QVariant filteredValue() const override;
+
+private:
+    // Weight of a new input value
+    double m_smoothingFactor = 0.2;
+    // Relative change to the current output considered a step (e.g. turned on/off) which is followed right away
+    double m_stepThreshold = 0.5;
+    // Smallest change of the output value (relative to the output, at least the absolute value) worth an update
+    double m_minRelativeChange = 0.001;
+    double m_minAbsoluteChange = 0.001;
+
+    bool m_initialized = false;
+    double m_outputValue = 0;
+};
+
+#endif // STATEVALUEFILTEREXPONENTIAL_H
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "statevaluefilterratelimit.h"
+
+#include <qmath.h>
+
+StateValueFilterRateLimit::StateValueFilterRateLimit(int minInterval, QObject *parent):
+    QObject(parent),
+    m_minInterval(minInterval)
+{
+    m_trailingTimer.setSingleShot(true);
+    connect(&m_trailingTimer, &QTimer::timeout, this, [this](){
+        // Apply the latest value which arrived during the interval
+        QVariant value = m_pendingValue;
+        m_pendingValue.clear();
+        if (value.isValid() && value != m_outputValue) {
+            updateOutputValue(value);
+            emit filteredValueChanged(m_outputValue);
+        }
+    });
+}
+
+void StateValueFilterRateLimit::addValue(const QVariant &value)
+{
+    if (m_lastUpdate.isValid() && !m_lastUpdate.hasExpired(m_minInterval)) {
+        bool wasZero = qFuzzyCompare(m_outputValue.toDouble(), 0);
+        bool isZero = qFuzzyCompare(value.toDouble(), 0);
+        if (wasZero == isZero) {
+            // Keep the latest value and apply it once the interval expired
+            m_pendingValue = value;
+            if (!m_trailingTimer.isActive()) {
+                m_trailingTimer.start(static_cast<int>(qMax<qint64>(0, m_minInterval - m_lastUpdate.elapsed())));
+            }
+            return;
+        }
+    }
+
+    m_pendingValue.clear();
+    m_trailingTimer.stop();
+    if (m_outputValue != value) {
+        updateOutputValue(value);
+    }
+}
+
+QVariant StateValueFilterRateLimit::filteredValue() const
+{
+    return m_outputValue;
+}
+
+void StateValueFilterRateLimit::updateOutputValue(const QVariant &value)
+{
+    m_outputValue = value;
+    m_lastUpdate.start();
+}
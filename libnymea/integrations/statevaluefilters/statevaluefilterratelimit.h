@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public License
+* as published by the Free Software Foundation, either version 3
+* of the License, or (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef STATEVALUEFILTERRATELIMIT_H
+#define STATEVALUEFILTERRATELIMIT_H
+
+#include "statevaluefilter.h"
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+class StateValueFilterRateLimit : public QObject, public StateValueFilter
+{
+    Q_OBJECT
+public:
+    explicit StateValueFilterRateLimit(int minInterval = 5000, QObject *parent = nullptr);
+
+    void addValue(const QVariant &value) override;
+    QVariant filteredValue() const override;
+
+signals:
+    // Emitted when a value held back during the interval is applied once the interval expired
+    void filteredValueChanged(const QVariant &value);
+
+private:
+    // Minimum time between two changes of the output value. Changes to and from 0 are always passed through.
+    int m_minInterval = 5000;
+
+    QElapsedTimer m_lastUpdate;
+    QTimer m_trailingTimer;
+    QVariant m_outputValue;
+    QVariant m_pendingValue;
+
+    void updateOutputValue(const QVariant &value);
+};
+
+#endif // STATEVALUEFILTERRATELIMIT_H
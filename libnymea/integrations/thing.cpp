@@ -127,6 +127,9 @@
 #include "thing.h"
 #include "loggingcategories.h"
 #include "statevaluefilters/statevaluefilteradaptive.h"
+#include "statevaluefilters/statevaluefilterdeadband.h"
+#include "statevaluefilters/statevaluefilterexponential.h"
+#include "statevaluefilters/statevaluefilterratelimit.h"
 #include "thingutils.h"
 #include "types/event.h"
 
@@ -875,9 +878,47 @@ void Thing::setStateValueFilter(const StateTypeId &stateTypeId, Types::StateValu
             if (stateValueFilter) {
                 delete stateValueFilter;
             }
-            if (filter == Types::StateValueFilterAdaptive) {
+            switch (filter) {
+            case Types::StateValueFilterNone:
+                break;
+            case Types::StateValueFilterAdaptive:
                 m_stateValueFilters.insert(stateTypeId, new StateValueFilterAdaptive());
+                break;
+            case Types::StateValueFilterExponential:
+                m_stateValueFilters.insert(stateTypeId, new StateValueFilterExponential());
+                break;
+            case Types::StateValueFilterDeadband:
+                m_stateValueFilters.insert(stateTypeId, new StateValueFilterDeadband());
+                break;
+            case Types::StateValueFilterRateLimit: {
+                StateValueFilterRateLimit *rateLimitFilter = new StateValueFilterRateLimit();
+                // Values held back during the interval are delivered once it expired
+                connect(rateLimitFilter, &StateValueFilterRateLimit::filteredValueChanged, this, [this, stateTypeId](const QVariant &value){
+                    applyFilteredStateValue(stateTypeId, value);
+                });
+                m_stateValueFilters.insert(stateTypeId, rateLimitFilter);
+                break;
             }
+            }
+        }
+    }
+}
+
+void Thing::applyFilteredStateValue(const StateTypeId &stateTypeId, const QVariant &value)
+{
+    StateType stateType = m_thingClass.stateTypes().findById(stateTypeId);
+    for (int i = 0; i < m_states.count(); ++i) {
+        if (m_states.at(i).stateTypeId() == stateTypeId) {
+            QVariant newValue = value;
+            newValue.convert(stateType.type());
+            if (m_states.at(i).value() == newValue) {
+                return;
+            }
+
+            qCDebug(dcThing()).nospace() << this << ": State " << stateType.name() << " changed from " << m_states.at(i).value() << " to " << newValue << " (filtered)";
+            m_states[i].setValue(newValue);
+            emit stateValueChanged(stateTypeId, newValue, m_states.at(i).minValue(), m_states.at(i).maxValue(), m_states.at(i).possibleValues());
+            return;
         }
     }
 }
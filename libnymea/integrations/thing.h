@@ -186,6 +186,7 @@ private:
     void setLoggedEventTypeIds(const QList<EventTypeId> loggedEventTypeIds);
     void setLoggedActionTypeIds(const QList<ActionTypeId> loggedActionTypeIds);
     void setStateValueFilter(const StateTypeId &stateTypeId, Types::StateValueFilter filter);
+    void applyFilteredStateValue(const StateTypeId &stateTypeId, const QVariant &value);
 
 private:
     ThingClass m_thingClass;
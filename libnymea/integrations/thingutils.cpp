@@ -27,9 +27,11 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonParseError>
 #include <QMetaEnum>
+#include <QSet>
 #include <qmath.h>
 
 namespace {
@@ -204,41 +206,91 @@ Thing::ThingError ThingUtils::verifyParam(const ParamType &paramType, const Para
     return Thing::ThingErrorNoError;
 }
 
-Interfaces ThingUtils::allInterfaces()
+namespace {
+
+// Interface definitions are compiled into libnymea and never change at runtime. They are parsed
+// and resolved (including all extended parents) exactly once, on first use, and shared afterwards.
+class InterfaceRegistry
+{
+public:
+    static const InterfaceRegistry &instance();
+
+    Interfaces allInterfaces() const { return m_allInterfaces; }
+    bool contains(const QString &name) const { return m_interfaces.contains(name); }
+    Interface interface(const QString &name) const { return m_interfaces.value(name); }
+    QStringList parentList(const QString &name) const { return m_parentLists.value(name); }
+
+private:
+    InterfaceRegistry();
+    void resolve(const QString &name);
+
+    QHash<QString, Interface> m_interfaces;
+    QHash<QString, QStringList> m_parentLists;
+    QSet<QString> m_resolving;
+    Interfaces m_allInterfaces;
+};
+
+const InterfaceRegistry &InterfaceRegistry::instance()
+{
+    // Thread safe lazy initialization
+    static const InterfaceRegistry registry;
+    return registry;
+}
+
+InterfaceRegistry::InterfaceRegistry()
 {
-    Interfaces ret;
     QDir dir(":/interfaces/");
     foreach (const QFileInfo &ifaceFile, dir.entryInfoList()) {
-        ret.append(loadInterface(ifaceFile.baseName()));
+        resolve(ifaceFile.baseName());
+        if (m_interfaces.contains(ifaceFile.baseName())) {
+            m_allInterfaces.append(m_interfaces.value(ifaceFile.baseName()));
+        }
     }
-    return ret;
+    qCDebug(dcThingManager()) << "Loaded" << m_interfaces.count() << "interface definitions";
 }
 
-Interface ThingUtils::loadInterface(const QString &name)
+void InterfaceRegistry::resolve(const QString &name)
 {
-    Interface iface;
+    if (m_interfaces.contains(name) || m_resolving.contains(name)) {
+        return;
+    }
+
     QFile f(QString(":/interfaces/%1.json").arg(name));
     if (!f.open(QFile::ReadOnly)) {
         qCWarning(dcThingManager()) << "Failed to load interface" << name;
-        return iface;
+        return;
     }
     QJsonParseError error;
     QJsonDocument jsonDoc = QJsonDocument::fromJson(f.readAll(), &error);
     if (error.error != QJsonParseError::NoError) {
         qCWarning(dcThingManager()) << "Cannot load interface definition for interface" << name << ":" << error.errorString();
-        return iface;
+        return;
     }
+
+    m_resolving.insert(name);
+
+    Interface iface;
+    QStringList parents = {name};
     QVariantMap content = jsonDoc.toVariant().toMap();
+    QStringList extends;
     if (content.contains("extends")) {
         if (!content.value("extends").toString().isEmpty()) {
-            iface = loadInterface(content.value("extends").toString());
+            extends.append(content.value("extends").toString());
         } else if (content.value("extends").toList().count() > 0) {
             foreach (const QVariant &extendedIface, content.value("extends").toList()) {
-                Interface tmp = loadInterface(extendedIface.toString());
-                iface = mergeInterfaces(iface, tmp);
+                extends.append(extendedIface.toString());
             }
         }
     }
+    foreach (const QString &extendedIface, extends) {
+        resolve(extendedIface);
+        if (m_resolving.contains(extendedIface)) {
+            qCWarning(dcThingManager()) << "Interface" << name << "extends" << extendedIface << "recursively. Ignoring the cycle.";
+            continue;
+        }
+        iface = ThingUtils::mergeInterfaces(iface, m_interfaces.value(extendedIface));
+        parents.append(m_parentLists.value(extendedIface));
+    }
 
     InterfaceParamTypes paramTypes;
     InterfaceStateTypes stateTypes;
@@ -398,7 +450,26 @@ Interface ThingUtils::loadInterface(const QString &name)
         eventTypes.append(eventType);
     }
 
-    return Interface(name, iface.paramTypes() << paramTypes, iface.actionTypes() << actionTypes, iface.eventTypes() << eventTypes, iface.stateTypes() << stateTypes);
+    m_interfaces.insert(name, Interface(name, iface.paramTypes() << paramTypes, iface.actionTypes() << actionTypes, iface.eventTypes() << eventTypes, iface.stateTypes() << stateTypes));
+    m_parentLists.insert(name, parents);
+    m_resolving.remove(name);
+}
+
+}
+
+Interfaces ThingUtils::allInterfaces()
+{
+    return InterfaceRegistry::instance().allInterfaces();
+}
+
+Interface ThingUtils::loadInterface(const QString &name)
+{
+    const InterfaceRegistry &registry = InterfaceRegistry::instance();
+    if (!registry.contains(name)) {
+        qCWarning(dcThingManager()) << "Failed to load interface" << name;
+        return Interface();
+    }
+    return registry.interface(name);
 }
 
 Interface ThingUtils::mergeInterfaces(const Interface &iface1, const Interface &iface2)
@@ -432,29 +503,12 @@ Interface ThingUtils::mergeInterfaces(const Interface &iface1, const Interface &
 
 QStringList ThingUtils::generateInterfaceParentList(const QString &interface)
 {
-    QFile f(QString(":/interfaces/%1.json").arg(interface));
-    if (!f.open(QFile::ReadOnly)) {
+    const InterfaceRegistry &registry = InterfaceRegistry::instance();
+    if (!registry.contains(interface)) {
         qCWarning(dcThingManager()) << "Failed to load interface" << interface;
         return QStringList();
     }
-    QJsonParseError error;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(f.readAll(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        qCWarning(dcThingManager()) << "Cannot load interface definition for interface" << interface << ":" << error.errorString();
-        return QStringList();
-    }
-    QStringList ret = {interface};
-    QVariantMap content = jsonDoc.toVariant().toMap();
-    if (content.contains("extends")) {
-        if (!content.value("extends").toString().isEmpty()) {
-            ret << generateInterfaceParentList(content.value("extends").toString());
-        } else if (content.value("extends").toList().count() > 0) {
-            foreach (const QVariant &extendedIface, content.value("extends").toList()) {
-                ret << generateInterfaceParentList(extendedIface.toString());
-            }
-        }
-    }
-    return ret;
+    return registry.parentList(interface);
 }
 
 QVariant ThingUtils::ensureValueClamping(const QVariant value, QMetaType::Type type, const QVariant &minValue, const QVariant &maxValue, double stepSize)
@@ -49,6 +49,11 @@ HEADERS += \
     integrations/thingsetupinfo.h \
     integrations/thingutils.h \
     integrations/servicedata.h \
+    integrations/statevaluefilters/statevaluefilter.h \
+    integrations/statevaluefilters/statevaluefilteradaptive.h \
+    integrations/statevaluefilters/statevaluefilterdeadband.h \
+    integrations/statevaluefilters/statevaluefilterexponential.h \
+    integrations/statevaluefilters/statevaluefilterratelimit.h \
     jsonrpc/jsoncontext.h \
     jsonrpc/jsonhandler.h \
     jsonrpc/jsonreply.h \
@@ -172,6 +177,9 @@ SOURCES += \
     integrations/servicedata.cpp \
     integrations/statevaluefilters/statevaluefilter.cpp \
     integrations/statevaluefilters/statevaluefilteradaptive.cpp \
+    integrations/statevaluefilters/statevaluefilterdeadband.cpp \
+    integrations/statevaluefilters/statevaluefilterexponential.cpp \
+    integrations/statevaluefilters/statevaluefilterratelimit.cpp \
     jsonrpc/jsoncontext.cpp \
     jsonrpc/jsonhandler.cpp \
     jsonrpc/jsonreply.cpp \
@@ -41,7 +41,8 @@ LogEntries LogFetchJob::entries() const
 void LogFetchJob::finish(const LogEntries &entries)
 {
     m_entries = entries;
-    emit finished(entries);
+    // Always queued so that callers can connect after fetchLogEntries() returned, even if the
+    // engine finished synchronously. Emitting only once prevents consumers from handling a result twice.
     QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection, Q_ARG(LogEntries, entries));
 }
 
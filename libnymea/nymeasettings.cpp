@@ -71,11 +71,254 @@
 #include <unistd.h>
 
 #include <QDir>
+#include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
 #include <QDebug>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QSettings>
 #include <QCoreApplication>
 
+namespace {
+
+// The parsed content of one settings file, shared by all NymeaSettings instances using that file
+class SettingsFile
+{
+public:
+    QString filePath;
+    QMap<QString, QVariant> values;
+    bool dirty = false;
+
+    // State of the file on disk as we've last seen it, to detect changes made by others
+    bool exists = false;
+    qint64 size = 0;
+    QDateTime lastModified;
+
+    int parses = 0;
+    int flushes = 0;
+    qint64 bytesWritten = 0;
+
+    bool persistent() const
+    {
+        return !QFileInfo(filePath).isDir();
+    }
+
+    void updateFileState()
+    {
+        QFileInfo fileInfo(filePath);
+        exists = fileInfo.exists();
+        size = fileInfo.size();
+        lastModified = fileInfo.lastModified();
+    }
+
+    bool changedOnDisk() const
+    {
+        QFileInfo fileInfo(filePath);
+        return fileInfo.exists() != exists || fileInfo.size() != size || fileInfo.lastModified() != lastModified;
+    }
+
+    void load()
+    {
+        values.clear();
+        dirty = false;
+        if (persistent()) {
+            QSettings settings(filePath, QSettings::IniFormat);
+            foreach (const QString &key, settings.allKeys()) {
+                values.insert(key, settings.value(key));
+            }
+            parses++;
+        }
+        updateFileState();
+        qCDebug(dcSystem()) << "Loaded" << values.count() << "settings from" << filePath << "( parses:" << parses << ")";
+    }
+
+    // Returns false if the pending changes could not be written and are still to be saved
+    bool flush()
+    {
+        if (!dirty) {
+            return true;
+        }
+        if (!persistent()) {
+            dirty = false;
+            return true;
+        }
+
+        // QSettings replaces the file atomically and keeps its permissions
+        QSettings settings(filePath, QSettings::IniFormat);
+        settings.clear();
+        for (QMap<QString, QVariant>::const_iterator it = values.constBegin(); it != values.constEnd(); ++it) {
+            settings.setValue(it.key(), it.value());
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qCWarning(dcSystem()) << "Failed to write settings to" << filePath << settings.status();
+            return false;
+        }
+
+        dirty = false;
+        flushes++;
+        updateFileState();
+        bytesWritten += size;
+        qCDebug(dcSystem()) << "Saved" << values.count() << "settings to" << filePath << "( flushes:" << flushes << "bytes written:" << bytesWritten << ")";
+        return true;
+    }
+};
+
+// Process wide registry of settings files. Files are parsed once and served from memory,
+// changes are collected and written to disk at most once a second.
+class SettingsStore
+{
+public:
+    static SettingsStore *instance()
+    {
+        // Intentionally never deleted, pending changes are written when the application quits
+        static SettingsStore *store = new SettingsStore();
+        return store;
+    }
+
+    QMutex *mutex()
+    {
+        return &m_mutex;
+    }
+
+    // Must be called with the mutex locked
+    SettingsFile *file(const QString &settingsFilePath)
+    {
+        SettingsFile *settingsFile = m_files.value(settingsFilePath);
+        if (!settingsFile) {
+            settingsFile = new SettingsFile();
+            settingsFile->filePath = NymeaSettings::privodeFromDefaultFilePath(settingsFilePath);
+            settingsFile->load();
+            m_files.insert(settingsFilePath, settingsFile);
+        } else if (settingsFile->changedOnDisk()) {
+            if (settingsFile->dirty) {
+                qCWarning(dcSystem()) << "Settings file" << settingsFile->filePath << "has been modified by someone else. Overwriting it with pending changes.";
+            } else {
+                settingsFile->filePath = NymeaSettings::privodeFromDefaultFilePath(settingsFilePath);
+                settingsFile->load();
+            }
+        }
+        return settingsFile;
+    }
+
+    // Must be called with the mutex locked
+    void setDirty(SettingsFile *settingsFile)
+    {
+        settingsFile->dirty = true;
+        scheduleFlush();
+    }
+
+    // Must be called with the mutex locked
+    void flush(SettingsFile *settingsFile)
+    {
+        if (!settingsFile->flush()) {
+            // Keep the changes in memory and try again later
+            scheduleFlush();
+        }
+    }
+
+    void flushAll()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_flushScheduled = false;
+        foreach (SettingsFile *settingsFile, m_files) {
+            flush(settingsFile);
+        }
+    }
+
+private:
+    SettingsStore()
+    {
+        m_flushTimer = new QTimer();
+        m_flushTimer->setInterval(1000);
+        m_flushTimer->setSingleShot(true);
+        m_flushTimer->moveToThread(QCoreApplication::instance()->thread());
+        QObject::connect(m_flushTimer, &QTimer::timeout, [this](){ flushAll(); });
+        qAddPostRoutine([](){ SettingsStore::instance()->flushAll(); });
+    }
+
+    void scheduleFlush()
+    {
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(m_flushTimer, "start", Qt::QueuedConnection);
+        }
+    }
+
+    QMutex m_mutex;
+    QHash<QString, SettingsFile*> m_files;
+    QTimer *m_flushTimer = nullptr;
+    bool m_flushScheduled = false;
+};
+
+// Like QSettings: no leading, trailing or duplicate slashes
+QString normalizedKey(const QString &key)
+{
+    QString result;
+    result.reserve(key.length());
+    for (int i = 0; i < key.length(); i++) {
+        if (key.at(i) == '/' && (result.isEmpty() || result.endsWith('/'))) {
+            continue;
+        }
+        result.append(key.at(i));
+    }
+    if (result.endsWith('/')) {
+        result.chop(1);
+    }
+    return result;
+}
+
+QString joinedKey(const QString &group, const QString &key)
+{
+    if (group.isEmpty()) {
+        return key;
+    }
+    if (key.isEmpty()) {
+        return group;
+    }
+    return group + '/' + key;
+}
+
+}
+
+class NymeaSettingsPrivate
+{
+public:
+    class Group {
+    public:
+        QString name;
+        QString arrayName;
+        bool isArray = false;
+        bool isWriteArray = false;
+        int maxArrayIndex = -1;
+    };
+
+    SettingsFile *file = nullptr;
+    QList<Group> groups;
+
+    QString group() const
+    {
+        return groups.isEmpty() ? QString() : groups.last().name;
+    }
+
+    QString key(const QString &key) const
+    {
+        return joinedKey(group(), normalizedKey(key));
+    }
+
+    // Iterates over all keys within the current group
+    template <typename F>
+    void forEachKey(F function) const
+    {
+        QString prefix = group().isEmpty() ? QString() : group() + '/';
+        for (QMap<QString, QVariant>::const_iterator it = file->values.lowerBound(prefix); it != file->values.constEnd() && it.key().startsWith(prefix); ++it) {
+            function(it.key().mid(prefix.length()));
+        }
+    }
+};
+
 /*! Constructs a \l{NymeaSettings} instance with the given \a role and \a parent. */
 NymeaSettings::NymeaSettings(const SettingsRole &role, QObject *parent)
     : QObject(parent)
@@ -128,7 +371,9 @@ NymeaSettings::NymeaSettings(const SettingsRole &role, QObject *parent)
     }
 
     const QString settingsFilePath = NymeaSettings::settingsPath() + QDir::separator() + m_fileName;
-    m_settings = new QSettings(NymeaSettings::privodeFromDefaultFilePath(settingsFilePath), QSettings::IniFormat);
+    d = new NymeaSettingsPrivate();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    d->file = SettingsStore::instance()->file(settingsFilePath);
 }
 
 /*! Constructs a \l{NymeaSettings} instance with the given \a fileName and \a parent. Use this constructor for custom files which could provide
@@ -138,17 +383,16 @@ NymeaSettings::NymeaSettings(const QString &fileName, QObject *parent)
     , m_fileName(fileName)
 {
     const QString settingsFilePath = NymeaSettings::settingsPath() + QDir::separator() + m_fileName;
-    m_settings = new QSettings(NymeaSettings::privodeFromDefaultFilePath(settingsFilePath), QSettings::IniFormat);
+    d = new NymeaSettingsPrivate();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    d->file = SettingsStore::instance()->file(settingsFilePath);
 }
 
-/*! Destructor of the NymeaSettings.*/
+/*! Destructor of the NymeaSettings. Changes are written to disk shortly after, see \l{sync()}.*/
 NymeaSettings::~NymeaSettings()
 {
-    if (m_settings) {
-        m_settings->sync();
-        delete m_settings;
-        m_settings = nullptr;
-    }
+    delete d;
+    d = nullptr;
 }
 
 QString NymeaSettings::privodeFromDefaultFilePath(const QString &filePath)
@@ -202,6 +446,12 @@ bool NymeaSettings::isRoot()
     return true;
 }
 
+/*! Writes the pending changes of all settings files to disk. Call this before accessing settings files directly. */
+void NymeaSettings::syncAll()
+{
+    SettingsStore::instance()->flushAll();
+}
+
 /*! Returns the path to the folder where the NymeaSettings will be saved i.e. \tt{/var/lib/nymea}. */
 QString NymeaSettings::settingsPath()
 {
@@ -296,108 +546,195 @@ QString NymeaSettings::cachePath()
 /*! Return a list of all settings keys.*/
 QStringList NymeaSettings::allKeys() const
 {
-    return m_settings->allKeys();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    QStringList keys;
+    d->forEachKey([&keys](const QString &key) {
+        keys.append(key);
+    });
+    return keys;
 }
 
 /*! Adds \a prefix to the current group and starts writing an array of size size. If size is -1 (the default),
  * it is automatically determined based on the indexes of the entries written. */
 void NymeaSettings::beginWriteArray(const QString &prefix)
 {
-    m_settings->beginWriteArray(prefix);
+    NymeaSettingsPrivate::Group group;
+    group.arrayName = d->key(prefix);
+    group.name = group.arrayName;
+    group.isArray = true;
+    group.isWriteArray = true;
+    d->groups.append(group);
+
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    if (d->file->values.remove(group.arrayName + "/size") > 0) {
+        SettingsStore::instance()->setDirty(d->file);
+    }
 }
 
 /*! Sets the current array index to \a i. */
 void NymeaSettings::setArrayIndex(int i)
 {
-    m_settings->setArrayIndex(i);
+    if (d->groups.isEmpty() || !d->groups.last().isArray) {
+        qCWarning(dcSystem()) << "NymeaSettings::setArrayIndex: Missing beginArray()";
+        return;
+    }
+    NymeaSettingsPrivate::Group &group = d->groups.last();
+    group.name = group.arrayName + '/' + QString::number(qMax(i, 0) + 1);
+    group.maxArrayIndex = qMax(group.maxArrayIndex, i);
 }
 
 /*! Adds \a prefix to the current group and starts reading from an array. Returns the size of the array.*/
 int NymeaSettings::beginReadArray(const QString &prefix)
 {
-    return m_settings->beginReadArray(prefix);
+    NymeaSettingsPrivate::Group group;
+    group.arrayName = d->key(prefix);
+    group.name = group.arrayName;
+    group.isArray = true;
+    d->groups.append(group);
+
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    return d->file->values.value(group.arrayName + "/size").toInt();
 }
 
 /*! End an array. */
 void NymeaSettings::endArray()
 {
-    m_settings->endArray();
+    if (d->groups.isEmpty() || !d->groups.last().isArray) {
+        qCWarning(dcSystem()) << "NymeaSettings::endArray: Expected endGroup() instead";
+        return;
+    }
+    NymeaSettingsPrivate::Group group = d->groups.takeLast();
+    if (group.isWriteArray && group.maxArrayIndex >= 0) {
+        QMutexLocker locker(SettingsStore::instance()->mutex());
+        d->file->values.insert(group.arrayName + "/size", group.maxArrayIndex + 1);
+        SettingsStore::instance()->setDirty(d->file);
+    }
 }
 
 /*! Begins a new group with the given \a prefix.*/
 void NymeaSettings::beginGroup(const QString &prefix)
 {
-    m_settings->beginGroup(prefix);
+    NymeaSettingsPrivate::Group group;
+    group.name = d->key(prefix);
+    d->groups.append(group);
 }
 
 /*! Returns a list of all key top-level groups that contain keys that can be read
  *  using the \l{NymeaSettings} object.*/
 QStringList NymeaSettings::childGroups() const
 {
-    return m_settings->childGroups();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    QStringList groups;
+    d->forEachKey([&groups](const QString &key) {
+        int separatorIndex = key.indexOf('/');
+        // Keys are sorted, all keys of a group follow each other
+        if (separatorIndex > 0 && (groups.isEmpty() || groups.last() != key.left(separatorIndex))) {
+            groups.append(key.left(separatorIndex));
+        }
+    });
+    return groups;
 }
 
 /*! Returns a list of all top-level keys that can be read using the \l{NymeaSettings} object.*/
 QStringList NymeaSettings::childKeys() const
 {
-    return m_settings->childKeys();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    QStringList keys;
+    d->forEachKey([&keys](const QString &key) {
+        if (!key.contains('/')) {
+            keys.append(key);
+        }
+    });
+    return keys;
 }
 
 /*! Removes all entries in the primary location associated to this \l{NymeaSettings} object.*/
 void NymeaSettings::clear()
 {
-    m_settings->clear();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    d->file->values.clear();
+    SettingsStore::instance()->setDirty(d->file);
 }
 
 /*! Returns true if there exists a setting called \a key; returns false otherwise. */
 bool NymeaSettings::contains(const QString &key) const
 {
-    return m_settings->contains(key);
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    return d->file->values.contains(d->key(key));
 }
 
 /*! Resets the group to what it was before the corresponding beginGroup() call. */
 void NymeaSettings::endGroup()
 {
-    m_settings->endGroup();
+    if (d->groups.isEmpty() || d->groups.last().isArray) {
+        qCWarning(dcSystem()) << "NymeaSettings::endGroup: No matching beginGroup()";
+        return;
+    }
+    d->groups.removeLast();
 }
 
 /*! Returns the current group. */
 QString NymeaSettings::group() const
 {
-    return m_settings->group();
+    return d->group();
 }
 
 /*! Returns the path where settings written using this \l{NymeaSettings} object are stored. */
 QString NymeaSettings::fileName() const
 {
-    return m_settings->fileName();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    return d->file->filePath;
 }
 
 /*! Returns true if settings can be written using this \l{NymeaSettings} object; returns false otherwise. */
 bool NymeaSettings::isWritable() const
 {
-    return m_settings->isWritable();
+    QFileInfo fileInfo(fileName());
+    return fileInfo.exists() ? fileInfo.isWritable() : QFileInfo(fileInfo.absolutePath()).isWritable();
 }
 
 /*! Removes the setting key and any sub-settings of \a key. */
 void NymeaSettings::remove(const QString &key)
 {
-    m_settings->remove(key);
+    QString fullKey = d->key(key);
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    if (fullKey.isEmpty()) {
+        d->file->values.clear();
+    } else {
+        d->file->values.remove(fullKey);
+        QString prefix = fullKey + '/';
+        QMap<QString, QVariant>::iterator it = d->file->values.lowerBound(prefix);
+        while (it != d->file->values.end() && it.key().startsWith(prefix)) {
+            it = d->file->values.erase(it);
+        }
+    }
+    SettingsStore::instance()->setDirty(d->file);
 }
 
 /*! Sets the \a value of setting \a key to value. If the \a key already exists, the previous value is overwritten. */
 void NymeaSettings::setValue(const QString &key, const QVariant &value)
 {
-    m_settings->setValue(key, value);
+    QString fullKey = d->key(key);
+    if (fullKey.isEmpty()) {
+        qCWarning(dcSystem()) << "NymeaSettings::setValue: Empty key passed";
+        return;
+    }
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    d->file->values.insert(fullKey, value);
+    SettingsStore::instance()->setDirty(d->file);
 }
 
+/*! Writes pending changes of this settings file to disk immediately. Otherwise changes are written
+ *  shortly after they have been made, collecting all changes made in the meantime. */
 void NymeaSettings::sync()
 {
-    m_settings->sync();
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    SettingsStore::instance()->flush(d->file);
 }
 
 /*! Returns the value for setting \a key. If the setting doesn't exist, returns \a defaultValue. */
 QVariant NymeaSettings::value(const QString &key, const QVariant &defaultValue) const
 {
-    return m_settings->value(key, defaultValue);
+    QMutexLocker locker(SettingsStore::instance()->mutex());
+    return d->file->values.value(d->key(key), defaultValue);
 }
@@ -30,7 +30,7 @@
 
 #include "libnymea.h"
 
-class QSettings;
+class NymeaSettingsPrivate;
 
 class LIBNYMEA_EXPORT NymeaSettings : public QObject
 {
@@ -62,6 +62,9 @@ public:
 
     static bool isRoot();
 
+    // Writes all pending changes of all settings files to disk
+    static void syncAll();
+
     static QString settingsPath();
     static QString defaultSettingsPath();
     static QString translationsPath();
@@ -91,7 +94,7 @@ public:
     QVariant value(const QString & key, const QVariant & defaultValue = QVariant()) const;
 
 private:
-    QSettings *m_settings = nullptr;
+    NymeaSettingsPrivate *d = nullptr;
     SettingsRole m_role = SettingsRoleNone;
     QString m_fileName;
 
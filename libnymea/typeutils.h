@@ -194,7 +194,10 @@ public:
 
     enum StateValueFilter {
         StateValueFilterNone,
-        StateValueFilterAdaptive
+        StateValueFilterAdaptive,
+        StateValueFilterExponential,
+        StateValueFilterDeadband,
+        StateValueFilterRateLimit
     };
     Q_ENUM(StateValueFilter)
 
@@ -142,6 +142,7 @@
 #include <QDateTime>
 #include <QPair>
 #include <QDebug>
+#include <QFileInfo>
 
 HttpReply::HttpReply(QObject *parent) :
     QObject(parent),
@@ -273,6 +274,26 @@ QByteArray HttpReply::payload() const
     return m_payload;
 }
 
+/*! Sets the payload of this \l{HttpReply} to the content of the file with the given \a fileName.
+    The file will not be loaded into memory but streamed to the client by the web server.
+    Only the header will be contained in \l{data()}.
+*/
+void HttpReply::setPayloadFile(const QString &fileName)
+{
+    m_payload.clear();
+    m_payloadFile = fileName;
+    setHeader(HttpHeaderType::ContentLenghtHeader, QByteArray::number(QFileInfo(fileName).size()));
+    packReply();
+}
+
+/*! Returns the name of the file to be sent as payload of this \l{HttpReply}. If the payload
+    is not file based, an empty string will be returned.
+*/
+QString HttpReply::payloadFile() const
+{
+    return m_payloadFile;
+}
+
 /*! This method appends a raw header to the header list of this \l{HttpReply}.
     The Header will be set to \a headerType : \a value.
 */
@@ -328,7 +349,7 @@ bool HttpReply::closeConnection() const
 /*! Returns true if the raw header and the payload of this \l{HttpReply} is empty.*/
 bool HttpReply::isEmpty() const
 {
-    return m_rawHeader.isEmpty() && m_payload.isEmpty() && m_rawHeaderList.isEmpty();
+    return m_rawHeader.isEmpty() && m_payload.isEmpty() && m_payloadFile.isEmpty() && m_rawHeaderList.isEmpty();
 }
 
 /*! Clears all data of this \l{HttpReply}. */
@@ -339,6 +360,7 @@ void HttpReply::clear()
     m_statusCode = Ok;
     m_rawHeader.clear();
     m_payload.clear();
+    m_payloadFile.clear();
     m_rawHeaderList.clear();
 }
 /*! Packs the whole reply data of this \l{HttpReply}. The data can be accessed with \l{HttpReply::data()}.
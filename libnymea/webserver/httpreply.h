@@ -100,6 +100,9 @@ public:
     void setPayload(const QByteArray &data);
     QByteArray payload() const;
 
+    void setPayloadFile(const QString &fileName);
+    QString payloadFile() const;
+
     void setRawHeader(const QByteArray headerType, const QByteArray &value);
     void setHeader(const HttpHeaderType &headerType, const QByteArray &value);
     QHash<QByteArray, QByteArray> rawHeaderList() const;
@@ -125,6 +128,7 @@ private:
 
     QByteArray m_rawHeader;
     QByteArray m_payload;
+    QString m_payloadFile;
     QByteArray m_data;
 
     QHash<QByteArray, QByteArray> m_rawHeaderList;
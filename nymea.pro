@@ -11,10 +11,10 @@ isEmpty(NYMEA_VERSION) {
 
 # define protocol versions
 JSON_PROTOCOL_VERSION_MAJOR=9
-JSON_PROTOCOL_VERSION_MINOR=0
+JSON_PROTOCOL_VERSION_MINOR=8
 JSON_PROTOCOL_VERSION="$${JSON_PROTOCOL_VERSION_MAJOR}.$${JSON_PROTOCOL_VERSION_MINOR}"
 LIBNYMEA_API_VERSION_MAJOR=9
-LIBNYMEA_API_VERSION_MINOR=1
+LIBNYMEA_API_VERSION_MINOR=4
 LIBNYMEA_API_VERSION_PATCH=0
 LIBNYMEA_API_VERSION="$${LIBNYMEA_API_VERSION_MAJOR}.$${LIBNYMEA_API_VERSION_MINOR}.$${LIBNYMEA_API_VERSION_PATCH}"
 
@@ -8,12 +8,14 @@ SUBDIRS = \
         jsonrpc \
         logging \
         macaddress \
+        modbusrtu \
         mqttbroker \
         plugins \
         pythonplugins \
         transfers \
         rules \
         scripts \
+        statevaluefilters \
         tags \
         timemanager \
         userloading \
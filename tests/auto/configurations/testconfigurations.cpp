@@ -33,6 +33,7 @@
 #include <QHostAddress>
 #include <QRegularExpression>
 #include <QScopedPointer>
+#include <QSettings>
 #include <QTemporaryDir>
 #include <QTime>
 #include <QWebSocket>
@@ -74,6 +75,7 @@ private slots:
 
     void testDisableInsecureInterfacesEnv();
     void testConfigurationMigrationFromDefaultPath();
+    void testSharedSettingsFiles();
 
 private:
     QVariantMap loadBasicConfiguration();
@@ -362,6 +364,90 @@ void TestConfigurations::testConfigurationMigrationFromDefaultPath()
     }
 }
 
+void TestConfigurations::testSharedSettingsFiles()
+{
+    const QString fileName = NymeaSettings::settingsPath() + "/testsharedsettings.conf";
+    QFile::remove(fileName);
+
+    {
+        NymeaSettings settings("testsharedsettings.conf");
+        settings.beginGroup("Things");
+        settings.beginGroup("thing1");
+        settings.setValue("name", "first");
+        settings.endGroup();
+        settings.beginGroup("thing2");
+        settings.setValue("name", "second");
+        settings.endGroup();
+        settings.endGroup();
+
+        settings.beginWriteArray("list");
+        settings.setArrayIndex(0);
+        settings.setValue("value", 1);
+        settings.setArrayIndex(1);
+        settings.setValue("value", 2);
+        settings.endArray();
+    }
+
+    // Changes are visible to other instances right away
+    {
+        NymeaSettings settings("testsharedsettings.conf");
+        QCOMPARE(settings.childGroups(), QStringList({"Things", "list"}));
+        settings.beginGroup("Things");
+        QCOMPARE(settings.childGroups(), QStringList({"thing1", "thing2"}));
+        QCOMPARE(settings.value("thing2/name").toString(), QString("second"));
+        settings.endGroup();
+
+        QCOMPARE(settings.beginReadArray("list"), 2);
+        settings.setArrayIndex(1);
+        QCOMPARE(settings.childKeys(), QStringList({"value"}));
+        QCOMPARE(settings.value("value").toInt(), 2);
+        settings.endArray();
+
+        settings.sync();
+    }
+
+    // sync() writes the file
+    {
+        QSettings settings(fileName, QSettings::IniFormat);
+        QCOMPARE(settings.value("Things/thing1/name").toString(), QString("first"));
+        QCOMPARE(settings.value("list/size").toInt(), 2);
+    }
+
+    // Files changed by others are loaded again
+    {
+        QSettings settings(fileName, QSettings::IniFormat);
+        settings.setValue("Things/thing1/name", "changed by someone else");
+        settings.sync();
+    }
+    {
+        NymeaSettings settings("testsharedsettings.conf");
+        QCOMPARE(settings.value("Things/thing1/name").toString(), QString("changed by someone else"));
+
+        settings.remove("Things");
+        QCOMPARE(settings.childGroups(), QStringList({"list"}));
+        QVERIFY(!settings.contains("Things/thing2/name"));
+    }
+
+    NymeaSettings::syncAll();
+    {
+        QSettings settings(fileName, QSettings::IniFormat);
+        QCOMPARE(settings.childGroups(), QStringList({"list"}));
+    }
+
+    // Writing keeps restricted permissions of the file
+    QVERIFY(QFile::setPermissions(fileName, QFile::ReadOwner | QFile::WriteOwner));
+    {
+        NymeaSettings settings("testsharedsettings.conf");
+        settings.setValue("secret", "value");
+    }
+    NymeaSettings::syncAll();
+    QSettings settings(fileName, QSettings::IniFormat);
+    QCOMPARE(settings.value("secret").toString(), QString("value"));
+    const QFile::Permissions permissions = QFile::permissions(fileName);
+    QVERIFY(permissions.testFlag(QFile::ReadOwner) && permissions.testFlag(QFile::WriteOwner));
+    QVERIFY(!permissions.testFlag(QFile::ReadGroup) && !permissions.testFlag(QFile::ReadOther));
+}
+
 void TestConfigurations::testBackupRetentionKeepsCreatedArchive()
 {
     QTemporaryDir sourceDirectory;
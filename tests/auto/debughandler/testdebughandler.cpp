@@ -36,6 +36,8 @@ protected slots:
 private slots:
     void getLoggingFilters();
 
+    void getPluginStatistics();
+
 };
 
 void TestDebugHandler::initTestCase()
@@ -60,5 +62,43 @@ void TestDebugHandler::getLoggingFilters()
     }
 }
 
+void TestDebugHandler::getPluginStatistics()
+{
+    QVariant response = injectAndWait("Debug.GetPluginStatistics");
+    QVariantMap params = response.toMap().value("params").toMap();
+    QVERIFY(params.contains("slowCallThreshold"));
+
+    // The mock plugin has been initialized and its things have been set up on startup
+    QVariantMap mockStatistics;
+    foreach (const QVariant &pluginVariant, params.value("pluginStatistics").toList()) {
+        if (pluginVariant.toMap().value("pluginId").toUuid() == mockPluginId) {
+            mockStatistics = pluginVariant.toMap();
+        }
+    }
+    QVERIFY2(!mockStatistics.isEmpty(), "No statistics for the mock plugin.");
+
+    QStringList entryPoints;
+    foreach (const QVariant &entryPointVariant, mockStatistics.value("entryPoints").toList()) {
+        QVariantMap entryPoint = entryPointVariant.toMap();
+        QVERIFY(entryPoint.value("calls").toUInt() > 0);
+        QVERIFY(entryPoint.value("maxTime").toDouble() <= entryPoint.value("totalTime").toDouble());
+        entryPoints.append(entryPoint.value("name").toString());
+    }
+    QVERIFY2(entryPoints.contains("init"), "Plugin init has not been accounted.");
+    QVERIFY2(entryPoints.contains("setupThing"), "Thing setup has not been accounted.");
+
+    // Reset the statistics
+    QVariantMap resetParams;
+    resetParams.insert("reset", true);
+    injectAndWait("Debug.GetPluginStatistics", resetParams);
+
+    response = injectAndWait("Debug.GetPluginStatistics");
+    foreach (const QVariant &pluginVariant, response.toMap().value("params").toMap().value("pluginStatistics").toList()) {
+        foreach (const QVariant &entryPointVariant, pluginVariant.toMap().value("entryPoints").toList()) {
+            QVERIFY2(entryPointVariant.toMap().value("name").toString() != "init", "Statistics have not been reset.");
+        }
+    }
+}
+
 #include "testdebughandler.moc"
 QTEST_MAIN(TestDebugHandler)
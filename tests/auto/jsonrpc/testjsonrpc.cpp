@@ -32,6 +32,10 @@
 #include "nymeadbusservice.h"
 #include "../plugins/mock/extern-plugininfo.h"
 
+#include <QCborValue>
+#include <QElapsedTimer>
+#include <QtEndian>
+
 using namespace nymeaserver;
 
 class TestJSONRPC: public NymeaTestBase
@@ -61,6 +65,8 @@ private slots:
     void testBasicCall_data();
     void testBasicCall();
 
+    void testFragmentedCalls();
+
     void introspect();
 
     void enableDisableNotifications_legacy_data();
@@ -72,8 +78,16 @@ private slots:
 
     void stateChangeEmitsNotifications();
 
+    void stateChangesAreBatched();
+
+    void notificationFilters();
+
     void pluginConfigChangeEmitsNotification();
 
+    void appDataStoreAndLoad();
+
+    void cborEncoding();
+
     /*
     Cases for push button auth:
 
@@ -644,6 +658,33 @@ void TestJSONRPC::testBasicCall()
     }
 }
 
+void TestJSONRPC::testFragmentedCalls()
+{
+    QSignalSpy spy(m_mockTcpServer, &MockTcpServer::outgoingData);
+    QVERIFY(spy.isValid());
+
+    // A call split up in the middle of strings and nested objects
+    m_mockTcpServer->injectData(m_clientId, "{\"id\": 1, \"params\": {}, \"tok");
+    m_mockTcpServer->injectData(m_clientId, "en\": \"" + m_apiToken + "\", \"method\": \"JSONRPC.Vers");
+    QCOMPARE(spy.count(), 0);
+    m_mockTcpServer->injectData(m_clientId, "ion\"}\n");
+
+    // Pipelined calls in a single packet, not separated by a newline
+    m_mockTcpServer->injectData(m_clientId, "{\"id\": 2, \"token\": \"" + m_apiToken + "\", \"method\": \"JSONRPC.Version\"}"
+                                            "{\"id\": 3, \"token\": \"" + m_apiToken + "\", \"method\": \"JSONRPC.Version\"}\n");
+
+    while (spy.count() < 3) {
+        QVERIFY(spy.wait());
+    }
+    QCOMPARE(spy.count(), 3);
+
+    for (int i = 0; i < spy.count(); i++) {
+        QVariantMap response = QJsonDocument::fromJson(spy.at(i).last().toByteArray()).toVariant().toMap();
+        QCOMPARE(response.value("id").toInt(), i + 1);
+        QCOMPARE(response.value("status").toString(), QString("success"));
+    }
+}
+
 void TestJSONRPC::introspect()
 {
     QVariant response = injectAndWait("JSONRPC.Introspect");
@@ -959,6 +1000,159 @@ void TestJSONRPC::stateChangeEmitsNotifications()
     QCOMPARE(response.toMap().value("params").toMap().value("value").toInt(), newVal);
 }
 
+void TestJSONRPC::stateChangesAreBatched()
+{
+    const int batchInterval = 1000;
+
+    // Fetch the current bool state value so it can be toggled below
+    QVariantMap params;
+    params.insert("thingId", m_mockThingId);
+    params.insert("stateTypeId", mockBoolStateTypeId);
+    bool boolValue = injectAndWait("Integrations.GetStateValue", params).toMap().value("params").toMap().value("value").toBool();
+
+    params.clear();
+    params.insert("notificationBatchInterval", batchInterval);
+    QVariantMap handShake = injectAndWait("JSONRPC.Hello", params).toMap();
+    QCOMPARE(handShake.value("params").toMap().value("notificationBatchInterval").toInt(), batchInterval);
+
+    enableNotifications({"Integrations"});
+
+    QNetworkAccessManager nam;
+    QSignalSpy clientSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+
+    // Change the int state a few times in a row and the bool state once
+    QList<QPair<StateTypeId, QVariant>> changes;
+    changes.append(qMakePair(mockIntStateTypeId, QVariant(10)));
+    changes.append(qMakePair(mockIntStateTypeId, QVariant(11)));
+    changes.append(qMakePair(mockBoolStateTypeId, QVariant(!boolValue)));
+    changes.append(qMakePair(mockIntStateTypeId, QVariant(12)));
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (int i = 0; i < changes.count(); i++) {
+        QNetworkRequest request(QUrl(QString("http://localhost:%1/setstate?%2=%3").arg(m_mockThing1Port).arg(changes.at(i).first.toString()).arg(changes.at(i).second.toString())));
+        QNetworkReply *reply = nam.get(request);
+        connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+        QSignalSpy replySpy(reply, &QNetworkReply::finished);
+        if (replySpy.count() == 0) replySpy.wait();
+    }
+    QVERIFY2(elapsed.elapsed() < batchInterval, "Setting the states took longer than the batch interval.");
+
+    // Nothing may be delivered before the batch interval has passed
+    QVERIFY2(checkNotifications(clientSpy, "Integrations.StateChanged").isEmpty(), "Got a single StateChanged notification despite batching.");
+    QVERIFY2(checkNotifications(clientSpy, "Integrations.StatesChanged").isEmpty(), "Got the StatesChanged notification before the batch interval passed.");
+
+    // Wait for the batch to be delivered
+    while (checkNotifications(clientSpy, "Integrations.StatesChanged").isEmpty() && elapsed.elapsed() < 3 * batchInterval) {
+        clientSpy.wait(batchInterval);
+    }
+    QVERIFY2(elapsed.elapsed() >= batchInterval, "Got the StatesChanged notification before the batch interval passed.");
+
+    QVERIFY2(checkNotifications(clientSpy, "Integrations.StateChanged").isEmpty(), "Got a single StateChanged notification despite batching.");
+    QVariantList batches = checkNotifications(clientSpy, "Integrations.StatesChanged");
+    QCOMPARE(batches.count(), 1);
+
+    QVariantMap batchParams = batches.first().toMap().value("params").toMap();
+    QCOMPARE(batchParams.value("thingId").toUuid(), m_mockThingId);
+
+    QHash<QUuid, QVariantList> values;
+    foreach (const QVariant &state, batchParams.value("states").toList()) {
+        values[state.toMap().value("stateTypeId").toUuid()].append(state.toMap().value("value"));
+    }
+    QCOMPARE(values.value(mockIntStateTypeId).count(), 1);
+    QCOMPARE(values.value(mockIntStateTypeId).first().toInt(), 12);
+    QCOMPARE(values.value(mockBoolStateTypeId).count(), 1);
+    QCOMPARE(values.value(mockBoolStateTypeId).first().toBool(), !boolValue);
+
+    // Disable batching again
+    params.insert("notificationBatchInterval", 0);
+    handShake = injectAndWait("JSONRPC.Hello", params).toMap();
+    QCOMPARE(handShake.value("params").toMap().value("notificationBatchInterval").toInt(), 0);
+}
+
+void TestJSONRPC::appDataStoreAndLoad()
+{
+    enableNotifications({"AppData"});
+    QSignalSpy clientSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+
+    QVariantMap params;
+    params.insert("appId", "testjsonrpc");
+    params.insert("group", "layout");
+    params.insert("key", "single");
+    params.insert("value", "1");
+    QVariant response = injectAndWait("AppData.Store", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    QVariantMap values;
+    values.insert("first", "2");
+    values.insert("second", "3");
+    params.remove("key");
+    params.remove("value");
+    params.insert("values", values);
+    response = injectAndWait("AppData.StoreMany", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    QCOMPARE(checkNotifications(clientSpy, "AppData.Changed").count(), 3);
+
+    params.remove("values");
+    params.insert("key", "second");
+    response = injectAndWait("AppData.Load", params);
+    QCOMPARE(response.toMap().value("params").toMap().value("value").toString(), QString("3"));
+
+    params.remove("key");
+    response = injectAndWait("AppData.LoadAll", params);
+    QVariantMap loadedValues = response.toMap().value("params").toMap().value("values").toMap();
+    QCOMPARE(loadedValues.count(), 3);
+    QCOMPARE(loadedValues.value("single").toString(), QString("1"));
+    QCOMPARE(loadedValues.value("first").toString(), QString("2"));
+}
+
+void TestJSONRPC::notificationFilters()
+{
+    // Subscribe to a single state of a single thing, without enabling any namespace
+    QVariantMap filter;
+    filter.insert("notifications", QStringList() << "Integrations.StateChanged");
+    filter.insert("thingIds", QVariantList() << m_mockThingId);
+    filter.insert("stateTypeIds", QVariantList() << mockIntStateTypeId);
+    QVariantMap params;
+    params.insert("namespaces", QStringList());
+    params.insert("filters", QVariantList() << filter);
+    QVariant response = injectAndWait("JSONRPC.SetNotificationStatus", params);
+    QVariantList filters = response.toMap().value("params").toMap().value("filters").toList();
+    QCOMPARE(filters.count(), 1);
+    QCOMPARE(filters.first().toMap().value("notifications").toStringList(), QStringList() << "Integrations.StateChanged");
+
+    QNetworkAccessManager nam;
+    QSignalSpy clientSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+
+    // Change a state which is not covered by the filter
+    foreach (const QString &value, QStringList() << "true" << "false") {
+        QNetworkRequest request(QUrl(QString("http://localhost:%1/setstate?%2=%3").arg(m_mockThing1Port).arg(mockBoolStateTypeId.toString()).arg(value)));
+        QNetworkReply *reply = nam.get(request);
+        connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+        QSignalSpy replySpy(reply, &QNetworkReply::finished);
+        if (replySpy.count() == 0) replySpy.wait();
+    }
+    clientSpy.wait(500);
+    QVERIFY2(checkNotifications(clientSpy, "Integrations.StateChanged").isEmpty(), "Got a notification for a state not matching the filter.");
+
+    // Now change the filtered state
+    clientSpy.clear();
+    int newVal = 23;
+    QNetworkRequest request(QUrl(QString("http://localhost:%1/setstate?%2=%3").arg(m_mockThing1Port).arg(mockIntStateTypeId.toString()).arg(newVal)));
+    QNetworkReply *reply = nam.get(request);
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    if (clientSpy.count() == 0) clientSpy.wait();
+
+    QVariantList stateChangedVariants = checkNotifications(clientSpy, "Integrations.StateChanged");
+    QCOMPARE(stateChangedVariants.count(), 1);
+    QCOMPARE(stateChangedVariants.first().toMap().value("params").toMap().value("stateTypeId").toUuid(), mockIntStateTypeId);
+    QCOMPARE(stateChangedVariants.first().toMap().value("params").toMap().value("value").toInt(), newVal);
+    QVERIFY2(checkNotifications(clientSpy, "Logging.LogEntryAdded").isEmpty(), "Got a notification which has not been subscribed.");
+
+    QCOMPARE(disableNotifications(), true);
+}
+
 void TestJSONRPC::pluginConfigChangeEmitsNotification()
 {
     QSignalSpy clientSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
@@ -1369,6 +1563,64 @@ void TestJSONRPC::testGarbageData()
     QCOMPARE(spy.count(), 1);
 }
 
+void TestJSONRPC::cborEncoding()
+{
+    // The handshake reply still uses JSON
+    QVariantMap params;
+    params.insert("encoding", "MessageEncodingCbor");
+    QVariantMap handShake = injectAndWait("JSONRPC.Hello", params).toMap();
+    QCOMPARE(handShake.value("params").toMap().value("encoding").toString(), QString("MessageEncodingCbor"));
+
+    QSignalSpy spy(m_mockTcpServer, &MockTcpServer::outgoingData);
+
+    QVariantMap call;
+    call.insert("id", 42);
+    call.insert("token", m_apiToken);
+    call.insert("method", "JSONRPC.Version");
+    QByteArray payload = QCborValue::fromVariant(call).toCbor();
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(payload.size(), frame.data());
+    frame.append(payload);
+
+    // Split the frame to make sure the length prefix is respected
+    m_mockTcpServer->injectData(m_clientId, frame.left(3));
+    m_mockTcpServer->injectData(m_clientId, frame.mid(3, 10));
+    QCOMPARE(spy.count(), 0);
+    m_mockTcpServer->injectData(m_clientId, frame.mid(13));
+    if (spy.count() == 0) {
+        spy.wait();
+    }
+    QCOMPARE(spy.count(), 1);
+
+    QCborParserError error;
+    QVariantMap response = QCborValue::fromCbor(spy.first().last().toByteArray(), &error).toVariant().toMap();
+    QCOMPARE(error.error, QCborError::NoError);
+    QCOMPARE(response.value("id").toInt(), 42);
+    QCOMPARE(response.value("status").toString(), QString("success"));
+    QCOMPARE(response.value("params").toMap().value("protocol version").toString(), QString(JSON_PROTOCOL_VERSION));
+
+    // Switch back to JSON, the reply to that is still in CBOR
+    spy.clear();
+    call.insert("id", 43);
+    call.insert("method", "JSONRPC.Hello");
+    call.insert("params", QVariantMap({{"encoding", "MessageEncodingJson"}}));
+    payload = QCborValue::fromVariant(call).toCbor();
+    frame = QByteArray(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(payload.size(), frame.data());
+    frame.append(payload);
+    m_mockTcpServer->injectData(m_clientId, frame);
+    if (spy.count() == 0) {
+        spy.wait();
+    }
+    QCOMPARE(spy.count(), 1);
+    response = QCborValue::fromCbor(spy.first().last().toByteArray()).toVariant().toMap();
+    QCOMPARE(response.value("id").toInt(), 43);
+    QCOMPARE(response.value("params").toMap().value("encoding").toString(), QString("MessageEncodingJson"));
+
+    QVariant version = injectAndWait("JSONRPC.Version");
+    QCOMPARE(version.toMap().value("status").toString(), QString("success"));
+}
+
 #include "testjsonrpc.moc"
 
 QTEST_MAIN(TestJSONRPC)
@@ -48,6 +48,8 @@ private slots:
 
     void systemLogs();
 
+    void cursorPaging();
+
     void invalidFilter_data();
     void invalidFilter();
 
@@ -142,6 +144,98 @@ void TestLogging::systemLogs()
     QCOMPARE(logEntryStartup.value("values").toMap().value("version").toString(), QString(NYMEA_VERSION_STRING));
 }
 
+void TestLogging::cursorPaging()
+{
+    clearLoggingDatabase("core");
+    restartServer();
+    waitForDBSync();
+
+    QVariantMap params;
+    params.insert("sources", QStringList{"core"});
+    params.insert("sortOrder", enumValueName(Qt::DescendingOrder));
+
+    QVariant response = injectAndWait("Logging.GetLogEntries", params);
+    QVariantList allEntries = response.toMap().value("params").toMap().value("logEntries").toList();
+    QCOMPARE(allEntries.count(), 2);
+
+    // Page through the same query one entry at a time
+    params.insert("limit", 1);
+    params.insert("cursor", QString());
+    QVariantList pagedEntries;
+    for (int i = 0; i < 5; i++) {
+        response = injectAndWait("Logging.GetLogEntries", params);
+        QVariantMap result = response.toMap().value("params").toMap();
+        pagedEntries.append(result.value("logEntries").toList());
+        if (!result.contains("nextCursor")) {
+            break;
+        }
+        params.insert("cursor", result.value("nextCursor"));
+    }
+    QCOMPARE(pagedEntries, allEntries);
+
+    // An unknown cursor must be rejected
+    params.insert("cursor", QString("bogus"));
+    response = injectAndWait("Logging.GetLogEntries", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("error"));
+
+    // Streamed, one entry per chunk
+    params.remove("cursor");
+    params.insert("stream", true);
+    QSignalSpy clientSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+    response = injectAndWait("Logging.GetLogEntries", params);
+    QUuid streamId = response.toMap().value("params").toMap().value("streamId").toUuid();
+    QVERIFY(!streamId.isNull());
+
+    // Only 2 chunks are sent ahead of the acknowledgements
+    QVariantList chunks;
+    QTRY_COMPARE_WITH_TIMEOUT(checkNotifications(clientSpy, "Logging.LogEntriesStreamed").count(), 2, 5000);
+    QTest::qWait(200);
+    chunks = checkNotifications(clientSpy, "Logging.LogEntriesStreamed");
+    QCOMPARE(chunks.count(), 2);
+    QVERIFY(!chunks.last().toMap().value("params").toMap().value("finished").toBool());
+
+    // Acknowledging a chunk releases the next one
+    QVariantMap ackParams;
+    ackParams.insert("streamId", streamId);
+    response = injectAndWait("Logging.AcknowledgeLogEntries", ackParams);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    QTRY_VERIFY_WITH_TIMEOUT([&]() {
+        chunks = checkNotifications(clientSpy, "Logging.LogEntriesStreamed");
+        return !chunks.isEmpty() && chunks.last().toMap().value("params").toMap().value("finished").toBool();
+    }(), 5000);
+    QCOMPARE(chunks.count(), 3);
+
+    QVariantList streamedEntries;
+    foreach (const QVariant &chunk, chunks) {
+        QVariantMap chunkParams = chunk.toMap().value("params").toMap();
+        QCOMPARE(chunkParams.value("streamId").toUuid(), streamId);
+        QVERIFY(chunkParams.value("logEntries").toList().count() <= 1);
+        streamedEntries.append(chunkParams.value("logEntries").toList());
+    }
+    QCOMPARE(streamedEntries, allEntries);
+
+    // A stream stops when its client disconnects
+    QUuid clientId = QUuid::createUuid();
+    m_mockTcpServer->clientConnected(clientId);
+    injectAndWait("JSONRPC.Hello", QVariantMap(), clientId);
+    clientSpy.clear();
+    response = injectAndWait("Logging.GetLogEntries", params, clientId);
+    streamId = response.toMap().value("params").toMap().value("streamId").toUuid();
+    QVERIFY(!streamId.isNull());
+    QTRY_COMPARE_WITH_TIMEOUT(checkNotifications(clientSpy, "Logging.LogEntriesStreamed").count(), 2, 5000);
+
+    emit m_mockTcpServer->clientDisconnected(clientId);
+    m_mockTcpServer->clientConnected(clientId);
+    injectAndWait("JSONRPC.Hello", QVariantMap(), clientId);
+    clientSpy.clear();
+    ackParams.insert("streamId", streamId);
+    injectAndWait("Logging.AcknowledgeLogEntries", ackParams, clientId);
+    QTest::qWait(200);
+    QCOMPARE(checkNotifications(clientSpy, "Logging.LogEntriesStreamed").count(), 0);
+    emit m_mockTcpServer->clientDisconnected(clientId);
+}
+
 void TestLogging::invalidFilter_data()
 {
     QVariantMap invalidSourcesFilter;
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <QtTest>
+#include <QSharedPointer>
+
+#include "hardware/modbus/modbusrtumasterimpl.h"
+
+using namespace nymeaserver;
+
+#ifdef WITH_QTSERIALBUS
+
+// Hands requests to the test instead of a serial port
+class FakeModbusRtuMaster : public ModbusRtuMasterImpl
+{
+public:
+    struct SentRequest {
+        QModbusDataUnit unit;
+        int slaveAddress = 0;
+        bool write = false;
+        QModbusReply *reply = nullptr;
+    };
+
+    FakeModbusRtuMaster():
+        ModbusRtuMasterImpl(QUuid::createUuid(), "/dev/null", 9600, QSerialPort::NoParity, QSerialPort::Data8, QSerialPort::OneStop, 0, 100)
+    {
+    }
+
+    QList<SentRequest> sentRequests;
+    bool failSending = false;
+
+    void finishRequest(int index, const QVector<quint16> &values = QVector<quint16>())
+    {
+        SentRequest request = sentRequests.at(index);
+        QModbusDataUnit unit = request.unit;
+        if (!request.write) {
+            unit.setValues(values);
+        }
+        request.reply->setResult(unit);
+        request.reply->setFinished(true);
+    }
+
+protected:
+    QModbusReply *sendModbusRequest(const QModbusDataUnit &unit, int slaveAddress, bool write) override
+    {
+        if (failSending) {
+            return nullptr;
+        }
+
+        SentRequest request;
+        request.unit = unit;
+        request.slaveAddress = slaveAddress;
+        request.write = write;
+        request.reply = new QModbusReply(QModbusReply::Common, slaveAddress);
+        sentRequests.append(request);
+        return request.reply;
+    }
+};
+
+struct ReplyResult {
+    bool finished = false;
+    ModbusRtuReply::Error error = ModbusRtuReply::NoError;
+    QVector<quint16> values;
+};
+
+#endif // WITH_QTSERIALBUS
+
+class TestModbusRtu: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void coalesceReads();
+    void attachToRequestOnTheWire();
+    void shareRecentResponses();
+    void writesBeforeReads();
+    void noStaleReadsAfterWrite();
+    void sendFailureFinishesLater();
+
+#ifdef WITH_QTSERIALBUS
+private:
+    QSharedPointer<ReplyResult> watch(ModbusRtuReply *reply);
+#endif
+};
+
+#ifdef WITH_QTSERIALBUS
+QSharedPointer<ReplyResult> TestModbusRtu::watch(ModbusRtuReply *reply)
+{
+    // Replies delete themselves once finished, keep what the plugin would have seen
+    QSharedPointer<ReplyResult> result(new ReplyResult);
+    connect(reply, &ModbusRtuReply::finished, this, [reply, result](){
+        result->finished = true;
+        result->error = reply->error();
+        result->values = reply->result();
+    });
+    return result;
+}
+#endif
+
+void TestModbusRtu::coalesceReads()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+
+    QSharedPointer<ReplyResult> first = watch(master.readHoldingRegister(1, 10, 2));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    // Adjacent and overlapping reads of the same slave wait for the bus and are merged
+    QSharedPointer<ReplyResult> second = watch(master.readHoldingRegister(1, 12, 2));
+    QSharedPointer<ReplyResult> third = watch(master.readHoldingRegister(1, 13, 3));
+    // Other slaves and register types are not merged
+    QSharedPointer<ReplyResult> otherSlave = watch(master.readHoldingRegister(2, 12, 2));
+    QSharedPointer<ReplyResult> otherType = watch(master.readInputRegister(1, 12, 2));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    master.finishRequest(0, {1, 2});
+    QVERIFY(first->finished);
+    QCOMPARE(first->values, QVector<quint16>({1, 2}));
+
+    QCOMPARE(master.sentRequests.count(), 2);
+    QCOMPARE(master.sentRequests.at(1).slaveAddress, 1);
+    QCOMPARE(master.sentRequests.at(1).unit.registerType(), QModbusDataUnit::HoldingRegisters);
+    QCOMPARE(master.sentRequests.at(1).unit.startAddress(), 12);
+    QCOMPARE(static_cast<int>(master.sentRequests.at(1).unit.valueCount()), 4);
+
+    // Each reader gets its own slice
+    master.finishRequest(1, {3, 4, 5, 6});
+    QVERIFY(second->finished);
+    QCOMPARE(second->values, QVector<quint16>({3, 4}));
+    QVERIFY(third->finished);
+    QCOMPARE(third->values, QVector<quint16>({4, 5, 6}));
+
+    QCOMPARE(master.sentRequests.count(), 3);
+    QCOMPARE(master.sentRequests.at(2).slaveAddress, 2);
+    master.finishRequest(2, {7, 8});
+    QCOMPARE(otherSlave->values, QVector<quint16>({7, 8}));
+
+    QCOMPARE(master.sentRequests.count(), 4);
+    QCOMPARE(master.sentRequests.at(3).unit.registerType(), QModbusDataUnit::InputRegisters);
+    master.finishRequest(3, {9, 10});
+    QCOMPARE(otherType->values, QVector<quint16>({9, 10}));
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+void TestModbusRtu::attachToRequestOnTheWire()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+
+    QSharedPointer<ReplyResult> first = watch(master.readCoil(1, 0, 16));
+    QSharedPointer<ReplyResult> covered = watch(master.readCoil(1, 4, 2));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    master.finishRequest(0, {0, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    QCOMPARE(first->values.count(), 16);
+    QVERIFY(covered->finished);
+    QCOMPARE(covered->values, QVector<quint16>({1, 0}));
+    QCOMPARE(master.sentRequests.count(), 1);
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+void TestModbusRtu::shareRecentResponses()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+
+    QSharedPointer<ReplyResult> first = watch(master.readHoldingRegister(1, 20, 4));
+    master.finishRequest(0, {1, 2, 3, 4});
+    QVERIFY(first->finished);
+
+    // Served from the previous response, but never before the caller could connect to the reply
+    QSharedPointer<ReplyResult> cached = watch(master.readHoldingRegister(1, 21, 2));
+    QVERIFY(!cached->finished);
+    QTRY_VERIFY(cached->finished);
+    QCOMPARE(cached->values, QVector<quint16>({2, 3}));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    // Ranges not covered by the response are read
+    QSharedPointer<ReplyResult> notCovered = watch(master.readHoldingRegister(1, 23, 2));
+    QCOMPARE(master.sentRequests.count(), 2);
+    master.finishRequest(1, {4, 5});
+    QVERIFY(notCovered->finished);
+
+    // Responses expire
+    QTest::qWait(300);
+    QSharedPointer<ReplyResult> expired = watch(master.readHoldingRegister(1, 21, 2));
+    QCOMPARE(master.sentRequests.count(), 3);
+    master.finishRequest(2, {6, 7});
+    QCOMPARE(expired->values, QVector<quint16>({6, 7}));
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+void TestModbusRtu::writesBeforeReads()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+
+    QSharedPointer<ReplyResult> onTheWire = watch(master.readHoldingRegister(1, 30, 1));
+    QSharedPointer<ReplyResult> queuedRead = watch(master.readHoldingRegister(1, 40, 1));
+    QSharedPointer<ReplyResult> firstWrite = watch(master.writeHoldingRegisters(1, 50, {1}));
+    QSharedPointer<ReplyResult> secondWrite = watch(master.writeCoils(1, 60, {1}));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    // Writes are sent in order, before the queued read
+    master.finishRequest(0, {0});
+    QCOMPARE(master.sentRequests.count(), 2);
+    QVERIFY(master.sentRequests.at(1).write);
+    QCOMPARE(master.sentRequests.at(1).unit.startAddress(), 50);
+
+    master.finishRequest(1);
+    QVERIFY(firstWrite->finished);
+    QCOMPARE(master.sentRequests.count(), 3);
+    QVERIFY(master.sentRequests.at(2).write);
+    QCOMPARE(master.sentRequests.at(2).unit.registerType(), QModbusDataUnit::Coils);
+
+    master.finishRequest(2);
+    QVERIFY(secondWrite->finished);
+    QCOMPARE(master.sentRequests.count(), 4);
+    QVERIFY(!master.sentRequests.at(3).write);
+    QCOMPARE(master.sentRequests.at(3).unit.startAddress(), 40);
+
+    master.finishRequest(3, {2});
+    QVERIFY(queuedRead->finished);
+    QVERIFY(onTheWire->finished);
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+void TestModbusRtu::noStaleReadsAfterWrite()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+
+    QSharedPointer<ReplyResult> before = watch(master.readHoldingRegister(1, 60, 2));
+    QSharedPointer<ReplyResult> write = watch(master.writeHoldingRegisters(1, 61, {9}));
+
+    // A read issued after the write must not attach to the read on the wire
+    QSharedPointer<ReplyResult> after = watch(master.readHoldingRegister(1, 60, 2));
+    QCOMPARE(master.sentRequests.count(), 1);
+
+    master.finishRequest(0, {1, 2});
+    QCOMPARE(before->values, QVector<quint16>({1, 2}));
+    QVERIFY(!after->finished);
+
+    // The write is on the wire now. The old response must neither be cached nor handed out.
+    QCOMPARE(master.sentRequests.count(), 2);
+    QVERIFY(master.sentRequests.at(1).write);
+    QSharedPointer<ReplyResult> duringWrite = watch(master.readHoldingRegister(1, 61, 1));
+    QCoreApplication::processEvents();
+    QVERIFY(!duringWrite->finished);
+
+    master.finishRequest(1);
+    QVERIFY(write->finished);
+
+    // Both reads are merged and see the written value
+    QCOMPARE(master.sentRequests.count(), 3);
+    QCOMPARE(master.sentRequests.at(2).unit.startAddress(), 60);
+    QCOMPARE(static_cast<int>(master.sentRequests.at(2).unit.valueCount()), 2);
+    master.finishRequest(2, {1, 9});
+    QCOMPARE(after->values, QVector<quint16>({1, 9}));
+    QCOMPARE(duringWrite->values, QVector<quint16>({9}));
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+void TestModbusRtu::sendFailureFinishesLater()
+{
+#ifdef WITH_QTSERIALBUS
+    FakeModbusRtuMaster master;
+    master.failSending = true;
+
+    ModbusRtuReply *reply = master.readHoldingRegister(1, 70, 1);
+    QSharedPointer<ReplyResult> read = watch(reply);
+    QVERIFY(!reply->isFinished());
+    QVERIFY(!read->finished);
+    QTRY_VERIFY(read->finished);
+    QCOMPARE(read->error, ModbusRtuReply::ConnectionError);
+
+    QSharedPointer<ReplyResult> write = watch(master.writeHoldingRegisters(1, 70, {1}));
+    QVERIFY(!write->finished);
+    QTRY_VERIFY(write->finished);
+    QCOMPARE(write->error, ModbusRtuReply::ConnectionError);
+#else
+    QSKIP("Built without QtSerialBus support.");
+#endif
+}
+
+#include "testmodbusrtu.moc"
+QTEST_MAIN(TestModbusRtu)
@@ -27,6 +27,7 @@
 
 #include "nymeacore.h"
 #include "scriptengine/scriptengine.h"
+#include "scriptengine/scriptalarm.h"
 
 #include "../plugins/mock/extern-plugininfo.h"
 
@@ -65,6 +66,9 @@ private slots:
 
     void testScriptAlarm_data();
     void testScriptAlarm();
+    void testScriptAlarmDeadlines();
+    void testScriptAlarmWeekDays();
+    void testScriptAlarmEndTime();
 
     void testInterfaceEvent();
     void testInterfaceState();
@@ -550,14 +554,137 @@ void TestScripts::testScriptAlarm_data()
 {
     QTest::addColumn<QTime>("time");
     QTest::addColumn<QTime>("endTime");
+    QTest::addColumn<int>("weekDays");
+    QTest::addColumn<QDateTime>("now");
     QTest::addColumn<bool>("active");
 
-    QTest::newRow("active, regular") << QTime(12, 05);
+    // 2024-01-01 is a Monday
+    const QDate monday(2024, 1, 1);
+    const QDate tuesday(2024, 1, 2);
+
+    QTest::newRow("inside") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(12, 30)) << true;
+    QTest::newRow("before start") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(11, 59, 59)) << false;
+    QTest::newRow("at start") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(12, 0)) << true;
+    QTest::newRow("at end") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(13, 0)) << true;
+    QTest::newRow("after end") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(13, 0, 1)) << false;
+    QTest::newRow("overnight, evening") << QTime(22, 0) << QTime(6, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(23, 0)) << true;
+    QTest::newRow("overnight, morning") << QTime(22, 0) << QTime(6, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(5, 0)) << true;
+    QTest::newRow("overnight, midday") << QTime(22, 0) << QTime(6, 0) << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(12, 0)) << false;
+    QTest::newRow("other weekday") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::Tuesday) << QDateTime(monday, QTime(12, 30)) << false;
+    QTest::newRow("matching weekday") << QTime(12, 0) << QTime(13, 0) << static_cast<int>(ScriptAlarm::Tuesday) << QDateTime(tuesday, QTime(12, 30)) << true;
+    QTest::newRow("no end time") << QTime(12, 0) << QTime() << static_cast<int>(ScriptAlarm::AllDays) << QDateTime(monday, QTime(12, 30)) << false;
 }
 
 void TestScripts::testScriptAlarm()
 {
+    QFETCH(QTime, time);
+    QFETCH(QTime, endTime);
+    QFETCH(int, weekDays);
+    QFETCH(QDateTime, now);
+    QFETCH(bool, active);
+
+    ScriptAlarm alarm;
+    alarm.setTime(time);
+    alarm.setEndTime(endTime);
+    alarm.setWeekDays(ScriptAlarm::WeekDays(QFlag(weekDays)));
+
+    alarm.evaluate(now);
+    QCOMPARE(alarm.active(), active);
+}
+
+void TestScripts::testScriptAlarmDeadlines()
+{
+    const QDate monday(2024, 1, 1);
+    const QDate tuesday(2024, 1, 2);
+
+    ScriptAlarm alarm;
+    alarm.setTime(QTime(8, 0));
+
+    QSignalSpy triggeredSpy(&alarm, &ScriptAlarm::triggered);
+
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(7, 0))), QDateTime(monday, QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 0);
+
+    // Evaluating at the deadline fires and moves on to the next day
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(8, 0))), QDateTime(tuesday, QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // Evaluating again before the deadline must not fire twice
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(8, 0, 30))), QDateTime(tuesday, QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // The clock jumped far past the deadline, don't fire belatedly
+    QCOMPARE(alarm.evaluate(QDateTime(tuesday, QTime(8, 5))), QDateTime(tuesday.addDays(1), QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // With an end time, the earliest of trigger, end and day change wins
+    alarm.setEndTime(QTime(9, 0));
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(7, 0))), QDateTime(monday, QTime(8, 0)));
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(8, 0))), QDateTime(monday, QTime(9, 0, 1)));
+    QCOMPARE(triggeredSpy.count(), 2);
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(9, 0, 1))), QDateTime(tuesday, QTime(0, 0)));
+    QCOMPARE(triggeredSpy.count(), 2);
+}
+
+void TestScripts::testScriptAlarmWeekDays()
+{
+    // 2024-01-01 is a Monday
+    const QDate monday(2024, 1, 1);
+    const QDate wednesday(2024, 1, 3);
+    const QDate friday(2024, 1, 5);
+
+    ScriptAlarm alarm;
+    alarm.setTime(QTime(8, 0));
+    alarm.setWeekDays(ScriptAlarm::WeekDays(ScriptAlarm::Wednesday) | ScriptAlarm::Friday);
+
+    QSignalSpy triggeredSpy(&alarm, &ScriptAlarm::triggered);
 
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(9, 0))), QDateTime(wednesday, QTime(8, 0)));
+    QCOMPARE(alarm.evaluate(QDateTime(wednesday, QTime(8, 0))), QDateTime(friday, QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 1);
+
+    // Repeats in the following week
+    QCOMPARE(alarm.evaluate(QDateTime(friday, QTime(8, 0))), QDateTime(wednesday.addDays(7), QTime(8, 0)));
+    QCOMPARE(triggeredSpy.count(), 2);
+
+    // Without any week day the alarm never fires
+    alarm.setWeekDays(ScriptAlarm::WeekDays());
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(9, 0))), QDateTime());
+    QCOMPARE(triggeredSpy.count(), 2);
+}
+
+void TestScripts::testScriptAlarmEndTime()
+{
+    const QDate monday(2024, 1, 1);
+    const QDate tuesday(2024, 1, 2);
+
+    ScriptAlarm alarm;
+    alarm.setTime(QTime(12, 0));
+    alarm.setEndTime(QTime(13, 0));
+    alarm.setWeekDays(ScriptAlarm::Monday);
+    alarm.evaluate(QDateTime(monday, QTime(11, 0)));
+    QVERIFY(!alarm.active());
+
+    QSignalSpy activeSpy(&alarm, &ScriptAlarm::activeChanged);
+
+    // The end time itself is still inside, the next evaluation is right after it
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(13, 0))), QDateTime(monday, QTime(13, 0, 1)));
+    QVERIFY(alarm.active());
+    QCOMPARE(activeSpy.count(), 1);
+
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(13, 0, 1))), QDateTime(tuesday, QTime(0, 0)));
+    QVERIFY(!alarm.active());
+    QCOMPARE(activeSpy.count(), 2);
+
+    // Across midnight the active state ends with the day if the next day is not selected
+    alarm.setTime(QTime(22, 0));
+    alarm.setEndTime(QTime(6, 0));
+    alarm.evaluate(QDateTime(monday, QTime(21, 0)));
+    QVERIFY(!alarm.active());
+    QCOMPARE(alarm.evaluate(QDateTime(monday, QTime(22, 0))), QDateTime(tuesday, QTime(0, 0)));
+    QVERIFY(alarm.active());
+    alarm.evaluate(QDateTime(tuesday, QTime(0, 0)));
+    QVERIFY(!alarm.active());
 }
 
 void TestScripts::testInterfaceEvent()
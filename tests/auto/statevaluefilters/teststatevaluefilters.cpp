@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2025, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <QtTest>
+
+#include "integrations/statevaluefilters/statevaluefilterdeadband.h"
+#include "integrations/statevaluefilters/statevaluefilterexponential.h"
+#include "integrations/statevaluefilters/statevaluefilterratelimit.h"
+
+class TestStateValueFilters: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void deadband_data();
+    void deadband();
+
+    void exponential_data();
+    void exponential();
+
+    void rateLimitPassesChangesOutsideInterval();
+    void rateLimitDeliversLatestValueWhenIntervalExpires();
+    void rateLimitPassesChangesToAndFromZero();
+
+private:
+    void feedValues(StateValueFilter *filter, const QVariantList &input, const QVariantList &expectedOutput);
+};
+
+void TestStateValueFilters::feedValues(StateValueFilter *filter, const QVariantList &input, const QVariantList &expectedOutput)
+{
+    QCOMPARE(input.count(), expectedOutput.count());
+    for (int i = 0; i < input.count(); i++) {
+        filter->addValue(input.at(i));
+        QVERIFY2(qFuzzyCompare(filter->filteredValue().toDouble() + 1, expectedOutput.at(i).toDouble() + 1),
+                 QString("Sample %1: input %2, expected output %3 but got %4")
+                 .arg(i).arg(input.at(i).toDouble()).arg(expectedOutput.at(i).toDouble()).arg(filter->filteredValue().toDouble()).toUtf8());
+    }
+}
+
+void TestStateValueFilters::deadband_data()
+{
+    QTest::addColumn<QVariantList>("input");
+    QTest::addColumn<QVariantList>("expectedOutput");
+
+    QTest::newRow("first value") << QVariantList{42} << QVariantList{42};
+    QTest::newRow("noise within band") << QVariantList{100, 100.5, 99.2, 100.9} << QVariantList{100, 100, 100, 100};
+    QTest::newRow("leaving the band") << QVariantList{100, 100.5, 101.5, 102} << QVariantList{100, 100, 101.5, 101.5};
+    QTest::newRow("band relative to output") << QVariantList{1000, 1009, 1011} << QVariantList{1000, 1000, 1011};
+    QTest::newRow("absolute band around 0") << QVariantList{0, 0.005, 0.02} << QVariantList{0, 0, 0.02};
+    QTest::newRow("drop to 0") << QVariantList{0.5, 0} << QVariantList{0.5, 0};
+}
+
+void TestStateValueFilters::deadband()
+{
+    QFETCH(QVariantList, input);
+    QFETCH(QVariantList, expectedOutput);
+
+    StateValueFilterDeadband filter;
+    feedValues(&filter, input, expectedOutput);
+}
+
+void TestStateValueFilters::exponential_data()
+{
+    QTest::addColumn<QVariantList>("input");
+    QTest::addColumn<QVariantList>("expectedOutput");
+
+    QTest::newRow("first value") << QVariantList{42} << QVariantList{42};
+    QTest::newRow("smoothing") << QVariantList{100, 110, 110} << QVariantList{100, 102, 103.6};
+    QTest::newRow("steps are followed") << QVariantList{100, 200, 50} << QVariantList{100, 200, 50};
+    QTest::newRow("to and from 0") << QVariantList{100, 0, 5} << QVariantList{100, 0, 5};
+    QTest::newRow("negative values") << QVariantList{-100, -110} << QVariantList{-100, -102};
+    QTest::newRow("changes below epsilon") << QVariantList{100, 100.2, 100.4, 101} << QVariantList{100, 100, 100, 100.2};
+}
+
+void TestStateValueFilters::exponential()
+{
+    QFETCH(QVariantList, input);
+    QFETCH(QVariantList, expectedOutput);
+
+    StateValueFilterExponential filter;
+    feedValues(&filter, input, expectedOutput);
+}
+
+void TestStateValueFilters::rateLimitPassesChangesOutsideInterval()
+{
+    StateValueFilterRateLimit filter(100);
+    QSignalSpy spy(&filter, &StateValueFilterRateLimit::filteredValueChanged);
+
+    filter.addValue(10);
+    QCOMPARE(filter.filteredValue().toInt(), 10);
+
+    QTest::qWait(150);
+    filter.addValue(20);
+    QCOMPARE(filter.filteredValue().toInt(), 20);
+
+    // Changes passed right away are returned by filteredValue() and not signaled
+    QCOMPARE(spy.count(), 0);
+}
+
+void TestStateValueFilters::rateLimitDeliversLatestValueWhenIntervalExpires()
+{
+    const int interval = 200;
+    StateValueFilterRateLimit filter(interval);
+    QSignalSpy spy(&filter, &StateValueFilterRateLimit::filteredValueChanged);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    filter.addValue(10);
+    filter.addValue(11);
+    filter.addValue(12);
+    filter.addValue(13);
+    QCOMPARE(filter.filteredValue().toInt(), 10);
+
+    // Only the latest value is delivered once the interval expired
+    QVERIFY(spy.wait(interval * 5));
+    QVERIFY(elapsed.elapsed() >= interval * 0.9);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().first().toInt(), 13);
+    QCOMPARE(filter.filteredValue().toInt(), 13);
+
+    // The delivered value starts a new interval
+    spy.clear();
+    filter.addValue(14);
+    QCOMPARE(filter.filteredValue().toInt(), 13);
+    QVERIFY(spy.wait(interval * 5));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().first().toInt(), 14);
+
+    // Going back to the current output during the interval delivers nothing
+    spy.clear();
+    filter.addValue(15);
+    filter.addValue(14);
+    QVERIFY(!spy.wait(interval * 2));
+    QCOMPARE(filter.filteredValue().toInt(), 14);
+}
+
+void TestStateValueFilters::rateLimitPassesChangesToAndFromZero()
+{
+    const int interval = 200;
+    StateValueFilterRateLimit filter(interval);
+    QSignalSpy spy(&filter, &StateValueFilterRateLimit::filteredValueChanged);
+
+    filter.addValue(10);
+    filter.addValue(11);
+    filter.addValue(0);
+    QCOMPARE(filter.filteredValue().toInt(), 0);
+
+    filter.addValue(5);
+    QCOMPARE(filter.filteredValue().toInt(), 5);
+
+    // The value held back before the change to 0 is dropped
+    QVERIFY(!spy.wait(interval * 2));
+    QCOMPARE(filter.filteredValue().toInt(), 5);
+}
+
+#include "teststatevaluefilters.moc"
+QTEST_MAIN(TestStateValueFilters)
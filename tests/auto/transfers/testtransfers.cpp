@@ -7,6 +7,7 @@
 #include <QJsonDocument>
 #include <QScopedPointer>
 #include <QWebSocket>
+#include <QtEndian>
 
 using namespace nymeaserver;
 
@@ -20,6 +21,8 @@ private slots:
     void testTransferConnectWithInvalidTokenTerminatesCleanly();
     void testDownloadCompletionTerminatesConnectionCleanly();
     void testStartDownloadRejectsUnknownDownloadId();
+    void testBinaryTransferWithResume();
+    void testBinaryUploadWithUnexpectedOffsetTerminatesConnection();
 
 public slots:
     void sslErrors(const QList<QSslError> &)
@@ -34,6 +37,9 @@ private:
     QWebSocket *openSocket();
     QVariant sendAndWait(QWebSocket *socket, int id, const QString &method, const QVariantMap &params = QVariantMap(), QVariantMap *notification = nullptr);
     QVariant sendMockTransferAndWait(const QUuid &clientId, int id, const QString &method, const QVariantMap &params = QVariantMap());
+    QByteArray lengthPrefixed(const QByteArray &data);
+    QByteArray binaryFrame(quint8 type, qint64 offset, const QByteArray &payload = QByteArray());
+    QList<QByteArray> waitForBinaryFrames(QSignalSpy &spy, const QUuid &clientId, int count);
     QVariantMap waitForNotification(QSignalSpy &spy, const QString &notificationName);
 };
 
@@ -262,6 +268,144 @@ void TestTransfers::testStartDownloadRejectsUnknownDownloadId()
     QCOMPARE(response.toMap().value("error").toString(), QString("Unknown download"));
 }
 
+void TestTransfers::testBinaryTransferWithResume()
+{
+    QByteArray payload;
+    for (int i = 0; i < 3 * 4096 + 100; ++i)
+        payload.append(static_cast<char>(i % 251));
+
+    QVariantMap params;
+    params.insert("fileName", "binary.bin");
+    params.insert("size", payload.size());
+    QVariant response = injectAndWait("Transfers.CreateUpload", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    const QString uploadTransferId = response.toMap().value("params").toMap().value("transferId").toString();
+    const QString uploadTransferToken = response.toMap().value("params").toMap().value("transferToken").toString();
+
+    // Upload the first two chunks in one go without waiting for the acks in between
+    QUuid clientId = QUuid::createUuid();
+    m_mockTcpServer->clientConnected(clientId);
+
+    params.clear();
+    params.insert("transferId", uploadTransferId);
+    params.insert("transferToken", uploadTransferToken);
+    params.insert("binary", true);
+    params.insert("chunkSize", 4096);
+    response = sendMockTransferAndWait(clientId, 1, "Transfer.Connect", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    QVERIFY(response.toMap().value("params").toMap().value("binary").toBool());
+    QCOMPARE(response.toMap().value("params").toMap().value("offset").toLongLong(), 0);
+
+    QSignalSpy outgoingSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+    m_mockTcpServer->injectData(clientId, binaryFrame(0x01, 0, payload.left(4096)) + binaryFrame(0x01, 4096, payload.mid(4096, 4096)));
+    QList<QByteArray> frames = waitForBinaryFrames(outgoingSpy, clientId, 2);
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(static_cast<quint8>(frames.last().at(0)), static_cast<quint8>(0x02));
+    QCOMPARE(qFromBigEndian<qint64>(frames.last().constData() + 1), static_cast<qint64>(8192));
+
+    // Connection drops, resume from the first chunk on a new connection
+    m_mockTcpServer->clientDisconnected(clientId);
+    clientId = QUuid::createUuid();
+    m_mockTcpServer->clientConnected(clientId);
+
+    params.insert("offset", 4096);
+    response = sendMockTransferAndWait(clientId, 2, "Transfer.Connect", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    QCOMPARE(response.toMap().value("params").toMap().value("offset").toLongLong(), 4096);
+
+    outgoingSpy.clear();
+    m_mockTcpServer->injectData(clientId, binaryFrame(0x01, 4096, payload.mid(4096)));
+    frames = waitForBinaryFrames(outgoingSpy, clientId, 1);
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(qFromBigEndian<qint64>(frames.first().constData() + 1), static_cast<qint64>(payload.size()));
+
+    QVariantMap finishUpload;
+    finishUpload.insert("id", 3);
+    finishUpload.insert("method", "Transfer.FinishUpload");
+    outgoingSpy.clear();
+    m_mockTcpServer->injectData(clientId, lengthPrefixed(QByteArray(1, '\x03') + QJsonDocument::fromVariant(finishUpload).toJson(QJsonDocument::Compact)));
+    frames = waitForBinaryFrames(outgoingSpy, clientId, 1);
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(static_cast<quint8>(frames.first().at(0)), static_cast<quint8>(0x03));
+    const QVariantMap finishResponse = QJsonDocument::fromJson(frames.first().mid(1)).toVariant().toMap();
+    QCOMPARE(finishResponse.value("status").toString(), QString("success"));
+    const QString downloadId = finishResponse.value("params").toMap().value("downloadId").toString();
+    QVERIFY(!downloadId.isEmpty());
+    m_mockTcpServer->clientDisconnected(clientId);
+
+    // Download with a window of two chunks, acknowledging each chunk
+    params.clear();
+    params.insert("downloadId", downloadId);
+    response = injectAndWait("Transfers.StartDownload", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    clientId = QUuid::createUuid();
+    m_mockTcpServer->clientConnected(clientId);
+    QSignalSpy terminatedSpy(m_mockTcpServer, &MockTcpServer::connectionTerminated);
+
+    params.clear();
+    params.insert("transferId", response.toMap().value("params").toMap().value("transferId").toString());
+    params.insert("transferToken", response.toMap().value("params").toMap().value("transferToken").toString());
+    params.insert("binary", true);
+    params.insert("chunkSize", 4096);
+    params.insert("window", 2);
+    outgoingSpy.clear();
+    response = sendMockTransferAndWait(clientId, 4, "Transfer.Connect", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    QCOMPARE(response.toMap().value("params").toMap().value("direction").toString(), QString("download"));
+
+    QByteArray downloadedPayload;
+    while (downloadedPayload.size() < payload.size()) {
+        frames = waitForBinaryFrames(outgoingSpy, clientId, 1);
+        QCOMPARE(frames.count(), 1);
+        QCOMPARE(static_cast<quint8>(frames.first().at(0)), static_cast<quint8>(0x01));
+        QCOMPARE(qFromBigEndian<qint64>(frames.first().constData() + 1), static_cast<qint64>(downloadedPayload.size()));
+        downloadedPayload.append(frames.first().mid(9));
+        m_mockTcpServer->injectData(clientId, binaryFrame(0x02, downloadedPayload.size()));
+    }
+
+    QCOMPARE(downloadedPayload, payload);
+    QCOMPARE(terminatedSpy.count(), 1);
+}
+
+void TestTransfers::testBinaryUploadWithUnexpectedOffsetTerminatesConnection()
+{
+    const QByteArray payload(8192, 'x');
+
+    QVariantMap params;
+    params.insert("fileName", "offset.bin");
+    params.insert("size", payload.size());
+    QVariant response = injectAndWait("Transfers.CreateUpload", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    const QUuid clientId = QUuid::createUuid();
+    m_mockTcpServer->clientConnected(clientId);
+    QSignalSpy terminatedSpy(m_mockTcpServer, &MockTcpServer::connectionTerminated);
+
+    const QVariantMap uploadParams = response.toMap().value("params").toMap();
+    params.clear();
+    params.insert("transferId", uploadParams.value("transferId").toString());
+    params.insert("transferToken", uploadParams.value("transferToken").toString());
+    params.insert("binary", true);
+    params.insert("chunkSize", 4096);
+    response = sendMockTransferAndWait(clientId, 1, "Transfer.Connect", params);
+    QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+
+    // Skipping the first chunk must not leave the connection open for more data
+    QSignalSpy outgoingSpy(m_mockTcpServer, &MockTcpServer::outgoingData);
+    m_mockTcpServer->injectData(clientId, binaryFrame(0x01, 4096, payload.left(4096)));
+    if (terminatedSpy.count() == 0)
+        QVERIFY(terminatedSpy.wait());
+    QCOMPARE(terminatedSpy.count(), 1);
+    QCOMPARE(terminatedSpy.first().at(0).toUuid(), clientId);
+
+    const QList<QByteArray> frames = waitForBinaryFrames(outgoingSpy, clientId, 1);
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(static_cast<quint8>(frames.first().at(0)), static_cast<quint8>(0x03));
+    const QVariantMap errorResponse = QJsonDocument::fromJson(frames.first().mid(1)).toVariant().toMap();
+    QCOMPARE(errorResponse.value("status").toString(), QString("error"));
+}
+
 QWebSocket *TestTransfers::openSocket()
 {
     QWebSocket *socket = new QWebSocket("nymea transfer tests", QWebSocketProtocol::Version13);
@@ -353,6 +497,38 @@ QVariant TestTransfers::sendMockTransferAndWait(const QUuid &clientId, int id, c
     return QVariant();
 }
 
+QByteArray TestTransfers::lengthPrefixed(const QByteArray &data)
+{
+    QByteArray message(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(data.size()), message.data());
+    return message + data;
+}
+
+QByteArray TestTransfers::binaryFrame(quint8 type, qint64 offset, const QByteArray &payload)
+{
+    QByteArray frame(9, Qt::Uninitialized);
+    frame[0] = static_cast<char>(type);
+    qToBigEndian<qint64>(offset, frame.data() + 1);
+    frame.append(payload);
+    return lengthPrefixed(frame);
+}
+
+QList<QByteArray> TestTransfers::waitForBinaryFrames(QSignalSpy &spy, const QUuid &clientId, int count)
+{
+    QList<QByteArray> frames;
+    while (frames.count() < count && (spy.count() > 0 || spy.wait())) {
+        while (spy.count() > 0 && frames.count() < count) {
+            const QList<QVariant> arguments = spy.takeFirst();
+            // Skip the JSON response of the handshake
+            if (arguments.at(0).toUuid() == clientId && !arguments.at(1).toByteArray().startsWith('{')) {
+                frames.append(arguments.at(1).toByteArray());
+            }
+        }
+    }
+
+    return frames;
+}
+
 QVariantMap TestTransfers::waitForNotification(QSignalSpy &spy, const QString &notificationName)
 {
     while (spy.count() > 0 || spy.wait()) {
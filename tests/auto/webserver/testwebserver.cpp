@@ -28,6 +28,8 @@
 #include <webserver/httpreply.h>
 
 #include <QXmlReader>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 
 using namespace nymeaserver;
@@ -62,6 +64,8 @@ private slots:
     void getDebugServer_data();
     void getDebugServer();
 
+    void generateDebugReport();
+
 public slots:
     void onSslErrors(const QList<QSslError> &errors) {
         qCWarning(dcTests()) << "SSL errors:" << errors;
@@ -628,5 +632,75 @@ void TestWebserver::getDebugServer()
     QCOMPARE(statusCode, expectedStatusCode);
 }
 
+void TestWebserver::generateDebugReport()
+{
+    QVariantMap params; QVariant response;
+    params.insert("enabled", true);
+    response = injectAndWait("Configuration.SetDebugServerEnabled", params);
+    verifyError(response, "configurationError", "ConfigurationErrorNoError");
+
+    QNetworkAccessManager nam;
+    connect(&nam, &QNetworkAccessManager::sslErrors, this, [](QNetworkReply* reply, const QList<QSslError> &) {
+        reply->ignoreSslErrors();
+    });
+
+    // Start generating the report
+    QNetworkReply *reply = nam.get(QNetworkRequest(QUrl("https://localhost:3333/debug/report")));
+    QSignalSpy replySpy(reply, &QNetworkReply::finished);
+    QVERIFY(replySpy.wait());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 204);
+    reply->deleteLater();
+
+    // Poll until the report is ready. The archive is written in a worker thread, so the
+    // server has to keep handling JSON-RPC calls in the meantime.
+    QVariantMap reportInformation;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (reportInformation.isEmpty() && elapsed.elapsed() < 120000) {
+        response = injectAndWait("JSONRPC.Version");
+        QVERIFY2(!response.toMap().value("params").toMap().value("version").toString().isEmpty(), "Server did not respond while generating the debug report.");
+
+        reply = nam.get(QNetworkRequest(QUrl("https://localhost:3333/debug/report")));
+        QSignalSpy pollSpy(reply, &QNetworkReply::finished);
+        QVERIFY(pollSpy.wait());
+        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (statusCode == 200) {
+            QJsonParseError error;
+            QJsonDocument jsonDoc = QJsonDocument::fromJson(reply->readAll(), &error);
+            QCOMPARE(error.error, QJsonParseError::NoError);
+            reportInformation = jsonDoc.toVariant().toMap();
+        } else {
+            QCOMPARE(statusCode, 204);
+            QTest::qWait(500);
+        }
+        reply->deleteLater();
+    }
+    QVERIFY2(!reportInformation.isEmpty(), "Debug report has not been generated in time.");
+
+    QString fileName = reportInformation.value("fileName").toString();
+    QVERIFY(fileName.endsWith(".tar.gz"));
+    QVERIFY(reportInformation.value("fileSize").toLongLong() > 0);
+
+    // Requesting any other file must fail
+    reply = nam.get(QNetworkRequest(QUrl("https://localhost:3333/debug/report?filename=invalid.tar.gz")));
+    QSignalSpy invalidSpy(reply, &QNetworkReply::finished);
+    QVERIFY(invalidSpy.wait());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+    reply->deleteLater();
+
+    // Download the report and verify it matches the announced information
+    reply = nam.get(QNetworkRequest(QUrl("https://localhost:3333/debug/report?filename=" + fileName)));
+    QSignalSpy downloadSpy(reply, &QNetworkReply::finished);
+    QVERIFY(downloadSpy.wait());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QByteArray data = reply->readAll();
+    reply->deleteLater();
+
+    QCOMPARE(static_cast<qint64>(data.size()), reportInformation.value("fileSize").toLongLong());
+    QCOMPARE(QString::fromUtf8(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex()), reportInformation.value("md5sum").toString());
+    // gzip magic
+    QVERIFY(data.startsWith("\x1f\x8b"));
+}
+
 #include "testwebserver.moc"
 QTEST_MAIN(TestWebserver)
@@ -0,0 +1,16 @@
+include(../auto/autotests.pri)
+
+# Benchmarks are not part of "make check", run them with "make benchmark"
+CONFIG -= testcase
+
+INCLUDEPATH += $$PWD
+
+HEADERS += $$PWD/nymeabenchmarkbase.h
+SOURCES += $$PWD/nymeabenchmarkbase.cpp
+
+target.path = $$[QT_INSTALL_PREFIX]/share/tests/nymea/benchmarks/
+
+# Writes the results as QTestLib XML (BenchmarkResult elements) next to the binary for tracking them between releases
+benchmark.commands = LD_LIBRARY_PATH=../../../libnymea:../../../libnymea-core/:../../libnymea-tests/ \
+                     dbus-test-runner --bus-type=both --task ./$$TARGET --parameter -o --parameter $${TARGET}.xml,xml
+QMAKE_EXTRA_TARGETS += benchmark
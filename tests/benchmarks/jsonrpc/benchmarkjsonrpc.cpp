@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2026, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "nymeabenchmarkbase.h"
+#include "nymeacore.h"
+#include "jsonrpc/jsonrpcserverimplementation.h"
+#include "integrations/thingmanager.h"
+
+#include "../plugins/mock/extern-plugininfo.h"
+
+using namespace nymeaserver;
+
+class BenchmarkJsonRpc : public NymeaBenchmarkBase
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void packThings_data();
+    void packThings();
+
+    void getThings_data();
+    void getThings();
+
+    void executeAction();
+
+private:
+    void addScaleRows();
+};
+
+void BenchmarkJsonRpc::initTestCase()
+{
+    NymeaTestBase::initTestCase("*.debug=false\n"
+                                "Tests.debug=true\n");
+}
+
+void BenchmarkJsonRpc::addScaleRows()
+{
+    QTest::addColumn<int>("thingCount");
+
+    QTest::newRow("10 things") << 10;
+    QTest::newRow("100 things") << 100;
+    QTest::newRow("500 things") << 500;
+}
+
+void BenchmarkJsonRpc::packThings_data()
+{
+    addScaleRows();
+}
+
+void BenchmarkJsonRpc::packThings()
+{
+    QFETCH(int, thingCount);
+
+    QList<Thing *> things;
+    foreach (const ThingId &thingId, addSensors(thingCount)) {
+        things.append(NymeaCore::instance()->thingManager()->findConfiguredThing(thingId));
+    }
+    QCOMPARE(things.count(), thingCount);
+
+    JsonHandler *handler = NymeaCore::instance()->jsonRPCServer()->handlers().value("Integrations");
+    QVERIFY(handler);
+
+    QBENCHMARK {
+        foreach (Thing *thing, things) {
+            handler->pack(thing);
+        }
+    }
+}
+
+void BenchmarkJsonRpc::getThings_data()
+{
+    addScaleRows();
+}
+
+void BenchmarkJsonRpc::getThings()
+{
+    QFETCH(int, thingCount);
+
+    QCOMPARE(addSensors(thingCount).count(), thingCount);
+
+    // Parsing, validation of params and returns, packing and serializing the reply
+    QBENCHMARK {
+        QVariant response = injectAndWait("Integrations.GetThings");
+        QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    }
+}
+
+void BenchmarkJsonRpc::executeAction()
+{
+    ThingId thingId = addSensors(1).first();
+
+    QVariantMap actionParam;
+    actionParam.insert("paramTypeId", virtualIoTemperatureSensorMockInputActionInputParamTypeId);
+    actionParam.insert("value", 0.5);
+
+    QVariantMap params;
+    params.insert("thingId", thingId);
+    params.insert("actionTypeId", virtualIoTemperatureSensorMockInputActionTypeId);
+    params.insert("params", QVariantList() << actionParam);
+
+    QBENCHMARK {
+        QVariant response = injectAndWait("Integrations.ExecuteAction", params);
+        QCOMPARE(response.toMap().value("status").toString(), QString("success"));
+    }
+}
+
+#include "benchmarkjsonrpc.moc"
+QTEST_MAIN(BenchmarkJsonRpc)
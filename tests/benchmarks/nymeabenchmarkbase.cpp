@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2026, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "nymeabenchmarkbase.h"
+#include "servers/mocktcpserver.h"
+
+#include "../plugins/mock/extern-plugininfo.h"
+
+namespace nymeaserver {
+
+NymeaBenchmarkBase::NymeaBenchmarkBase(QObject *parent) :
+    NymeaTestBase(parent)
+{
+
+}
+
+QList<ThingId> NymeaBenchmarkBase::addSensors(int count)
+{
+    while (m_sensorIds.count() < count) {
+        QVariantMap params;
+        params.insert("name", QString("Benchmark sensor %1").arg(m_sensorIds.count()));
+        params.insert("thingClassId", virtualIoTemperatureSensorMockThingClassId);
+        QVariant response = injectAndWait("Integrations.AddThing", params);
+
+        ThingId thingId = ThingId(response.toMap().value("params").toMap().value("thingId").toString());
+        if (thingId.isNull()) {
+            qCWarning(dcTests()) << "Failed to add benchmark sensor" << response;
+            break;
+        }
+        m_sensorIds.append(thingId);
+    }
+
+    return m_sensorIds.mid(0, count);
+}
+
+QList<QUuid> NymeaBenchmarkBase::connectClients(int count, const QStringList &namespaces)
+{
+    while (m_clientIds.count() < count) {
+        QUuid clientId = QUuid::createUuid();
+        m_mockTcpServer->clientConnected(clientId);
+        injectAndWait("JSONRPC.Hello", QVariantMap(), clientId);
+
+        QVariantMap params;
+        params.insert("namespaces", namespaces);
+        injectAndWait("JSONRPC.SetNotificationStatus", params, clientId);
+        m_clientIds.append(clientId);
+    }
+
+    return m_clientIds.mid(0, count);
+}
+
+}
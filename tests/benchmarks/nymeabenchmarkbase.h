@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2026, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef NYMEABENCHMARKBASE_H
+#define NYMEABENCHMARKBASE_H
+
+#include "nymeatestbase.h"
+
+#include <typeutils.h>
+
+namespace nymeaserver {
+
+class NymeaBenchmarkBase : public NymeaTestBase
+{
+    Q_OBJECT
+public:
+    explicit NymeaBenchmarkBase(QObject *parent = nullptr);
+
+protected:
+    // Makes sure at least count virtual temperature sensors are configured and returns the first count of them
+    QList<ThingId> addSensors(int count);
+
+    // Makes sure at least count additional JSON-RPC clients are connected with notifications enabled for the given namespaces
+    QList<QUuid> connectClients(int count, const QStringList &namespaces);
+
+private:
+    QList<ThingId> m_sensorIds;
+    QList<QUuid> m_clientIds;
+};
+
+}
+
+#endif // NYMEABENCHMARKBASE_H
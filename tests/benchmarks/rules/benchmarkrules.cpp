@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2026, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "nymeabenchmarkbase.h"
+#include "nymeacore.h"
+#include "ruleengine/ruleengine.h"
+
+#include "../plugins/mock/extern-plugininfo.h"
+
+using namespace nymeaserver;
+
+class BenchmarkRules : public NymeaBenchmarkBase
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void evaluateEvent_data();
+    void evaluateEvent();
+
+private:
+    void addRules(int count);
+
+    int m_ruleCount = 0;
+};
+
+void BenchmarkRules::initTestCase()
+{
+    NymeaTestBase::initTestCase("*.debug=false\n"
+                                "Tests.debug=true\n");
+}
+
+void BenchmarkRules::addRules(int count)
+{
+    QList<ThingId> sensorIds = addSensors(10);
+
+    while (m_ruleCount < count) {
+        QVariantMap eventDescriptor;
+        eventDescriptor.insert("eventTypeId", mockEvent1EventTypeId);
+        eventDescriptor.insert("thingId", m_mockThingId);
+
+        QVariantMap stateDescriptor;
+        stateDescriptor.insert("stateTypeId", virtualIoTemperatureSensorMockTemperatureStateTypeId);
+        stateDescriptor.insert("thingId", sensorIds.at(m_ruleCount % sensorIds.count()));
+        stateDescriptor.insert("operator", enumValueName(Types::ValueOperatorGreater));
+        stateDescriptor.insert("value", m_ruleCount % 40);
+
+        QVariantMap stateEvaluator;
+        stateEvaluator.insert("stateDescriptor", stateDescriptor);
+
+        QVariantMap actionParam;
+        actionParam.insert("paramTypeId", mockPowerActionPowerParamTypeId);
+        actionParam.insert("value", true);
+
+        QVariantMap action;
+        action.insert("thingId", m_mockThingId);
+        action.insert("actionTypeId", mockPowerActionTypeId);
+        action.insert("ruleActionParams", QVariantList() << actionParam);
+
+        QVariantMap params;
+        params.insert("name", QString("Benchmark rule %1").arg(m_ruleCount));
+        params.insert("eventDescriptors", QVariantList() << eventDescriptor);
+        params.insert("stateEvaluator", stateEvaluator);
+        params.insert("actions", QVariantList() << action);
+
+        QVariant response = injectAndWait("Rules.AddRule", params);
+        QCOMPARE(response.toMap().value("params").toMap().value("ruleError").toString(), enumValueName(RuleEngine::RuleErrorNoError));
+        m_ruleCount++;
+    }
+}
+
+void BenchmarkRules::evaluateEvent_data()
+{
+    QTest::addColumn<int>("ruleCount");
+
+    QTest::newRow("10 rules") << 10;
+    QTest::newRow("100 rules") << 100;
+    QTest::newRow("500 rules") << 500;
+}
+
+void BenchmarkRules::evaluateEvent()
+{
+    QFETCH(int, ruleCount);
+
+    addRules(ruleCount);
+    QCOMPARE(NymeaCore::instance()->ruleEngine()->rules().count(), ruleCount);
+
+    Event event(mockEvent1EventTypeId, m_mockThingId);
+    QBENCHMARK {
+        NymeaCore::instance()->ruleEngine()->evaluateEvent(event);
+    }
+}
+
+#include "benchmarkrules.moc"
+QTEST_MAIN(BenchmarkRules)
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright (C) 2013 - 2024, nymea GmbH
+* Copyright (C) 2024 - 2026, chargebyte austria GmbH
+*
+* This file is part of nymea.
+*
+* nymea is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* nymea is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with nymea. If not, see <https://www.gnu.org/licenses/>.
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "nymeabenchmarkbase.h"
+#include "nymeacore.h"
+#include "integrations/thingmanager.h"
+
+#include "../plugins/mock/extern-plugininfo.h"
+
+using namespace nymeaserver;
+
+class BenchmarkThings : public NymeaBenchmarkBase
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void setStateValue_data();
+    void setStateValue();
+};
+
+void BenchmarkThings::initTestCase()
+{
+    NymeaTestBase::initTestCase("*.debug=false\n"
+                                "Tests.debug=true\n");
+}
+
+void BenchmarkThings::setStateValue_data()
+{
+    QTest::addColumn<int>("thingCount");
+    QTest::addColumn<int>("clientCount");
+
+    // Clients stay connected once added, keep the rows sorted by client count
+    QTest::newRow("1 thing, no clients") << 1 << 0;
+    QTest::newRow("1 thing, 10 clients") << 1 << 10;
+    QTest::newRow("100 things, 10 clients") << 100 << 10;
+    QTest::newRow("1 thing, 100 clients") << 1 << 100;
+}
+
+void BenchmarkThings::setStateValue()
+{
+    QFETCH(int, thingCount);
+    QFETCH(int, clientCount);
+
+    QList<Thing *> things;
+    foreach (const ThingId &thingId, addSensors(thingCount)) {
+        things.append(NymeaCore::instance()->thingManager()->findConfiguredThing(thingId));
+    }
+    QCOMPARE(things.count(), thingCount);
+    QCOMPARE(connectClients(clientCount, {"Integrations"}).count(), clientCount);
+
+    // Includes the state change event, rule evaluation, logging and the notification fan-out to all clients
+    double temperature = 20;
+    QBENCHMARK {
+        temperature = temperature > 30 ? 20 : temperature + 0.5;
+        foreach (Thing *thing, things) {
+            thing->setStateValue(virtualIoTemperatureSensorMockTemperatureStateTypeId, temperature);
+        }
+        QCoreApplication::processEvents();
+    }
+}
+
+#include "benchmarkthings.moc"
+QTEST_MAIN(BenchmarkThings)
@@ -0,0 +1,5 @@
+include(../../../nymea.pri)
+include(../benchmarks.pri)
+
+TARGET = nymeabenchmarkthings
+SOURCES += benchmarkthings.cpp
@@ -1,4 +1,5 @@
 TEMPLATE = subdirs
 
-SUBDIRS = libnymea-tests auto tools/simplepushbuttonhandler
+SUBDIRS = libnymea-tests auto benchmarks tools/simplepushbuttonhandler
 auto.depends += libnymea-tests
+benchmarks.depends += libnymea-tests